@@ -0,0 +1,161 @@
+#include "alert_dispatcher.hpp"
+#include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <libtorrent/settings_pack.hpp>
+
+AlertDispatcher::AlertDispatcher(lt::session& session)
+    : session_(session)
+    , table_(std::make_shared<const SubscriptionTable>())
+    , base_mask_(lt::alert::error_notification)
+    , applied_mask_(lt::alert_category_t::all())
+    , next_id_(1)
+    , pending_(true)
+    , stopping_(false)
+{
+}
+
+AlertDispatcher::~AlertDispatcher()
+{
+    stop();
+}
+
+void AlertDispatcher::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (thread_.joinable()) {
+            return;
+        }
+        stopping_ = false;
+        pending_ = true;  // 启动前已产生的 alert 也要取出
+        update_alert_mask_unsafe();
+        thread_ = std::thread(&AlertDispatcher::dispatch_loop, this);
+    }
+
+    // libtorrent 在 alert 队列由空变为非空时调用（在 libtorrent 的网络线程中，持有其内部锁），这里只唤醒分发线程
+    // 注册时不能持有 mutex_，否则与回调中的加锁顺序相反
+    session_.set_alert_notify([this] {
+        {
+            std::lock_guard<std::mutex> notify_lock(mutex_);
+            pending_ = true;
+        }
+        alerts_ready_.notify_one();
+    });
+}
+
+void AlertDispatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+    }
+    session_.set_alert_notify(std::function<void()>());
+    alerts_ready_.notify_one();
+    thread_.join();
+}
+
+int AlertDispatcher::subscribe(int alert_type, lt::alert_category_t category, Handler handler)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto table = std::make_shared<SubscriptionTable>(*table_);
+    int id = next_id_++;
+    (*table)[alert_type].push_back(Subscription{id, category, std::move(handler)});
+    table_ = std::move(table);
+    update_alert_mask_unsafe();
+    return id;
+}
+
+void AlertDispatcher::unsubscribe(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto table = std::make_shared<SubscriptionTable>(*table_);
+    for (auto it = table->begin(); it != table->end(); ) {
+        auto& subs = it->second;
+        subs.erase(std::remove_if(subs.begin(), subs.end(),
+                                  [id](const Subscription& s) { return s.id == id; }),
+                   subs.end());
+        it = subs.empty() ? table->erase(it) : std::next(it);
+    }
+    table_ = std::move(table);
+    update_alert_mask_unsafe();
+}
+
+void AlertDispatcher::set_base_mask(lt::alert_category_t mask)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    base_mask_ = mask;
+    update_alert_mask_unsafe();
+}
+
+void AlertDispatcher::set_batch_handler(std::function<void()> handler)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_handler_ = std::move(handler);
+}
+
+void AlertDispatcher::update_alert_mask_unsafe()
+{
+    lt::alert_category_t mask = base_mask_;
+    for (const auto& pair : *table_) {
+        for (const auto& sub : pair.second) {
+            mask |= sub.category;
+        }
+    }
+    if (mask == applied_mask_) {
+        return;
+    }
+    try {
+        lt::settings_pack settings;
+        settings.set_int(lt::settings_pack::alert_mask, mask);
+        session_.apply_settings(std::move(settings));
+        applied_mask_ = mask;
+    } catch (const std::exception& e) {
+        std::cerr << "设置 alert_mask 失败: " << e.what() << std::endl;
+    }
+}
+
+void AlertDispatcher::dispatch_loop()
+{
+    std::vector<lt::alert*> alerts;
+    while (true) {
+        std::shared_ptr<const SubscriptionTable> table;
+        std::function<void()> batch_handler;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            alerts_ready_.wait(lock, [this] { return pending_ || stopping_; });
+            if (stopping_) {
+                return;
+            }
+            pending_ = false;
+            table = table_;
+            batch_handler = batch_handler_;
+        }
+
+        // 一次取出所有 alert；下一次 pop_alerts 之前这些 alert 一直有效
+        session_.pop_alerts(&alerts);
+        for (lt::alert* alert : alerts) {
+            auto it = table->find(alert->type());
+            if (it == table->end()) {
+                continue;
+            }
+            for (const auto& sub : it->second) {
+                try {
+                    sub.handler(alert);
+                } catch (const std::exception& e) {
+                    std::cerr << "处理 " << alert->what() << " 时出错: " << e.what() << std::endl;
+                }
+            }
+        }
+        if (batch_handler && !alerts.empty()) {
+            try {
+                batch_handler();
+            } catch (const std::exception& e) {
+                std::cerr << "处理 alert 批次时出错: " << e.what() << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef ALERT_DISPATCHER_HPP
+#define ALERT_DISPATCHER_HPP
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include <libtorrent/session.hpp>
+#include <libtorrent/alert.hpp>
+
+// Alert 分发器
+// 独立的分发线程由 session 的 set_alert_notify 唤醒：有新 alert 时立即取出并按类型调用已订阅的处理函数，
+// 空闲时线程一直阻塞，不再按固定间隔轮询
+// session 的 alert_mask 只包含已订阅 alert 所属的类别，其余 alert 不再产生
+class AlertDispatcher
+{
+public:
+    // 处理函数（在分发线程中调用，alert 仅在调用期间有效）
+    using Handler = std::function<void(lt::alert*)>;
+
+    // session 必须在分发器之后销毁
+    explicit AlertDispatcher(lt::session& session);
+    ~AlertDispatcher();
+
+    AlertDispatcher(const AlertDispatcher&) = delete;
+    AlertDispatcher& operator=(const AlertDispatcher&) = delete;
+
+    // 启动分发线程
+    void start();
+
+    // 停止分发线程（等待正在执行的处理函数返回，不能在处理函数中调用）
+    void stop();
+
+    // 订阅指定类型的 alert（alert_type 为 lt::xxx_alert::alert_type，category 加入 session 的 alert_mask）
+    // 返回: 订阅 ID（用于取消订阅）
+    int subscribe(int alert_type, lt::alert_category_t category, Handler handler);
+
+    // 按 alert 类型订阅，例如 subscribe<lt::torrent_finished_alert>([](const lt::torrent_finished_alert& a) { ... })
+    template <class AlertT>
+    int subscribe(std::function<void(const AlertT&)> handler)
+    {
+        return subscribe(AlertT::alert_type, AlertT::static_category,
+                         [handler](lt::alert* a) { handler(*static_cast<const AlertT*>(a)); });
+    }
+
+    // 取消订阅（正在分发的一批 alert 仍可能调用该处理函数）
+    void unsubscribe(int id);
+
+    // 设置额外的 alert 类别（不订阅也需要产生的 alert）
+    void set_base_mask(lt::alert_category_t mask);
+
+    // 设置每批 alert 分发完成后调用的函数（在分发线程中调用，用于合并一批 alert 的结果后统一处理）
+    void set_batch_handler(std::function<void()> handler);
+
+private:
+    // 单个订阅
+    struct Subscription {
+        int id;
+        lt::alert_category_t category;
+        Handler handler;
+    };
+    // 按 alert 类型索引的订阅表（发布后不再修改，分发线程无需加锁即可读取）
+    using SubscriptionTable = std::map<int, std::vector<Subscription>>;
+
+    // 分发线程
+    void dispatch_loop();
+
+    // 根据订阅表更新 session 的 alert_mask（仅在已持有 mutex_ 时调用）
+    void update_alert_mask_unsafe();
+
+private:
+    lt::session& session_;                                  // libtorrent 会话
+    mutable std::mutex mutex_;                              // 保护以下成员
+    std::condition_variable alerts_ready_;                  // 有新 alert 或停止时通知
+    std::shared_ptr<const SubscriptionTable> table_;        // 当前订阅表（修改时整体替换）
+    std::function<void()> batch_handler_;                   // 每批 alert 分发完成后调用
+    lt::alert_category_t base_mask_;                        // 额外的 alert 类别
+    lt::alert_category_t applied_mask_;                     // 已应用到 session 的 alert_mask
+    int next_id_;                                           // 下一个订阅 ID
+    bool pending_;                                          // 是否有待取出的 alert
+    bool stopping_;                                         // 是否正在停止
+    std::thread thread_;                                    // 分发线程
+};
+
+#endif // ALERT_DISPATCHER_HPP
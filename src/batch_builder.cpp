@@ -0,0 +1,415 @@
+#include "batch_builder.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <sys/stat.h>
+#include <climits>
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+#endif
+
+namespace {
+
+// 单个任务的结果
+struct JobResult {
+    bool skipped = false;        // 已存在，跳过
+    bool ok = false;             // 生成成功
+    std::int64_t bytes = 0;      // 数据大小
+    double seconds = 0.0;        // 用时
+    std::int64_t hashed = 0;     // 已计算哈希的字节数（进行中的任务）
+    std::int64_t to_hash = 0;    // 需要计算哈希的字节数（进行中的任务）
+};
+
+// 每块磁盘的统计
+struct DiskStats {
+    std::int64_t bytes = 0;
+    std::chrono::steady_clock::time_point first_start;
+    std::chrono::steady_clock::time_point last_end;
+    bool started = false;
+};
+
+double mb_per_second(std::int64_t bytes, double seconds)
+{
+    return seconds > 0 ? bytes / 1024.0 / 1024.0 / seconds : 0.0;
+}
+
+double to_gb(std::int64_t bytes)
+{
+    return bytes / 1024.0 / 1024.0 / 1024.0;
+}
+
+// 清除当前的进度行（进度行以 \r 覆盖输出，其他信息输出前先清除）
+void clear_progress_line()
+{
+    std::cout << "\r" << std::string(79, ' ') << "\r";
+}
+
+#ifdef _WIN32
+std::wstring to_wide(const std::string& text)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, NULL, 0);
+    if (len <= 0) return std::wstring();
+    std::vector<wchar_t> buffer(len);
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, buffer.data(), len);
+    return std::wstring(buffer.data());
+}
+
+std::string to_utf8(const std::wstring& text)
+{
+    int len = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, NULL, 0, NULL, NULL);
+    if (len <= 0) return std::string();
+    std::vector<char> buffer(len);
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, buffer.data(), len, NULL, NULL);
+    return std::string(buffer.data());
+}
+#endif
+
+} // namespace
+
+BatchBuilder::BatchBuilder(const TorrentBuilder& prototype)
+    : prototype_(prototype)
+    , jobs_per_disk_(1)
+    , max_jobs_(0)
+    , force_(false)
+{
+}
+
+bool BatchBuilder::load_manifest(const std::string& manifest_path, const std::string& output_dir)
+{
+    namespace fs = std::filesystem;
+
+    std::ifstream in(fs::u8path(manifest_path));
+    if (!in.is_open()) {
+        std::cerr << "错误: 无法打开清单文件: " << manifest_path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        size_t start = line.find_first_not_of(' ');
+        if (start == std::string::npos || line[start] == '#') continue;
+        line = line.substr(start);
+
+        std::string input_path = line;
+        std::string output_path;
+        size_t tab = line.find('\t');
+        if (tab != std::string::npos) {
+            input_path = line.substr(0, tab);
+            output_path = line.substr(tab + 1);
+        }
+        if (output_path.empty()) {
+            std::string normalized = input_path;
+            while (!normalized.empty() && (normalized.back() == '/' || normalized.back() == '\\')) normalized.pop_back();
+            output_path = (fs::u8path(output_dir) / (fs::u8path(normalized).filename().u8string() + ".torrent")).u8string();
+        }
+        add_job(input_path, output_path);
+    }
+    std::cout << "清单: " << manifest_path << "，共 " << jobs_.size() << " 个镜像" << std::endl;
+    return true;
+}
+
+bool BatchBuilder::load_directory(const std::string& library_path, const std::string& output_dir)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::path library = fs::u8path(library_path);
+    if (!fs::is_directory(library, ec)) {
+        std::cerr << "错误: 镜像库目录不存在: " << library_path << std::endl;
+        return false;
+    }
+
+    // 按名称排序，使任务顺序与目录枚举顺序无关
+    std::vector<fs::path> entries;
+    for (fs::directory_iterator it(library, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().u8string();
+        if (name.empty() || name[0] == '.') continue;
+        std::string extension = it->path().extension().u8string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        if (extension == ".torrent" || extension == ".resume" || extension == ".hashcache" || extension == ".tmp") continue;
+        entries.push_back(it->path());
+    }
+    if (ec) {
+        std::cerr << "错误: 无法读取镜像库目录: " << library_path << " (" << ec.message() << ")" << std::endl;
+        return false;
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (const auto& entry : entries) {
+        add_job(entry.u8string(), (fs::u8path(output_dir) / (entry.filename().u8string() + ".torrent")).u8string());
+    }
+    std::cout << "镜像库: " << library_path << "，共 " << jobs_.size() << " 个镜像" << std::endl;
+    return true;
+}
+
+void BatchBuilder::add_job(const std::string& input_path, const std::string& output_path)
+{
+    BatchJob job;
+    job.input_path = input_path;
+    job.output_path = output_path;
+    job.disk = disk_of(input_path);
+    jobs_.push_back(std::move(job));
+}
+
+std::string BatchBuilder::disk_of(const std::string& path)
+{
+#ifdef _WIN32
+    std::wstring wide_path = to_wide(path);
+    wchar_t volume_path[MAX_PATH] = {};
+    if (!GetVolumePathNameW(wide_path.c_str(), volume_path, MAX_PATH)) {
+        return "unknown";
+    }
+
+    // 通过卷的磁盘区段找到物理磁盘（同一磁盘上的多个分区共享 I/O 队列）
+    wchar_t volume_name[MAX_PATH] = {};
+    if (GetVolumeNameForVolumeMountPointW(volume_path, volume_name, MAX_PATH)) {
+        std::wstring device = volume_name;
+        if (!device.empty() && device.back() == L'\\') device.pop_back();
+        HANDLE handle = CreateFileW(device.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+        if (handle != INVALID_HANDLE_VALUE) {
+            VOLUME_DISK_EXTENTS extents = {};
+            DWORD bytes_returned = 0;
+            BOOL ok = DeviceIoControl(handle, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, NULL, 0,
+                                      &extents, sizeof(extents), &bytes_returned, NULL);
+            CloseHandle(handle);
+            if (ok && extents.NumberOfDiskExtents > 0) {
+                return "PhysicalDrive" + std::to_string(extents.Extents[0].DiskNumber);
+            }
+        }
+    }
+    return to_utf8(volume_path);
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return "unknown";
+    }
+#ifdef __linux__
+    // /sys/dev/block/<主设备号>:<次设备号> 指向分区时，其父目录为所在的物理磁盘
+    std::string sys_path = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    char resolved[PATH_MAX];
+    if (::realpath(sys_path.c_str(), resolved)) {
+        std::filesystem::path device(resolved);
+        std::error_code ec;
+        if (std::filesystem::exists(device / "partition", ec)) {
+            device = device.parent_path();
+        }
+        return device.filename().string();
+    }
+#endif
+    return "dev" + std::to_string(static_cast<unsigned long long>(st.st_dev));
+#endif
+}
+
+int BatchBuilder::run()
+{
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+
+    const int total_jobs = static_cast<int>(jobs_.size());
+    std::vector<JobResult> results(jobs_.size());
+
+    // 按物理磁盘分组，跳过已生成的镜像
+    std::map<std::string, std::deque<int>> queues;
+    int pending = 0;
+    for (int i = 0; i < total_jobs; ++i) {
+        std::error_code ec;
+        if (!force_ && fs::exists(fs::u8path(jobs_[i].output_path), ec)) {
+            results[i].skipped = true;
+            continue;
+        }
+        queues[jobs_[i].disk].push_back(i);
+        ++pending;
+    }
+    const int skipped = total_jobs - pending;
+    if (skipped > 0) {
+        std::cout << "跳过已生成的 torrent: " << skipped << " 个（使用 --force 重新生成）" << std::endl;
+    }
+    if (pending == 0) {
+        std::cout << "没有需要生成的镜像" << std::endl;
+        return 0;
+    }
+
+    // 每块磁盘最多 jobs_per_disk_ 个并行任务，所有磁盘合计不超过 max_jobs_
+    const int per_disk = std::max(1, jobs_per_disk_);
+    int concurrency = 0;
+    for (const auto& queue : queues) {
+        concurrency += std::min(per_disk, static_cast<int>(queue.second.size()));
+    }
+    if (max_jobs_ > 0) {
+        concurrency = std::min(concurrency, max_jobs_);
+    }
+
+    // 哈希线程在同时进行的任务之间平均分配
+    int hash_threads = prototype_.hash_threads();
+    if (hash_threads <= 0) {
+        hash_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / concurrency);
+    }
+
+    std::cout << "批量生成: " << pending << " 个镜像，分布在 " << queues.size() << " 块磁盘上" << std::endl;
+    for (const auto& queue : queues) {
+        std::cout << "  磁盘 " << queue.first << ": " << queue.second.size() << " 个镜像" << std::endl;
+    }
+    std::cout << "并行任务: " << concurrency << "（每块磁盘 " << per_disk << " 个），每个任务 "
+              << hash_threads << " 个哈希线程" << std::endl;
+    std::cout << std::endl;
+
+    std::mutex mutex;
+    std::condition_variable slot_freed;
+    std::condition_variable finished_changed;
+    int running = 0;
+    int finished = 0;
+    std::int64_t finished_bytes = 0;
+    std::map<std::string, DiskStats> disk_stats;
+    const auto batch_start = clock::now();
+
+    auto worker = [&](const std::string& disk, std::deque<int>& queue) {
+        while (true) {
+            int index = -1;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (queue.empty()) return;
+                // 全局并行上限：等待其他磁盘上的任务让出位置
+                slot_freed.wait(lock, [&] { return max_jobs_ <= 0 || running < max_jobs_; });
+                if (queue.empty()) return;
+                index = queue.front();
+                queue.pop_front();
+                ++running;
+                DiskStats& stats = disk_stats[disk];
+                if (!stats.started) {
+                    stats.first_start = clock::now();
+                    stats.started = true;
+                }
+            }
+
+            const BatchJob& job = jobs_[index];
+            TorrentBuilder builder(prototype_);
+            builder.set_hash_threads(hash_threads);
+            // 多个任务并行时各自的输出会交错，只保留错误输出，进度由主线程汇总成一行
+            builder.set_quiet(true);
+            builder.set_progress([&mutex, &results, index](std::int64_t done, std::int64_t total) {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[index].hashed = done;
+                results[index].to_hash = total;
+            });
+
+            std::error_code ec;
+            fs::path output_parent = fs::u8path(job.output_path).parent_path();
+            if (!output_parent.empty()) {
+                fs::create_directories(output_parent, ec);
+            }
+
+            const auto start = clock::now();
+            bool ok = builder.create_torrent(job.input_path, job.output_path);
+            const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            slot_freed.notify_all();
+
+            JobResult& result = results[index];
+            result.ok = ok;
+            result.bytes = ok ? builder.last_total_size() : 0;
+            result.seconds = seconds;
+            result.hashed = 0;
+            result.to_hash = 0;
+            ++finished;
+            finished_bytes += result.bytes;
+            DiskStats& stats = disk_stats[disk];
+            stats.bytes += result.bytes;
+            stats.last_end = clock::now();
+
+            clear_progress_line();
+            if (ok) {
+                char line[128];
+                std::snprintf(line, sizeof(line), "%.1f GB，%.1f 秒，%.1f MB/s", to_gb(result.bytes), seconds,
+                              mb_per_second(result.bytes, seconds));
+                std::cout << "[" << finished << "/" << pending << "] 完成: " << job.input_path << " ("
+                          << line << "，磁盘 " << disk << ")" << std::endl;
+            } else {
+                std::cout << std::flush;
+                std::cerr << "[" << finished << "/" << pending << "] 失败: " << job.input_path << std::endl;
+            }
+            finished_changed.notify_all();
+        }
+    };
+
+    // 每块磁盘启动 min(jobs_per_disk, 镜像数) 个工作线程，各自从该磁盘的队列中取任务
+    std::vector<std::thread> threads;
+    for (auto& queue : queues) {
+        int workers = std::min(per_disk, static_cast<int>(queue.second.size()));
+        for (int w = 0; w < workers; ++w) {
+            threads.emplace_back(worker, queue.first, std::ref(queue.second));
+        }
+    }
+
+    // 每 500 毫秒输出一行汇总进度（覆盖上一行）：完成数、进行中的任务、已计算的数据量和总吞吐量
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finished_changed.wait_for(lock, std::chrono::milliseconds(500), [&] { return finished == pending; })) {
+            std::int64_t hashed = 0;
+            std::int64_t to_hash = 0;
+            for (const auto& result : results) {
+                hashed += result.hashed;
+                to_hash += result.to_hash;
+            }
+            const double elapsed = std::chrono::duration<double>(clock::now() - batch_start).count();
+            char line[160];
+            std::snprintf(line, sizeof(line), "[%d/%d] 进行中 %d 个，哈希 %.1f / %.1f GB，总吞吐量 %.1f MB/s",
+                          finished, pending, running, to_gb(hashed), to_gb(to_hash),
+                          mb_per_second(finished_bytes + hashed, elapsed));
+            std::cout << "\r" << line << std::flush;
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const double total_seconds = std::chrono::duration<double>(clock::now() - batch_start).count();
+    int failed = 0;
+    for (const auto& result : results) {
+        if (!result.skipped && !result.ok) ++failed;
+    }
+
+    char line[160];
+    std::cout << std::endl;
+    std::cout << "=== 批量生成完成 ===" << std::endl;
+    std::cout << "成功: " << (pending - failed) << "，失败: " << failed << "，跳过: " << skipped << std::endl;
+    std::snprintf(line, sizeof(line), "数据总量: %.1f GB，用时 %.1f 秒，总吞吐量: %.1f MB/s", to_gb(finished_bytes),
+                  total_seconds, mb_per_second(finished_bytes, total_seconds));
+    std::cout << line << std::endl;
+    for (const auto& item : disk_stats) {
+        const double seconds = std::chrono::duration<double>(item.second.last_end - item.second.first_start).count();
+        std::snprintf(line, sizeof(line), "%.1f GB，%.1f MB/s", to_gb(item.second.bytes),
+                      mb_per_second(item.second.bytes, seconds));
+        std::cout << "  磁盘 " << item.first << ": " << line << std::endl;
+    }
+    if (failed > 0) {
+        std::cerr << "失败的镜像:" << std::endl;
+        for (int i = 0; i < total_jobs; ++i) {
+            if (!results[i].skipped && !results[i].ok) {
+                std::cerr << "  " << jobs_[i].input_path << std::endl;
+            }
+        }
+    }
+    return failed;
+}
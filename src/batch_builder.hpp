@@ -0,0 +1,64 @@
+#ifndef BATCH_BUILDER_HPP
+#define BATCH_BUILDER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "torrent_builder.hpp"
+
+// 批量生成中的一个镜像
+struct BatchJob {
+    std::string input_path;    // 镜像文件或目录
+    std::string output_path;   // 输出的 torrent 文件
+    std::string disk;          // 所在物理磁盘（同一磁盘上的任务共享 I/O 队列）
+};
+
+// 镜像库批量生成器
+// 按物理磁盘对任务分组：每块磁盘最多同时生成 jobs_per_disk 个 torrent（保持该磁盘的最佳队列深度），
+// 不同磁盘上的镜像并行生成；哈希线程在所有同时进行的任务之间平均分配
+// 输出文件通过临时文件替换写入，已存在的 torrent 即为完整结果：中断后重新运行会跳过已完成的镜像
+class BatchBuilder
+{
+public:
+    // prototype: 每个任务使用的生成器配置（tracker、协议版本、哈希缓存等）
+    explicit BatchBuilder(const TorrentBuilder& prototype);
+
+    // 设置每块磁盘同时生成的任务数（默认 1，机械硬盘建议 1，SSD/NVMe 可适当增大）
+    inline void set_jobs_per_disk(int jobs) { jobs_per_disk_ = jobs; }
+
+    // 设置所有磁盘合计的最大并行任务数，0 表示不限制
+    inline void set_max_jobs(int jobs) { max_jobs_ = jobs; }
+
+    // 设置是否重新生成已存在的 torrent（默认跳过，用于中断后继续）
+    inline void set_force(bool force) { force_ = force; }
+
+    // 从清单文件加载任务：每行 "<镜像路径>[<TAB><输出路径>]"，# 开头为注释
+    // 未指定输出路径时输出到 output_dir/<镜像名>.torrent
+    bool load_manifest(const std::string& manifest_path, const std::string& output_dir);
+
+    // 从镜像库目录加载任务：目录下的每个文件或子目录作为一个镜像（跳过隐藏项和 torrent 相关文件）
+    bool load_directory(const std::string& library_path, const std::string& output_dir);
+
+    // 生成所有任务
+    // 返回: 失败的任务数量
+    int run();
+
+    // 已加载的任务
+    inline const std::vector<BatchJob>& jobs() const { return jobs_; }
+
+private:
+    // 添加任务并确定镜像所在的物理磁盘
+    void add_job(const std::string& input_path, const std::string& output_path);
+
+    // 获取路径所在的物理磁盘标识（无法确定时返回卷标识）
+    static std::string disk_of(const std::string& path);
+
+private:
+    TorrentBuilder prototype_;     // 生成器配置
+    std::vector<BatchJob> jobs_;   // 任务列表
+    int jobs_per_disk_;            // 每块磁盘的并行任务数
+    int max_jobs_;                 // 最大并行任务数（0 表示不限制）
+    bool force_;                   // 是否重新生成已存在的 torrent
+};
+
+#endif // BATCH_BUILDER_HPP
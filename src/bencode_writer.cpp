@@ -0,0 +1,133 @@
+#include "bencode_writer.hpp"
+#include <cstring>
+#include <algorithm>
+
+BencodeWriter::BencodeWriter(std::ostream& out, size_t buffer_size)
+    : out_(out)
+    , buffer_(std::max<size_t>(buffer_size, 64))
+    , used_(0)
+    , hash_begin_(0)
+    , in_info_(false)
+    , hash_v1_(false)
+    , hash_v2_(false)
+    , bytes_written_(0)
+{
+}
+
+bool BencodeWriter::write_torrent(const lt::entry& torrent_entry, bool v1, bool v2)
+{
+    hash_v1_ = v1;
+    hash_v2_ = v2;
+    info_hashes_ = lt::info_hash_t();
+
+    if (torrent_entry.type() != lt::entry::dictionary_t) {
+        write_entry(torrent_entry);
+    } else {
+        // 顶层字典单独展开，以便识别 info 值的起止位置
+        put('d');
+        for (const auto& item : torrent_entry.dict()) {
+            write_string(item.first.data(), item.first.size());
+            if (item.first == "info") {
+                hash_begin_ = used_;
+                in_info_ = true;
+                write_entry(item.second);
+                hash_pending();
+                in_info_ = false;
+                if (hash_v1_) info_hashes_.v1 = lt::sha1_hash(hasher_v1_.final());
+                if (hash_v2_) info_hashes_.v2 = lt::sha256_hash(hasher_v2_.final());
+            } else {
+                write_entry(item.second);
+            }
+        }
+        put('e');
+    }
+
+    flush();
+    out_.flush();
+    return static_cast<bool>(out_);
+}
+
+void BencodeWriter::write_entry(const lt::entry& e)
+{
+    switch (e.type()) {
+    case lt::entry::int_t:
+        put('i');
+        write_integer(e.integer());
+        put('e');
+        break;
+    case lt::entry::string_t:
+        write_string(e.string().data(), e.string().size());
+        break;
+    case lt::entry::list_t:
+        put('l');
+        for (const auto& item : e.list()) {
+            write_entry(item);
+        }
+        put('e');
+        break;
+    case lt::entry::dictionary_t:
+        // entry 的字典按键排序，与 lt::bencode 的输出一致
+        put('d');
+        for (const auto& item : e.dict()) {
+            write_string(item.first.data(), item.first.size());
+            write_entry(item.second);
+        }
+        put('e');
+        break;
+    case lt::entry::preformatted_t:
+        put(e.preformatted().data(), e.preformatted().size());
+        break;
+    default:
+        // 未定义的 entry 按 lt::bencode 的方式编码为空字符串
+        put("0:", 2);
+        break;
+    }
+}
+
+void BencodeWriter::write_string(const char* data, size_t size)
+{
+    write_integer(static_cast<std::int64_t>(size));
+    put(':');
+    put(data, size);
+}
+
+void BencodeWriter::write_integer(std::int64_t value)
+{
+    std::string text = std::to_string(value);
+    put(text.data(), text.size());
+}
+
+void BencodeWriter::put(const char* data, size_t size)
+{
+    while (size > 0) {
+        if (used_ == buffer_.size()) {
+            flush();
+        }
+        size_t count = std::min(size, buffer_.size() - used_);
+        std::memcpy(buffer_.data() + used_, data, count);
+        used_ += count;
+        data += count;
+        size -= count;
+    }
+}
+
+void BencodeWriter::hash_pending()
+{
+    if (!in_info_ || used_ <= hash_begin_) return;
+    const char* begin = buffer_.data() + hash_begin_;
+    const int size = static_cast<int>(used_ - hash_begin_);
+    if (hash_v1_) hasher_v1_.update(begin, size);
+    if (hash_v2_) hasher_v2_.update(begin, size);
+    hash_begin_ = used_;
+}
+
+void BencodeWriter::flush()
+{
+    hash_pending();
+    if (used_ > 0) {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+        bytes_written_ += static_cast<std::int64_t>(used_);
+    }
+    used_ = 0;
+    hash_begin_ = 0;
+}
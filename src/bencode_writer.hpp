@@ -0,0 +1,67 @@
+#ifndef BENCODE_WRITER_HPP
+#define BENCODE_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <libtorrent/entry.hpp>
+#include <libtorrent/hasher.hpp>
+#include <libtorrent/info_hash.hpp>
+
+// 流式 bencode 编码器
+// 将 entry 一次编码直接写入输出流（固定大小缓冲区，内存占用与 torrent 大小无关）
+// 编码顶层字典的 "info" 值时，同时对经过的字节计算 v1 (SHA1) / v2 (SHA256) info hash，无需再次编码
+class BencodeWriter
+{
+public:
+    // out: 输出流（需在 BencodeWriter 生命周期内有效）
+    // buffer_size: 写缓冲区大小（字节）
+    explicit BencodeWriter(std::ostream& out, size_t buffer_size = 1024 * 1024);
+
+    // 编码完整的 torrent 字典并写入输出流
+    // v1 / v2: 是否计算对应版本的 info hash
+    // 失败（写入出错）时返回 false
+    bool write_torrent(const lt::entry& torrent_entry, bool v1, bool v2);
+
+    // 获取 info 字典的哈希（write_torrent 之后有效）
+    inline const lt::info_hash_t& info_hashes() const { return info_hashes_; }
+
+    // 获取已写入的字节数
+    inline std::int64_t bytes_written() const { return bytes_written_; }
+
+private:
+    // 递归编码一个 entry
+    void write_entry(const lt::entry& e);
+
+    // 编码字符串（长度前缀 + 内容）
+    void write_string(const char* data, size_t size);
+
+    // 编码整数（不含 i/e 标记）
+    void write_integer(std::int64_t value);
+
+    // 追加原始字节到缓冲区，缓冲区满时写出
+    void put(const char* data, size_t size);
+    inline void put(char c) { put(&c, 1); }
+
+    // 对缓冲区中属于 info 字典的部分计算哈希
+    void hash_pending();
+
+    // 写出缓冲区内容
+    void flush();
+
+private:
+    std::ostream& out_;                 // 输出流
+    std::vector<char> buffer_;          // 写缓冲区
+    size_t used_;                       // 缓冲区已使用的字节数
+    size_t hash_begin_;                 // 缓冲区中尚未计算哈希的 info 字节起始位置
+    bool in_info_;                      // 当前是否正在编码 info 字典
+    bool hash_v1_;                      // 是否计算 SHA1 info hash
+    bool hash_v2_;                      // 是否计算 SHA256 info hash
+    lt::hasher hasher_v1_;              // SHA1 哈希器
+    lt::hasher256 hasher_v2_;           // SHA256 哈希器
+    lt::info_hash_t info_hashes_;       // info 字典的哈希
+    std::int64_t bytes_written_;        // 已写入的字节数
+};
+
+#endif // BENCODE_WRITER_HPP
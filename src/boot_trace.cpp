@@ -0,0 +1,123 @@
+#include "boot_trace.hpp"
+#include <iostream>
+#include <sstream>
+#include <filesystem>
+#include <ctime>
+#include <cstdio>
+
+BootTraceRecorder::BootTraceRecorder()
+    : records_(0)
+{
+}
+
+BootTraceRecorder::~BootTraceRecorder()
+{
+    close();
+}
+
+bool BootTraceRecorder::open(const std::string& path, const std::string& info_hash)
+{
+    namespace fs = std::filesystem;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (out_.is_open()) {
+        out_.close();
+    }
+
+    std::error_code ec;
+    fs::path file_path = fs::u8path(path);
+    if (file_path.has_parent_path()) {
+        fs::create_directories(file_path.parent_path(), ec);
+    }
+    out_.open(file_path, std::ios::trunc);
+    if (!out_.is_open()) {
+        std::cerr << "错误: 无法创建启动跟踪文件: " << path << std::endl;
+        return false;
+    }
+    out_ << "# boot-trace " << info_hash << "\n";
+    out_ << "# 毫秒 偏移 长度\n";
+
+    path_ = path;
+    records_ = 0;
+    start_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void BootTraceRecorder::record(std::int64_t offset, std::int64_t length)
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!out_.is_open()) {
+        return;
+    }
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count();
+    out_ << ms << ' ' << offset << ' ' << length << '\n';
+    ++records_;
+}
+
+void BootTraceRecorder::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+std::size_t BootTraceRecorder::records() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+}
+
+std::string BootTraceRecorder::new_path_for(const std::string& torrent_path)
+{
+    std::time_t now = std::time(nullptr);
+    std::tm local_time{};
+#ifdef _WIN32
+    localtime_s(&local_time, &now);
+#else
+    localtime_r(&now, &local_time);
+#endif
+    char name[64];
+    std::strftime(name, sizeof(name), "boot-%Y%m%d-%H%M%S.trace", &local_time);
+    return (std::filesystem::u8path(dir_for(torrent_path)) / name).u8string();
+}
+
+bool BootTraceRecorder::load(const std::string& path, std::string& info_hash, std::vector<BootTraceRead>& reads)
+{
+    std::ifstream in(std::filesystem::u8path(path));
+    if (!in.is_open()) {
+        std::cerr << "错误: 无法打开启动跟踪文件: " << path << std::endl;
+        return false;
+    }
+
+    info_hash.clear();
+    reads.clear();
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty() || line[0] == '\r') {
+            continue;
+        }
+        if (line[0] == '#') {
+            const std::string prefix = "# boot-trace ";
+            if (line_number == 1 && line.compare(0, prefix.size(), prefix) == 0) {
+                std::istringstream header(line.substr(prefix.size()));
+                header >> info_hash;
+            }
+            continue;
+        }
+
+        std::istringstream fields(line);
+        long long ms = 0;
+        BootTraceRead read;
+        if (!(fields >> ms >> read.offset >> read.length) || ms < 0 || read.offset < 0 || read.length <= 0) {
+            std::cerr << "警告: " << path << ":" << line_number << " 格式错误，已跳过: " << line << std::endl;
+            continue;
+        }
+        read.ms = static_cast<std::uint32_t>(ms);
+        reads.push_back(read);
+    }
+    return true;
+}
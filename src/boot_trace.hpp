@@ -0,0 +1,65 @@
+#ifndef BOOT_TRACE_HPP
+#define BOOT_TRACE_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+// 一次读取记录
+struct BootTraceRead {
+    std::uint32_t ms;                // 距开始记录的时间（毫秒）
+    std::int64_t offset;             // torrent 数据中的字节偏移
+    std::int64_t length;             // 读取长度（字节）
+};
+
+// 启动访问跟踪记录器：记录一次启动（或一次镜像使用）期间按时间顺序发生的读取
+// 跟踪文件为文本格式，第一行为 "# boot-trace <info_hash>"，之后每行 "<毫秒> <偏移> <长度>"，
+// 其他程序（如块设备驱动）也可以按此格式生成跟踪文件，交给 PrefetchProfile::compile 编译
+// 默认保存在 <torrent>.traces 目录中，每次启动一个文件
+class BootTraceRecorder
+{
+public:
+    BootTraceRecorder();
+    ~BootTraceRecorder();
+
+    BootTraceRecorder(const BootTraceRecorder&) = delete;
+    BootTraceRecorder& operator=(const BootTraceRecorder&) = delete;
+
+    // 开始记录（创建所在目录并写入文件头），时间从此刻开始计算
+    // 返回: 是否成功
+    bool open(const std::string& path, const std::string& info_hash);
+
+    // 记录一次读取（线程安全）
+    void record(std::int64_t offset, std::int64_t length);
+
+    // 结束记录并关闭文件
+    void close();
+
+    // 跟踪文件路径
+    inline const std::string& path() const { return path_; }
+
+    // 已记录的读取次数
+    std::size_t records() const;
+
+    // 获取 torrent 的默认跟踪目录
+    static inline std::string dir_for(const std::string& torrent_path) { return torrent_path + ".traces"; }
+
+    // 在默认跟踪目录中生成新的跟踪文件路径（按开始时间命名）
+    static std::string new_path_for(const std::string& torrent_path);
+
+    // 读取跟踪文件
+    // 返回: 是否成功（info_hash 为文件头中的值，没有文件头时为空）
+    static bool load(const std::string& path, std::string& info_hash, std::vector<BootTraceRead>& reads);
+
+private:
+    mutable std::mutex mutex_;                        // 保护以下成员
+    std::ofstream out_;                               // 跟踪文件
+    std::string path_;                                // 跟踪文件路径
+    std::chrono::steady_clock::time_point start_;     // 开始记录的时间
+    std::size_t records_;                             // 已记录的读取次数
+};
+
+#endif // BOOT_TRACE_HPP
@@ -0,0 +1,343 @@
+#include "directory_scanner.hpp"
+#include <iostream>
+#include <cstdio>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+// 待扫描的目录
+struct PendingDir {
+    std::filesystem::path path;   // 磁盘路径
+    std::string relative;         // torrent 中的相对路径
+};
+
+// 按路径逐级比较（/ 视为最小字符），使同一目录下的文件和子目录按名称排序
+bool path_less(const std::string& a, const std::string& b)
+{
+    const size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char ca = a[i] == '/' ? 0 : static_cast<unsigned char>(a[i]);
+        unsigned char cb = b[i] == '/' ? 0 : static_cast<unsigned char>(b[i]);
+        if (ca != cb) return ca < cb;
+    }
+    return a.size() < b.size();
+}
+
+// 读取文件属性
+void read_attributes(const std::filesystem::directory_entry& entry, ScannedFile& file)
+{
+#ifdef _WIN32
+    DWORD attrs = GetFileAttributesW(entry.path().c_str());
+    file.hidden = attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_HIDDEN) != 0;
+#else
+    std::error_code ec;
+    auto perms = entry.status(ec).permissions();
+    file.executable = !ec && (perms & std::filesystem::perms::owner_exec) != std::filesystem::perms::none;
+#endif
+}
+
+} // namespace
+
+DirectoryScanner::DirectoryScanner(const std::string& input_path)
+    : input_path_(input_path)
+    , threads_(0)
+    , quiet_(false)
+    , total_size_(0)
+    , boot_files_(0)
+{
+}
+
+bool DirectoryScanner::scan()
+{
+    namespace fs = std::filesystem;
+
+    files_.clear();
+    total_size_ = 0;
+
+    // 规范化路径：移除末尾的分隔符，转换为绝对路径
+    std::string normalized_path = input_path_;
+    while (!normalized_path.empty() && (normalized_path.back() == '\\' || normalized_path.back() == '/')) {
+        normalized_path.pop_back();
+    }
+    fs::path root = fs::u8path(normalized_path);
+    if (!root.is_absolute()) {
+        root = fs::absolute(root);
+    }
+    root = root.lexically_normal();
+
+    std::error_code ec;
+    fs::directory_entry root_entry(root, ec);
+    if (ec || !root_entry.exists(ec)) {
+        std::cerr << "错误: 路径不存在: " << input_path_ << std::endl;
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    // 单个文件：torrent 中的路径就是文件名
+    if (!root_entry.is_directory(ec)) {
+        ScannedFile file;
+        file.path = root.filename().u8string();
+        file.size = static_cast<std::int64_t>(root_entry.file_size(ec));
+        if (ec) {
+            std::cerr << "错误: 无法读取文件大小: " << input_path_ << " (" << ec.message() << ")" << std::endl;
+            return false;
+        }
+        auto write_time = root_entry.last_write_time(ec);
+        file.mtime = ec ? -1 : static_cast<std::int64_t>(write_time.time_since_epoch().count());
+        read_attributes(root_entry, file);
+        total_size_ = file.size;
+        files_.push_back(std::move(file));
+        return true;
+    }
+
+    int threads = threads_;
+    if (threads <= 0) {
+        threads = std::min(16, std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+    }
+    if (!quiet_) {
+        std::cout << "正在扫描目录（" << threads << " 个线程）: " << root.u8string() << std::endl;
+    }
+
+    // 目录工作队列：每个线程取出一个目录枚举，发现的子目录放回队列
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<PendingDir> queue;
+    int active = 0;                          // 正在枚举的目录数量
+    std::atomic<int> failed_dirs(0);         // 无法枚举的目录数量
+    std::vector<std::vector<ScannedFile>> results(threads);
+    queue.push_back(PendingDir{root, root.filename().u8string()});
+
+    auto worker = [&](int thread_index) {
+        std::vector<ScannedFile>& local = results[thread_index];
+        for (;;) {
+            PendingDir dir;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !queue.empty() || active == 0; });
+                if (queue.empty()) {
+                    return;
+                }
+                dir = std::move(queue.front());
+                queue.pop_front();
+                ++active;
+            }
+
+            std::vector<PendingDir> subdirs;
+            std::error_code dir_ec;
+            fs::directory_iterator it(dir.path, fs::directory_options::skip_permission_denied, dir_ec);
+            for (; !dir_ec && it != fs::directory_iterator(); it.increment(dir_ec)) {
+                const fs::directory_entry& entry = *it;
+                std::error_code entry_ec;
+                std::string relative = dir.relative + "/" + entry.path().filename().u8string();
+                if (entry.is_directory(entry_ec)) {
+                    // 不进入指向目录的符号链接，避免循环
+                    if (!entry.is_symlink(entry_ec)) {
+                        subdirs.push_back(PendingDir{entry.path(), std::move(relative)});
+                    }
+                } else if (entry.is_regular_file(entry_ec)) {
+                    ScannedFile file;
+                    file.path = std::move(relative);
+                    file.size = static_cast<std::int64_t>(entry.file_size(entry_ec));
+                    if (entry_ec) continue;
+                    auto write_time = entry.last_write_time(entry_ec);
+                    file.mtime = entry_ec ? -1 : static_cast<std::int64_t>(write_time.time_since_epoch().count());
+                    read_attributes(entry, file);
+                    local.push_back(std::move(file));
+                }
+            }
+            if (dir_ec) {
+                ++failed_dirs;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto& subdir : subdirs) {
+                    queue.push_back(std::move(subdir));
+                }
+                --active;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(worker, t);
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    // 合并并排序，结果与枚举顺序无关
+    size_t count = 0;
+    for (const auto& local : results) {
+        count += local.size();
+    }
+    files_.reserve(count);
+    for (auto& local : results) {
+        for (auto& file : local) {
+            total_size_ += file.size;
+            files_.push_back(std::move(file));
+        }
+    }
+    std::sort(files_.begin(), files_.end(), [](const ScannedFile& a, const ScannedFile& b) {
+        return path_less(a.path, b.path);
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    if (!quiet_) {
+        // 用 snprintf 格式化：多个生成任务可能同时输出，不修改 std::cout 的格式状态
+        char summary[128];
+        snprintf(summary, sizeof(summary), "%.2f 秒（%.0f 文件/秒）", seconds, seconds > 0 ? files_.size() / seconds : 0.0);
+        std::cout << "扫描完成: " << files_.size() << " 个文件，用时 " << summary << std::endl;
+    }
+    if (failed_dirs > 0) {
+        std::cerr << "警告: " << failed_dirs << " 个目录无法完整读取，其中的文件未包含在 torrent 中" << std::endl;
+    }
+    return true;
+}
+
+int DirectoryScanner::apply_access_order(const std::vector<std::string>& access_order)
+{
+    // 统一为小写、/ 分隔的路径，便于与跟踪记录中的路径比较
+    auto normalize = [](std::string path) {
+        std::replace(path.begin(), path.end(), '\\', '/');
+        std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        while (!path.empty() && path.back() == '/') path.pop_back();
+        return path;
+    };
+
+    // 以 torrent 中的相对路径和去掉顶层目录名后的路径建立索引
+    std::unordered_map<std::string, int> by_path;
+    for (int i = 0; i < static_cast<int>(files_.size()); ++i) {
+        std::string path = normalize(files_[i].path);
+        by_path.emplace(path, i);
+        size_t slash = path.find('/');
+        if (slash != std::string::npos) {
+            by_path.emplace(path.substr(slash + 1), i);
+        }
+    }
+
+    // 输入目录的绝对路径前缀（跟踪记录中的绝对路径去掉该前缀后按相对路径匹配）
+    std::string root_prefix;
+    {
+        namespace fs = std::filesystem;
+        std::string normalized_path = input_path_;
+        while (!normalized_path.empty() && (normalized_path.back() == '\\' || normalized_path.back() == '/')) {
+            normalized_path.pop_back();
+        }
+        fs::path root = fs::u8path(normalized_path);
+        if (!root.is_absolute()) {
+            root = fs::absolute(root);
+        }
+        root_prefix = normalize(root.lexically_normal().u8string()) + "/";
+    }
+
+    std::vector<char> placed(files_.size(), 0);
+    std::vector<int> order;
+    for (const auto& entry : access_order) {
+        std::string path = normalize(entry);
+        if (path.compare(0, root_prefix.size(), root_prefix) == 0) {
+            path = path.substr(root_prefix.size());
+        } else {
+            // 跟踪记录中的盘符路径（如 c:/windows/...）对应镜像根目录
+            if (path.size() >= 2 && path[1] == ':') path = path.substr(2);
+            while (!path.empty() && (path.front() == '/' || path.front() == '.')) path.erase(0, 1);
+        }
+        auto it = by_path.find(path);
+        if (it == by_path.end() || placed[it->second]) continue;
+        placed[it->second] = 1;
+        order.push_back(it->second);
+    }
+
+    std::vector<ScannedFile> reordered;
+    reordered.reserve(files_.size());
+    for (int i : order) {
+        reordered.push_back(std::move(files_[i]));
+    }
+    for (size_t i = 0; i < files_.size(); ++i) {
+        if (!placed[i]) reordered.push_back(std::move(files_[i]));
+    }
+    files_.swap(reordered);
+    boot_files_ = static_cast<int>(order.size());
+    return boot_files_;
+}
+
+void DirectoryScanner::add_to_storage(lt::file_storage& fs_storage, int pad_piece_length) const
+{
+    // pad 文件放在顶层目录下的 .pad 目录中（单文件 torrent 不需要也不能插入 pad 文件）
+    std::string pad_dir;
+    if (pad_piece_length > 0 && boot_files_ > 0 && files_.size() > 1) {
+        size_t slash = files_.front().path.find('/');
+        if (slash != std::string::npos) {
+            pad_dir = files_.front().path.substr(0, slash) + "/.pad/";
+        }
+    }
+    std::int64_t offset = 0;
+    auto pad_to_boundary = [&]() {
+        std::int64_t remainder = offset % pad_piece_length;
+        if (remainder == 0) return;
+        std::int64_t pad_size = pad_piece_length - remainder;
+        fs_storage.add_file(pad_dir + std::to_string(pad_size), pad_size, lt::file_storage::flag_pad_file);
+        offset += pad_size;
+    };
+
+    fs_storage.reserve(static_cast<int>(files_.size()));
+    for (size_t i = 0; i < files_.size(); ++i) {
+        const ScannedFile& file = files_[i];
+        if (!pad_dir.empty()) {
+            const bool boot = static_cast<int>(i) < boot_files_;
+            if ((boot && file.size >= pad_piece_length) || static_cast<int>(i) == boot_files_) {
+                pad_to_boundary();
+            }
+        }
+        offset += file.size;
+        lt::file_flags_t flags = {};
+        if (file.hidden) flags |= lt::file_storage::flag_hidden;
+        if (file.executable) flags |= lt::file_storage::flag_executable;
+        fs_storage.add_file(file.path, file.size, flags);
+    }
+}
+
+ScannedMtimes DirectoryScanner::mtimes() const
+{
+    ScannedMtimes result;
+    result.reserve(files_.size());
+    for (const auto& file : files_) {
+        if (file.mtime >= 0) {
+            result[file.path] = file.mtime;
+        }
+    }
+    return result;
+}
+
+bool DirectoryScanner::find_mtime(const ScannedMtimes* mtimes, const lt::file_storage& fs_storage,
+                                  lt::file_index_t index, std::int64_t& mtime)
+{
+    if (!mtimes || mtimes->empty()) {
+        return false;
+    }
+    std::string key = fs_storage.file_path(index);
+    std::replace(key.begin(), key.end(), '\\', '/');
+    auto it = mtimes->find(key);
+    if (it == mtimes->end()) {
+        return false;
+    }
+    mtime = it->second;
+    return true;
+}
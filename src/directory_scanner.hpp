@@ -0,0 +1,75 @@
+#ifndef DIRECTORY_SCANNER_HPP
+#define DIRECTORY_SCANNER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <libtorrent/file_storage.hpp>
+
+// 扫描到的文件
+struct ScannedFile {
+    std::string path;          // torrent 中的相对路径（以 / 分隔，目录输入时以目录名开头）
+    std::int64_t size = 0;     // 文件大小
+    std::int64_t mtime = 0;    // 修改时间（文件系统时钟计数，与 PieceHashCache 一致）
+    bool hidden = false;       // 是否为隐藏文件（Windows）
+    bool executable = false;   // 是否可执行（POSIX）
+};
+
+// 扫描时记录的文件修改时间（以 torrent 中的相对路径为键，/ 分隔），供后续阶段复用，避免再次访问文件系统
+using ScannedMtimes = std::unordered_map<std::string, std::int64_t>;
+
+// 并行目录扫描器
+// 多个线程同时枚举不同的子目录，一次遍历收集所有文件的路径、大小、修改时间和属性
+// 结果按路径逐级排序（与目录枚举顺序无关），保证相同的目录内容生成相同的 info hash
+class DirectoryScanner
+{
+public:
+    // input_path: 要扫描的文件或目录
+    explicit DirectoryScanner(const std::string& input_path);
+
+    // 设置扫描线程数，0 表示自动（CPU 核心数，最多 16）
+    inline void set_threads(int threads) { threads_ = threads; }
+
+    // 设置安静模式：不输出扫描开始和完成信息（警告仍然输出）
+    inline void set_quiet(bool quiet) { quiet_ = quiet; }
+
+    // 扫描文件或目录，失败（路径不存在）时返回 false
+    bool scan();
+
+    // 扫描到的文件（已排序）
+    inline const std::vector<ScannedFile>& files() const { return files_; }
+
+    // 所有文件的总大小
+    inline std::int64_t total_size() const { return total_size_; }
+
+    // 按访问顺序重排：列表中的文件按列表顺序排在最前，其余文件保持路径顺序
+    // 列表中的路径可以是 torrent 中的相对路径、相对于输入目录的路径或原始磁盘上的绝对路径（不区分大小写）
+    // 返回: 匹配到的文件数量（即排在最前的文件数量）
+    int apply_access_order(const std::vector<std::string>& access_order);
+
+    // 访问顺序列表匹配到的文件数量（这些文件位于 files() 的最前面）
+    inline int boot_files() const { return boot_files_; }
+
+    // 按扫描顺序将文件添加到 file_storage（与 lt::add_files 生成的路径格式相同）
+    // pad_piece_length > 0 时插入 pad 文件：不小于一个分片的启动文件从分片边界开始，
+    // 启动文件之后的第一个文件也从新分片开始，使前面的分片只包含启动数据
+    void add_to_storage(lt::file_storage& fs_storage, int pad_piece_length = 0) const;
+
+    // 获取扫描时记录的修改时间表
+    ScannedMtimes mtimes() const;
+
+    // 在修改时间表中查找 file_storage 中的文件（未找到时返回 false）
+    static bool find_mtime(const ScannedMtimes* mtimes, const lt::file_storage& fs_storage,
+                           lt::file_index_t index, std::int64_t& mtime);
+
+private:
+    std::string input_path_;           // 输入路径
+    int threads_;                      // 扫描线程数（0 表示自动）
+    bool quiet_;                       // 是否不输出信息
+    std::vector<ScannedFile> files_;   // 扫描结果
+    std::int64_t total_size_;          // 总大小
+    int boot_files_;                   // 按访问顺序排在最前的文件数量
+};
+
+#endif // DIRECTORY_SCANNER_HPP
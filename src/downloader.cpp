@@ -1,4 +1,9 @@
 #include "downloader.hpp"
+#include "zero_pieces.hpp"
+#include "torrent_file_cache.hpp"
+#include "session_profile.hpp"
+#include "torrent_policy.hpp"
+#include <libtorrent/ip_filter.hpp>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -59,52 +64,24 @@ Downloader::~Downloader()
 void Downloader::configure_session()
 {
     try {
-        // 创建 session 配置
-        lt::settings_pack settings;
+        // 使用进程默认的会话配置（默认 wan，可通过 --profile 选择），与 TorrentManager 相同
+        SessionProfile profile = SessionProfile::get_default();
+        lt::settings_pack settings = profile.to_settings();
         settings.set_int(lt::settings_pack::alert_mask, 
                          lt::alert::status_notification | 
                          lt::alert::error_notification |
                          lt::alert::peer_notification |
                          lt::alert::storage_notification);
         
-        // 设置监听接口（空字符串表示自动选择）
-        settings.set_str(lt::settings_pack::listen_interfaces, "0.0.0.0:0");
-        
-        // 启用 DHT
-        settings.set_bool(lt::settings_pack::enable_dht, true);
-        
-        // 启用本地服务发现
-        settings.set_bool(lt::settings_pack::enable_lsd, true);
-        
-        // 启用 UPnP 和 NAT-PMP
-        settings.set_bool(lt::settings_pack::enable_upnp, true);
-        settings.set_bool(lt::settings_pack::enable_natpmp, true);
-        
-        // 设置下载限制（0 表示无限制）
-        settings.set_int(lt::settings_pack::download_rate_limit, 0);
-        settings.set_int(lt::settings_pack::upload_rate_limit, 0);
-        
-        // 设置最大连接数（大文件需要更多连接）
-        settings.set_int(lt::settings_pack::connections_limit, 200);
-        
-        // 设置磁盘缓存大小（大文件需要更大的缓存）
-        // 默认是32MB，对于大文件增加到512MB以提高性能
-        settings.set_int(lt::settings_pack::cache_size, 512);
-        
-        // 设置磁盘缓存过期时间（毫秒），大文件需要更长的缓存时间
-        settings.set_int(lt::settings_pack::cache_expiry, 300);
-        
-        // 设置磁盘写入队列大小（大文件需要更大的队列）
-        settings.set_int(lt::settings_pack::max_queued_disk_bytes, 1024 * 1024 * 1024); // 1GB
-        
-        // 注意：max_connections_per_torrent 不是 settings_pack 的成员
-        // 每个 torrent 的最大连接数需要通过 torrent_handle.set_max_connections() 设置
-        // 这将在 start_download() 中完成
-        
         // 创建 session
         session_ = std::make_unique<lt::session>(settings);
         
-        std::cout << "Downloader 会话已初始化（已优化大文件下载配置）" << std::endl;
+        lt::ip_filter filter;
+        if (profile.build_ip_filter(filter)) {
+            session_->set_ip_filter(filter);
+        }
+        
+        std::cout << "Downloader 会话已初始化（会话配置: " << profile.name << "）" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "初始化 Downloader 会话失败: " << e.what() << std::endl;
         throw;
@@ -152,48 +129,32 @@ bool Downloader::start_download(const std::string& torrent_path, const std::stri
             return false;
         }
         
-        // 加载 torrent 文件
-        std::ifstream torrent_file(torrent_path, std::ios::binary);
-        if (!torrent_file.is_open()) {
-            std::cerr << "错误: 无法打开 torrent 文件: " << torrent_path << std::endl;
-            return false;
-        }
-        
-        // 解析 torrent 文件，先获取 torrent_info 以检查文件大小
+        // 解析 torrent 文件（内存映射后解析，结果与 TorrentFileCache 共享），先获取 torrent_info 以检查文件大小
         lt::error_code ec;
-        lt::torrent_info ti(torrent_path, ec);
+        auto ti_ptr = TorrentFileCache::load_for_session(torrent_path, ec);
         if (ec) {
             std::cerr << "错误: 解析 torrent 文件失败: " << ec.message() << std::endl;
             return false;
         }
+        const lt::torrent_info& ti = *ti_ptr;
         
         // 获取 torrent 文件大小
         std::int64_t torrent_size = ti.total_size();
         
         // 创建 add_torrent_params
         lt::add_torrent_params params;
-        params.ti = std::make_shared<lt::torrent_info>(ti);
+        params.ti = ti_ptr;
         params.save_path = save_path;
         
-        // 针对大文件的优化设置
-        const std::int64_t large_file_threshold = 50LL * 1024 * 1024 * 1024; // 50GB
+        // 全零分片无需下载：新建稀疏文件并直接标记为已拥有
+        ZeroPieceMap::prepare_download(torrent_path, ti, save_path, params);
         
-        if (torrent_size > large_file_threshold) {
-            std::cout << "检测到大文件（总大小: " 
-                      << format_bytes(torrent_size) 
-                      << "），应用大文件下载优化..." << std::endl;
-            
-            // 对于大文件，不使用 auto_managed，手动控制下载
-            // 这样可以避免在检查文件时被自动暂停
-            // 注意：不使用 auto_managed 意味着需要手动管理下载状态
-            params.flags &= ~lt::torrent_flags::auto_managed;
-            params.flags &= ~lt::torrent_flags::paused;  // 确保不是暂停状态
-            
-            std::cout << "使用手动下载模式（跳过自动管理）..." << std::endl;
-        } else {
-            // 小文件使用标准设置（自动管理）
-            params.flags |= lt::torrent_flags::auto_managed;
-        }
+        // 按分类策略设置连接数、队列和文件优先级（与 TorrentManager 相同）
+        const TorrentPolicy policy = TorrentPolicy::get_default();
+        const TorrentClass& torrent_class = policy.classify(ti);
+        torrent_class.apply(params, false);
+        std::cout << "分类: " << torrent_class.name << "（连接数 " << torrent_class.max_connections
+                  << (torrent_class.auto_managed ? "，自动管理" : "，手动管理") << "）" << std::endl;
         
         // 添加 torrent 到 session
         torrent_handle_ = session_->add_torrent(params, ec);
@@ -202,31 +163,7 @@ bool Downloader::start_download(const std::string& torrent_path, const std::stri
             std::cerr << "错误: 添加 torrent 失败: " << ec.message() << std::endl;
             return false;
         }
-        
-        // 设置下载优先级（非上传模式）
-        torrent_handle_.set_upload_mode(false);
-        
-        // 对于大文件，设置更高的下载优先级和更多连接
-        if (torrent_size > large_file_threshold) {
-            // 设置每个 torrent 的最大连接数（大文件需要更多连接）
-            torrent_handle_.set_max_connections(200);
-            
-            // 设置所有文件为最高优先级
-            std::vector<int> priorities;
-            for (int i = 0; i < ti.num_files(); ++i) {
-                priorities.push_back(7); // 最高优先级
-            }
-            torrent_handle_.prioritize_files(priorities);
-            
-            // 强制开始下载（大文件需要手动控制）
-            // resume() 会自动取消暂停状态
-            torrent_handle_.resume();
-            
-            std::cout << "已强制开始下载..." << std::endl;
-        } else {
-            // 小文件也设置合理的连接数
-            torrent_handle_.set_max_connections(50);
-        }
+        torrent_class.apply_handle(torrent_handle_);
         
         // 确保下载已开始（无论文件大小）
         // 再次调用 resume 确保下载已启动
@@ -392,6 +329,9 @@ bool Downloader::wait_and_process(int timeout_ms)
     }
     
     try {
+        // 等待 alert（最多 timeout_ms），有 alert 时立即返回处理，而不是处理完再固定休眠
+        session_->wait_for_alert(lt::milliseconds(timeout_ms));
+        
         // 处理 alerts
         std::vector<lt::alert*> alerts;
         session_->pop_alerts(&alerts);
@@ -452,9 +392,6 @@ bool Downloader::wait_and_process(int timeout_ms)
             }
         }
         
-        // 等待指定时间
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
-        
         return is_downloading_;
     } catch (const std::exception& e) {
         std::cerr << "处理事件时出错: " << e.what() << std::endl;
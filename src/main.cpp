@@ -6,12 +6,26 @@
 #endif
 #include <libtorrent/version.hpp>
 #include "torrent_builder.hpp"
+#include "batch_builder.hpp"
 #include "torrent_manager.hpp"
+#include "sha_backend.hpp"
+#include "session_profile.hpp"
+#include "profile_benchmark.hpp"
+#include "torrent_policy.hpp"
+#include "torrent_file_cache.hpp"
+#include "boot_trace.hpp"
+#include "prefetch_profile.hpp"
 #include <cstdio>
 #include <vector>
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
 #include <chrono>
 #include <sstream>
+#include <fstream>
+#include <future>
+#include <libtorrent/torrent_info.hpp>
 
 // 辅助函数：格式化字节数
 static std::string format_bytes(std::int64_t bytes)
@@ -30,6 +44,43 @@ static std::string format_bytes(std::int64_t bytes)
     return std::string(buffer);
 }
 
+// 辅助函数：根据名称选择 SHA 哈希后端（scalar / avx2 / shani）
+static bool select_sha_backend(const std::string& name)
+{
+    ShaBackend::Type type;
+    if (name == "scalar") {
+        type = ShaBackend::Type::Scalar;
+    } else if (name == "avx2") {
+        type = ShaBackend::Type::Avx2MultiBuffer;
+    } else if (name == "shani") {
+        type = ShaBackend::Type::ShaNi;
+    } else {
+        std::cerr << "未知的哈希后端: " << name << "（可选: scalar, avx2, shani）" << std::endl;
+        return false;
+    }
+    if (!ShaBackend::set_active(type)) {
+        std::cerr << "当前 CPU 不支持哈希后端: " << ShaBackend::name(type)
+                  << "，继续使用: " << ShaBackend::name(ShaBackend::active()) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 辅助函数：生成 torrent 时写入的默认 tracker 列表
+static std::vector<std::string> default_trackers()
+{
+    return {
+        // 公共 tracker 示例（可以取消注释使用）:
+        // "udp://tracker.openbittorrent.com:80/announce",
+        // "udp://tracker.publicbt.com:80/announce",
+        // "udp://tracker.istole.it:80/announce",
+        // "http://tracker.bt-chat.com/announce",
+        "http://172.16.1.63:6880/announce",
+        "http://124.71.64.241:6969/announce",
+        "http://124.71.64.241:6880/announce",
+    };
+}
+
 int main(int argc, char* argv[])
 {
 #ifdef _WIN32
@@ -43,11 +94,45 @@ int main(int argc, char* argv[])
         std::cout << "LibTorrent Version: " << LIBTORRENT_VERSION << std::endl;
         std::cout << std::endl;
 
+        // 会话配置：--profile <wan|lan|low-memory|配置文件[:名称]> 和分类策略 --policy <配置文件> 可出现在任意位置，
+        // 在创建 session 之前设置为默认配置，并从参数中移除，不影响各模式的位置参数
+        std::vector<char*> args(argv, argv + argc);
+        for (size_t i = 1; i + 1 < args.size(); ) {
+            if (std::string(args[i]) == "--profile") {
+                SessionProfile profile;
+                if (!SessionProfile::resolve(args[i + 1], profile)) {
+                    std::cerr << "无效的会话配置: " << args[i + 1] << std::endl;
+                    return 1;
+                }
+                SessionProfile::set_default(profile);
+                args.erase(args.begin() + i, args.begin() + i + 2);
+            } else if (std::string(args[i]) == "--policy") {
+                // torrent 分类策略：替换内置的 small/large/standard 分类，添加 torrent 和生成 torrent 时使用
+                TorrentPolicy policy;
+                if (!TorrentPolicy::load_file(args[i + 1], policy)) {
+                    std::cerr << "无效的分类策略文件: " << args[i + 1] << std::endl;
+                    return 1;
+                }
+                TorrentPolicy::set_default(policy);
+                policy.print();
+                std::cout << std::endl;
+                args.erase(args.begin() + i, args.begin() + i + 2);
+            } else {
+                ++i;
+            }
+        }
+        argc = static_cast<int>(args.size());
+        args.push_back(nullptr);
+        argv = args.data();
+
         // 检查运行模式
         bool direct_seed_mode = false;
         bool download_mode = false;
         bool multi_seed_mode = false;
         bool test_manager_mode = false;
+        bool verify_mode = false;
+        bool batch_mode = false;
+        bool prefetch_mode = false;
         if (argc >= 2) {
             std::string first_arg = argv[1];
             if (first_arg == "-s" || first_arg == "--seed") {
@@ -58,9 +143,238 @@ int main(int argc, char* argv[])
                 multi_seed_mode = true;
             } else if (first_arg == "-t" || first_arg == "--test-manager") {
                 test_manager_mode = true;
+            } else if (first_arg == "-v" || first_arg == "--verify") {
+                verify_mode = true;
+            } else if (first_arg == "-b" || first_arg == "--batch") {
+                batch_mode = true;
+            } else if (first_arg == "-p" || first_arg == "--prefetch") {
+                prefetch_mode = true;
             }
         }
         
+        // 校验模式：按 torrent 中的分片哈希校验本地数据（不启动会话）
+        if (verify_mode) {
+            if (argc < 4) {
+                std::cout << "用法（校验）: " << argv[0] << " -v <torrent文件路径> <保存路径> [选项]" << std::endl;
+                std::cout << "  选项: --hash-threads <N>  哈希计算线程数（默认: CPU 核心数）" << std::endl;
+                std::cout << "        --sha-backend <名称> 哈希后端: scalar, avx2, shani（默认: 自动检测）" << std::endl;
+                std::cout << "        --direct-io         使用无缓冲 I/O 读取数据" << std::endl;
+                std::cout << "        --bitfield <文件>   将分片位图写入文件（每个分片一个字符，1 表示通过）" << std::endl;
+                std::cout << "        --seed              校验后直接以校验结果做种（通过的分片无需再次校验）" << std::endl;
+                return 1;
+            }
+            
+            std::string torrent_path = argv[2];
+            std::string save_path = argv[3];
+            int hash_threads = 0;
+            bool direct_io = false;
+            std::string bitfield_path;
+            bool seed_after_verify = false;
+            for (int i = 4; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--hash-threads" && i + 1 < argc) {
+                    hash_threads = std::stoi(argv[++i]);
+                } else if (arg == "--direct-io") {
+                    direct_io = true;
+                } else if (arg == "--bitfield" && i + 1 < argc) {
+                    bitfield_path = argv[++i];
+                } else if (arg == "--seed") {
+                    seed_after_verify = true;
+                } else if (arg == "--sha-backend" && i + 1 < argc) {
+                    select_sha_backend(argv[++i]);
+                }
+            }
+            
+            std::cout << "=== 校验模式 ===" << std::endl;
+            std::cout << "Torrent 文件: " << torrent_path << std::endl;
+            std::cout << "保存路径: " << save_path << std::endl;
+            std::cout << std::endl;
+            
+            VerifyResult result;
+            if (!TorrentManager::verify_torrent(torrent_path, save_path, result, hash_threads, direct_io)) {
+                return 1;
+            }
+            TorrentManager::print_verify_report(result);
+            if (!bitfield_path.empty() && TorrentManager::write_piece_bitfield(result, bitfield_path)) {
+                std::cout << "分片位图已写入: " << bitfield_path << std::endl;
+            }
+            
+            if (seed_after_verify) {
+                // 校验结果直接作为恢复数据，libtorrent 不再重新校验
+                std::cout << std::endl;
+                std::cout << "=== 开始做种 ===" << std::endl;
+                TorrentManager& manager = TorrentManager::getInstance();
+                std::string seeding_hash = manager.start_seeding(torrent_path, save_path, result);
+                if (seeding_hash.empty()) {
+                    std::cerr << "启动做种失败" << std::endl;
+                    return 1;
+                }
+                std::cout << "做种已启动，按 Ctrl+C 停止做种" << std::endl;
+                // wait_and_process 在完成、错误等事件到达时会提前返回，按时间而不是调用次数输出状态
+                auto next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+                while (manager.get_seeding_count() > 0) {
+                    manager.wait_and_process(1000);
+                    if (std::chrono::steady_clock::now() >= next_status) {
+                        manager.print_torrent_status(seeding_hash);
+                        next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+                    }
+                }
+                std::cout << "做种已停止" << std::endl;
+                return 0;
+            }
+            
+            if (!result.all_ok()) {
+                return 1;
+            }
+            std::cout << "=== 校验通过 ===" << std::endl;
+            return 0;
+        }
+        
+        // 批量生成模式：为镜像库中的所有镜像生成 torrent
+        if (batch_mode) {
+            if (argc < 4) {
+                std::cout << "用法（批量生成）: " << argv[0] << " -b <清单文件或镜像库目录> <输出目录> [选项]" << std::endl;
+                std::cout << "  清单文件每行一个镜像: <镜像路径>[<TAB><输出路径>]；镜像库目录下的每个文件或子目录为一个镜像" << std::endl;
+                std::cout << "  选项: --jobs-per-disk <N> 每块磁盘同时生成的镜像数（默认: 1）" << std::endl;
+                std::cout << "        --max-jobs <N>      所有磁盘合计的最大并行任务数（默认: 不限制）" << std::endl;
+                std::cout << "        --force             重新生成已存在的 torrent（默认跳过，用于中断后继续）" << std::endl;
+                std::cout << "        --hash-threads <N>  每个任务的哈希线程数（默认: CPU 核心数 / 并行任务数）" << std::endl;
+                std::cout << "        --read-ahead <N>    读取阶段可提前填充的读取块数（默认: 4）" << std::endl;
+                std::cout << "        --direct-io         使用无缓冲 I/O 读取源文件" << std::endl;
+                std::cout << "        --sha-backend <名称> 哈希后端: scalar, avx2, shani（默认: 自动检测）" << std::endl;
+                std::cout << "        --no-hash-cache     不使用分片哈希缓存" << std::endl;
+                std::cout << "        --checkpoint-interval <秒> 哈希检查点间隔（默认: 60，0 表示关闭）" << std::endl;
+                std::cout << "        --v2 / --hybrid     生成 v2 / 混合 torrent" << std::endl;
+                std::cout << "        --write-resume      同时写入快速恢复数据" << std::endl;
+                std::cout << "        --no-sparse         不识别稀疏空洞和全零分片" << std::endl;
+                return 1;
+            }
+            
+            std::string source = argv[2];
+            std::string output_dir = argv[3];
+            
+            TorrentBuilder prototype;
+            prototype.set_trackers(default_trackers());
+            prototype.set_comment("由 DisklessWorkstation 创建");
+            int jobs_per_disk = 1;
+            int max_jobs = 0;
+            bool force = false;
+            for (int i = 4; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--jobs-per-disk" && i + 1 < argc) {
+                    jobs_per_disk = std::stoi(argv[++i]);
+                } else if (arg == "--max-jobs" && i + 1 < argc) {
+                    max_jobs = std::stoi(argv[++i]);
+                } else if (arg == "--force") {
+                    force = true;
+                } else if (arg == "--hash-threads" && i + 1 < argc) {
+                    prototype.set_hash_threads(std::stoi(argv[++i]));
+                } else if (arg == "--read-ahead" && i + 1 < argc) {
+                    prototype.set_read_ahead(std::stoi(argv[++i]));
+                } else if (arg == "--direct-io") {
+                    prototype.set_direct_io(true);
+                } else if (arg == "--sha-backend" && i + 1 < argc) {
+                    select_sha_backend(argv[++i]);
+                } else if (arg == "--no-hash-cache") {
+                    prototype.set_hash_cache(false);
+                } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+                    prototype.set_checkpoint_interval(std::stoi(argv[++i]));
+                } else if (arg == "--v2") {
+                    prototype.set_torrent_version(TorrentVersion::V2);
+                } else if (arg == "--hybrid") {
+                    prototype.set_torrent_version(TorrentVersion::Hybrid);
+                } else if (arg == "--write-resume") {
+                    prototype.set_write_resume(true);
+                } else if (arg == "--no-sparse") {
+                    prototype.set_sparse_aware(false);
+                }
+            }
+            
+            std::cout << "=== 批量生成模式 ===" << std::endl;
+            BatchBuilder batch(prototype);
+            batch.set_jobs_per_disk(jobs_per_disk);
+            batch.set_max_jobs(max_jobs);
+            batch.set_force(force);
+            
+            bool loaded = std::filesystem::is_directory(std::filesystem::u8path(source))
+                ? batch.load_directory(source, output_dir)
+                : batch.load_manifest(source, output_dir);
+            if (!loaded) {
+                return 1;
+            }
+            std::cout << std::endl;
+            
+            int failed = batch.run();
+            return failed > 0 ? 1 : 0;
+        }
+        
+        // 预取配置模式：将多次启动的访问跟踪编译为 <torrent>.prefetch（不启动会话）
+        if (prefetch_mode) {
+            if (argc < 3) {
+                std::cout << "用法（预取配置）: " << argv[0] << " -p <torrent文件路径> [跟踪文件或目录 ...] [选项]" << std::endl;
+                std::cout << "  不指定跟踪文件时使用 <torrent文件>.traces 目录中的所有 .trace 文件" << std::endl;
+                std::cout << "  选项: --min-share <0-1>  分片至少在该比例的启动中被读取才会预取（默认: 0.5）" << std::endl;
+                return 1;
+            }
+            
+            namespace fs = std::filesystem;
+            std::string torrent_path = argv[2];
+            double min_share = 0.5;
+            std::vector<std::string> sources;
+            for (int i = 3; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--min-share" && i + 1 < argc) {
+                    min_share = std::stod(argv[++i]);
+                } else {
+                    sources.push_back(arg);
+                }
+            }
+            if (sources.empty()) {
+                sources.push_back(BootTraceRecorder::dir_for(torrent_path));
+            }
+            
+            // 目录展开为其中的 .trace 文件（按文件名排序）
+            std::vector<std::string> trace_paths;
+            for (const auto& source : sources) {
+                std::error_code ec;
+                if (!fs::is_directory(fs::u8path(source), ec)) {
+                    trace_paths.push_back(source);
+                    continue;
+                }
+                std::vector<std::string> found;
+                for (const auto& entry : fs::directory_iterator(fs::u8path(source), ec)) {
+                    if (entry.is_regular_file() && entry.path().extension() == ".trace") {
+                        found.push_back(entry.path().u8string());
+                    }
+                }
+                std::sort(found.begin(), found.end());
+                trace_paths.insert(trace_paths.end(), found.begin(), found.end());
+            }
+            
+            std::cout << "=== 预取配置模式 ===" << std::endl;
+            std::cout << "Torrent 文件: " << torrent_path << std::endl;
+            std::cout << "跟踪文件: " << trace_paths.size() << " 个" << std::endl;
+            std::cout << std::endl;
+            
+            lt::error_code ec;
+            std::shared_ptr<const lt::torrent_info> ti = TorrentFileCache::load(torrent_path, ec);
+            if (!ti) {
+                std::cerr << "无法加载 torrent 文件: " << ec.message() << std::endl;
+                return 1;
+            }
+            PrefetchProfile profile;
+            if (!PrefetchProfile::compile(*ti, trace_paths, min_share, profile)) {
+                return 1;
+            }
+            const std::string profile_path = PrefetchProfile::path_for(torrent_path);
+            if (!profile.save(profile_path)) {
+                return 1;
+            }
+            profile.print_summary();
+            std::cout << "预取配置已写入: " << profile_path << std::endl;
+            return 0;
+        }
+        
         // TorrentManager 测试模式
         if (test_manager_mode) {
             std::cout << "=== TorrentManager 测试模式 ===" << std::endl;
@@ -84,6 +398,8 @@ int main(int argc, char* argv[])
                 std::cout << "测试模式:" << std::endl;
                 std::cout << "  basic      - 基础功能测试（需要提供torrent文件和路径）" << std::endl;
                 std::cout << "  concurrent - 并发测试（需要提供多个torrent文件和路径）" << std::endl;
+                std::cout << "  snapshot   - 状态快照并发读取基准测试（写操作进行时的读吞吐量）" << std::endl;
+                std::cout << "  profile-bench - 会话配置回环传输基准测试（比较不同配置的传输速度）" << std::endl;
                 std::cout << std::endl;
                 std::cout << "基础测试示例:" << std::endl;
                 std::cout << "  " << argv[0] << " -t basic <torrent文件> <下载保存路径>" << std::endl;
@@ -93,6 +409,13 @@ int main(int argc, char* argv[])
                 std::cout << "并发测试示例:" << std::endl;
                 std::cout << "  " << argv[0] << " -t concurrent <torrent1> <保存路径1> [torrent2] [保存路径2] ..." << std::endl;
                 std::cout << std::endl;
+                std::cout << "快照基准测试示例:" << std::endl;
+                std::cout << "  " << argv[0] << " -t snapshot [最大读线程数] [每轮秒数]" << std::endl;
+                std::cout << std::endl;
+                std::cout << "会话配置基准测试示例:" << std::endl;
+                std::cout << "  " << argv[0] << " -t profile-bench <torrent文件> <做种数据路径> [配置 ...]" << std::endl;
+                std::cout << "  配置为 wan、lan、low-memory 或 配置文件[:名称]，默认比较所有内置配置" << std::endl;
+                std::cout << std::endl;
                 std::cout << "交互式测试示例:" << std::endl;
                 std::cout << "  " << argv[0] << " -t interactive" << std::endl;
                 return 1;
@@ -301,15 +624,18 @@ int main(int argc, char* argv[])
                 std::cout << "=== 初始网络状态诊断 ===" << std::endl;
                 manager1.print_session_status();
                 
-                int counter = 0;
+                const auto monitor_start = std::chrono::steady_clock::now();
+                auto next_status = monitor_start + std::chrono::seconds(10);
                 while (true) {
                     manager1.wait_and_process(1000);
-                    counter++;
+                    const auto now = std::chrono::steady_clock::now();
                     
                     // 每10秒显示详细状态
-                    if (counter % 10 == 0) {
+                    if (now >= next_status) {
+                        next_status = now + std::chrono::seconds(10);
+                        const long long elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - monitor_start).count();
                         std::cout << std::endl;
-                        std::cout << "=== 当前状态（" << counter << "秒） ===" << std::endl;
+                        std::cout << "=== 当前状态（" << elapsed << "秒） ===" << std::endl;
                         
                         // 显示网络和 peer 状态
                         manager1.print_session_status();
@@ -412,14 +738,18 @@ int main(int argc, char* argv[])
                     std::cout << "按 Ctrl+C 提前停止" << std::endl;
                     std::cout << std::endl;
                     
-                    int counter = 0;
-                    while (counter < 30 && manager1.get_torrent_count() > 0) {
+                    const auto monitor_start = std::chrono::steady_clock::now();
+                    const auto monitor_end = monitor_start + std::chrono::seconds(30);
+                    auto next_status = monitor_start + std::chrono::seconds(5);
+                    while (std::chrono::steady_clock::now() < monitor_end && manager1.get_torrent_count() > 0) {
                         manager1.wait_and_process(1000);
-                        counter++;
+                        const auto now = std::chrono::steady_clock::now();
                         
-                        if (counter % 5 == 0) {
+                        if (now >= next_status) {
+                            next_status += std::chrono::seconds(5);
+                            const long long elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - monitor_start).count();
                             std::cout << std::endl;
-                            std::cout << "=== 状态更新（" << counter << "秒） ===" << std::endl;
+                            std::cout << "=== 状态更新（" << elapsed << "秒） ===" << std::endl;
                             manager1.print_all_status();
                             
                             // 显示统计信息
@@ -453,6 +783,132 @@ int main(int argc, char* argv[])
                 return 0;
             }
             
+            // 状态快照读取基准测试
+            else if (test_mode == "snapshot") {
+                // 参数: [最大读线程数] [每轮秒数]
+                unsigned int max_readers = std::max(1u, std::thread::hardware_concurrency());
+                int seconds = 2;
+                if (argc >= 4) {
+                    max_readers = static_cast<unsigned int>(std::max(1, std::atoi(argv[3])));
+                }
+                if (argc >= 5) {
+                    seconds = std::max(1, std::atoi(argv[4]));
+                }
+                
+                std::cout << "[测试] 状态快照并发读取基准测试" << std::endl;
+                std::cout << "写线程持续执行 wait_and_process(0)（持有 mutex_ 并请求状态更新），"
+                          << "读线程循环调用 has_torrent / get_torrent_count / get_all_torrent_status" << std::endl;
+                std::cout << "当前 torrent 数量: " << manager1.get_torrent_count() << "，每轮 " << seconds << " 秒" << std::endl;
+                std::cout << std::endl;
+                
+                // 读线程数: 1, 2, 4, ... 以及 max_readers
+                std::vector<unsigned int> reader_counts;
+                for (unsigned int n = 1; n < max_readers; n *= 2) {
+                    reader_counts.push_back(n);
+                }
+                reader_counts.push_back(max_readers);
+                
+                double single_thread_rate = 0.0;
+                std::atomic<std::size_t> checksum(0);
+                for (unsigned int readers : reader_counts) {
+                    std::atomic<bool> running(true);
+                    std::atomic<std::uint64_t> total_reads(0);
+                    std::atomic<std::uint64_t> total_writes(0);
+                    
+                    std::thread writer([&]() {
+                        std::uint64_t writes = 0;
+                        while (running.load(std::memory_order_relaxed)) {
+                            manager1.wait_and_process(0);
+                            writes++;
+                        }
+                        total_writes += writes;
+                    });
+                    
+                    std::vector<std::thread> reader_threads;
+                    for (unsigned int r = 0; r < readers; ++r) {
+                        reader_threads.emplace_back([&]() {
+                            std::uint64_t reads = 0;
+                            std::size_t sink = 0;
+                            while (running.load(std::memory_order_relaxed)) {
+                                sink += manager1.has_torrent("0000000000000000000000000000000000000000") ? 1 : 0;
+                                sink += manager1.get_torrent_count();
+                                sink += manager1.get_all_torrent_status().size();
+                                reads++;
+                            }
+                            total_reads += reads;
+                            checksum += sink;  // 防止读取被优化掉
+                        });
+                    }
+                    
+                    auto start_time = std::chrono::steady_clock::now();
+                    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+                    running = false;
+                    for (auto& t : reader_threads) {
+                        t.join();
+                    }
+                    writer.join();
+                    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                    
+                    double rate = static_cast<double>(total_reads.load()) / elapsed;
+                    if (readers == 1) {
+                        single_thread_rate = rate;
+                    }
+                    char line[160];
+                    snprintf(line, sizeof(line), "读线程 %3u: %10.0f 次/秒（每线程 %10.0f），加速比 %.2fx，写操作 %llu 次",
+                             readers, rate, rate / readers,
+                             single_thread_rate > 0 ? rate / single_thread_rate : 0.0,
+                             static_cast<unsigned long long>(total_writes.load()));
+                    std::cout << line << std::endl;
+                }
+                return 0;
+            }
+            
+            // 会话配置回环传输基准测试
+            else if (test_mode == "profile-bench") {
+                if (argc < 5) {
+                    std::cerr << "用法: " << argv[0] << " -t profile-bench <torrent文件> <做种数据路径> [配置 ...]" << std::endl;
+                    return 1;
+                }
+                std::string torrent_path = argv[3];
+                std::string data_path = argv[4];
+                
+                std::vector<SessionProfile> profiles;
+                if (argc > 5) {
+                    for (int i = 5; i < argc; ++i) {
+                        SessionProfile profile;
+                        if (!SessionProfile::resolve(argv[i], profile)) {
+                            std::cerr << "无效的会话配置: " << argv[i] << std::endl;
+                            return 1;
+                        }
+                        profiles.push_back(profile);
+                    }
+                } else {
+                    for (const auto& name : SessionProfile::builtin_names()) {
+                        SessionProfile profile;
+                        SessionProfile::builtin(name, profile);
+                        profiles.push_back(profile);
+                    }
+                }
+                
+                std::cout << "[测试] 会话配置回环传输基准测试" << std::endl;
+                std::cout << "做种和下载 session 通过 127.0.0.1 传输: " << torrent_path << std::endl;
+                std::cout << std::endl;
+                
+                std::vector<ProfileBenchmarkResult> results;
+                for (const auto& profile : profiles) {
+                    profile.print();
+                    ProfileBenchmarkResult result;
+                    ProfileBenchmark::run(profile, torrent_path, data_path, result);
+                    results.push_back(result);
+                    std::cout << std::endl;
+                }
+                ProfileBenchmark::print_results(results);
+                
+                bool all_ok = std::all_of(results.begin(), results.end(),
+                                          [](const ProfileBenchmarkResult& r) { return r.ok; });
+                return all_ok ? 0 : 1;
+            }
+            
             // 交互式测试
             else if (test_mode == "interactive") {
                 std::cout << "=== 交互式测试模式 ===" << std::endl;
@@ -467,6 +923,13 @@ int main(int argc, char* argv[])
                 std::cout << "  stop <info_hash>                    - 停止任务" << std::endl;
                 std::cout << "  stop-all                             - 停止所有任务" << std::endl;
                 std::cout << "  stats                                - 显示统计信息" << std::endl;
+                std::cout << "  profile [配置]                       - 显示或切换会话配置（wan/lan/low-memory/配置文件[:名称]）" << std::endl;
+                std::cout << "  stream <info_hash> [窗口MB]          - 开始流式读取（读取位置之后的窗口优先下载，默认 256MB）" << std::endl;
+                std::cout << "  seek <info_hash> <偏移MB>            - 移动流式读取位置并显示连续可读的数据量" << std::endl;
+                std::cout << "  unstream <info_hash>                 - 结束流式读取" << std::endl;
+                std::cout << "  trace <info_hash> [跟踪文件]         - 开始记录启动访问跟踪（seek 视为一次读取）" << std::endl;
+                std::cout << "  untrace <info_hash>                  - 结束记录启动访问跟踪" << std::endl;
+                std::cout << "  read <info_hash> <文件索引> <偏移> <长度> - 阻塞读取文件数据（缺少的分片优先下载）并显示耗时" << std::endl;
                 std::cout << "  quit                                 - 退出" << std::endl;
                 std::cout << std::endl;
                 
@@ -561,6 +1024,104 @@ int main(int argc, char* argv[])
                         manager1.stop_all();
                         std::cout << "✓ 已停止所有任务" << std::endl;
                     }
+                    else if (cmd == "profile") {
+                        std::string spec;
+                        if (iss >> spec) {
+                            SessionProfile profile;
+                            if (SessionProfile::resolve(spec, profile) && manager1.apply_profile(profile)) {
+                                profile.print();
+                            } else {
+                                std::cerr << "✗ 切换会话配置失败" << std::endl;
+                            }
+                        } else {
+                            std::cout << "当前会话配置: " << manager1.current_profile() << std::endl;
+                        }
+                    }
+                    else if (cmd == "stream") {
+                        std::string hash;
+                        std::int64_t window_mb = 256;
+                        if (iss >> hash) {
+                            iss >> window_mb;
+                            if (manager1.start_stream(hash, window_mb * 1024 * 1024)) {
+                                std::cout << "✓ 已开始流式读取" << std::endl;
+                            } else {
+                                std::cerr << "✗ 开始流式读取失败" << std::endl;
+                            }
+                        } else {
+                            std::cerr << "用法: stream <info_hash> [窗口MB]" << std::endl;
+                        }
+                    }
+                    else if (cmd == "seek") {
+                        std::string hash;
+                        std::int64_t offset_mb = 0;
+                        if (iss >> hash >> offset_mb) {
+                            if (manager1.record_read(hash, offset_mb * 1024 * 1024, 1) &&
+                                manager1.set_stream_position(hash, offset_mb * 1024 * 1024)) {
+                                StreamStatus stream = manager1.get_stream_status(hash);
+                                std::cout << "✓ 读取位置: " << format_bytes(stream.position)
+                                          << "，连续可读: " << format_bytes(stream.ready_bytes)
+                                          << "，窗口缺少 " << stream.missing_pieces << " / " << stream.window_pieces
+                                          << " 个分片" << std::endl;
+                            } else {
+                                std::cerr << "✗ 移动读取位置失败" << std::endl;
+                            }
+                        } else {
+                            std::cerr << "用法: seek <info_hash> <偏移MB>" << std::endl;
+                        }
+                    }
+                    else if (cmd == "unstream") {
+                        std::string hash;
+                        if (iss >> hash) {
+                            if (manager1.stop_stream(hash)) {
+                                std::cout << "✓ 已结束流式读取" << std::endl;
+                            } else {
+                                std::cerr << "✗ 结束流式读取失败" << std::endl;
+                            }
+                        } else {
+                            std::cerr << "用法: unstream <info_hash>" << std::endl;
+                        }
+                    }
+                    else if (cmd == "trace") {
+                        std::string hash, trace_path;
+                        if (iss >> hash) {
+                            iss >> trace_path;
+                            if (!manager1.start_trace(hash, trace_path)) {
+                                std::cerr << "✗ 开始记录启动访问跟踪失败" << std::endl;
+                            }
+                        } else {
+                            std::cerr << "用法: trace <info_hash> [跟踪文件]" << std::endl;
+                        }
+                    }
+                    else if (cmd == "read") {
+                        std::string hash;
+                        int file_index = 0;
+                        std::int64_t offset = 0;
+                        std::int64_t length = 0;
+                        if (iss >> hash >> file_index >> offset >> length && length >= 0) {
+                            std::vector<char> data(static_cast<size_t>(length));
+                            auto read_start = std::chrono::steady_clock::now();
+                            std::int64_t n = manager1.read(hash, file_index, offset, data.data(), length);
+                            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - read_start).count();
+                            if (n >= 0) {
+                                std::cout << "✓ 读取 " << format_bytes(n) << "，耗时 " << elapsed << " ms" << std::endl;
+                            } else {
+                                std::cerr << "✗ 读取失败（" << elapsed << " ms）" << std::endl;
+                            }
+                        } else {
+                            std::cerr << "用法: read <info_hash> <文件索引> <偏移> <长度>" << std::endl;
+                        }
+                    }
+                    else if (cmd == "untrace") {
+                        std::string hash;
+                        if (iss >> hash) {
+                            if (!manager1.stop_trace(hash)) {
+                                std::cerr << "✗ 结束记录启动访问跟踪失败" << std::endl;
+                            }
+                        } else {
+                            std::cerr << "用法: untrace <info_hash>" << std::endl;
+                        }
+                    }
                     else if (cmd == "stats") {
                         std::cout << "统计信息:" << std::endl;
                         std::cout << "  总任务数: " << manager1.get_torrent_count() << std::endl;
@@ -587,7 +1148,7 @@ int main(int argc, char* argv[])
             
             else {
                 std::cerr << "未知的测试模式: " << test_mode << std::endl;
-                std::cout << "可用模式: basic, concurrent, interactive" << std::endl;
+                std::cout << "可用模式: basic, concurrent, snapshot, profile-bench, interactive" << std::endl;
                 return 1;
             }
         }
@@ -604,6 +1165,7 @@ int main(int argc, char* argv[])
                 std::cout << "  -d, --download : 下载模式" << std::endl;
                 std::cout << "  torrent文件路径: 要下载的 .torrent 文件路径" << std::endl;
                 std::cout << "  保存路径        : 下载文件的保存目录" << std::endl;
+                std::cout << "  --state-dir <目录>: 恢复数据目录，重新启动后从上次进度继续（默认: torrent_state）" << std::endl;
                 return 1;
             }
             
@@ -616,6 +1178,9 @@ int main(int argc, char* argv[])
             std::cout << std::endl;
             
             TorrentManager& manager = TorrentManager::getInstance();
+            if (argc >= 6 && std::string(argv[4]) == "--state-dir") {
+                manager.set_state_dir(argv[5]);
+            }
             std::string download_hash = manager.start_download(torrent_path, save_path);
             if (download_hash.empty()) {
                 std::cerr << "启动下载失败" << std::endl;
@@ -628,7 +1193,7 @@ int main(int argc, char* argv[])
             std::cout << std::endl;
             
             // 主循环：保持下载状态并定期显示状态
-            int status_counter = 0;
+            auto next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
             while (true) {
                 manager.wait_and_process(1000);
                 
@@ -639,10 +1204,9 @@ int main(int argc, char* argv[])
                 }
                 
                 // 每 10 秒显示一次状态
-                status_counter++;
-                if (status_counter >= 10) {
+                if (std::chrono::steady_clock::now() >= next_status) {
                     manager.print_torrent_status(download_hash);
-                    status_counter = 0;
+                    next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
                 }
                 
                 if (status.is_finished) {
@@ -658,6 +1222,90 @@ int main(int argc, char* argv[])
         
         // 多torrent同时做种模式（使用 TorrentManager）
         if (multi_seed_mode) {
+            // 从清单批量导入：并行解析后异步添加到 session，适合成千上万个 torrent
+            if (argc >= 4 && std::string(argv[2]) == "--list") {
+                std::ifstream list_file(argv[3]);
+                if (!list_file.is_open()) {
+                    std::cerr << "无法打开清单文件: " << argv[3] << std::endl;
+                    return 1;
+                }
+                // 每行: <torrent文件路径>\t<保存路径>，# 开头为注释
+                std::vector<AddRequest> requests;
+                std::string line;
+                while (std::getline(list_file, line)) {
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    size_t start = line.find_first_not_of(' ');
+                    if (start == std::string::npos || line[start] == '#') continue;
+                    size_t tab = line.find('\t', start);
+                    if (tab == std::string::npos) {
+                        std::cerr << "忽略格式错误的行: " << line << std::endl;
+                        continue;
+                    }
+                    requests.emplace_back(line.substr(start, tab - start), line.substr(tab + 1), TorrentType::Seeding);
+                }
+                
+                TorrentManager& manager = TorrentManager::getInstance();
+                for (int i = 4; i + 1 < argc; ++i) {
+                    if (std::string(argv[i]) == "--state-dir") {
+                        manager.set_state_dir(argv[i + 1]);
+                    }
+                }
+                
+                std::cout << "=== 批量导入做种（使用 TorrentManager） ===" << std::endl;
+                std::cout << "清单中的 torrent: " << requests.size() << " 个" << std::endl;
+                
+                auto start_time = std::chrono::steady_clock::now();
+                std::vector<std::future<AddResult>> results = manager.add_torrents_async(requests);
+                auto parsed_time = std::chrono::steady_clock::now();
+                
+                int success_count = 0;
+                int fail_count = 0;
+                for (auto& future : results) {
+                    AddResult result = future.get();
+                    if (result.ok) {
+                        success_count++;
+                    } else {
+                        fail_count++;
+                        std::cerr << "✗ " << result.torrent_path << ": " << result.error << std::endl;
+                    }
+                }
+                auto added_time = std::chrono::steady_clock::now();
+                
+                std::cout << "=== 导入完成 ===" << std::endl;
+                std::cout << "成功: " << success_count << " 个" << std::endl;
+                std::cout << "失败: " << fail_count << " 个" << std::endl;
+                std::cout << "解析用时: " << std::chrono::duration<double>(parsed_time - start_time).count() << " 秒" << std::endl;
+                std::cout << "总用时: " << std::chrono::duration<double>(added_time - start_time).count() << " 秒" << std::endl;
+                std::cout << std::endl;
+                
+                if (success_count == 0) {
+                    std::cerr << "没有成功启动任何做种任务" << std::endl;
+                    return 1;
+                }
+                
+                std::cout << "所有torrent已启动，按 Ctrl+C 停止做种" << std::endl;
+                auto next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+                while (manager.get_seeding_count() > 0) {
+                    manager.wait_and_process(1000);
+                    
+                    // 每 10 秒显示一次汇总（torrent 数量多时不逐个打印）
+                    if (std::chrono::steady_clock::now() >= next_status) {
+                        std::vector<TorrentStatus> seeding_status = manager.get_seeding_status();
+                        std::int64_t total_upload = 0;
+                        int total_peers = 0;
+                        for (const auto& st : seeding_status) {
+                            total_upload += st.uploaded_bytes;
+                            total_peers += st.peer_count;
+                        }
+                        std::cout << "做种: " << seeding_status.size() << " 个，Peer: " << total_peers
+                                  << "，总上传: " << format_bytes(total_upload) << std::endl;
+                        next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+                    }
+                }
+                std::cout << "所有做种已停止" << std::endl;
+                return 0;
+            }
+            
             // 多torrent做种模式：同时做多个torrent
             if (argc < 4 || (argc - 2) % 2 != 0) {
                 std::cout << "用法（多torrent做种）: " << argv[0] << " -m <torrent1> <保存路径1> [torrent2] [保存路径2] ..." << std::endl;
@@ -668,6 +1316,8 @@ int main(int argc, char* argv[])
                 std::cout << "  -m, --multi-seed : 多torrent同时做种模式" << std::endl;
                 std::cout << "  参数必须是成对出现: <torrent文件路径> <保存路径>" << std::endl;
                 std::cout << "  可以同时做多个torrent，所有torrent在同一个session中并发做种" << std::endl;
+                std::cout << "  --list <清单文件> [--state-dir <目录>]: 从清单批量导入（每行 <torrent文件路径>\\t<保存路径>），" << std::endl;
+                std::cout << "    并行解析并异步添加，不逐个校验，没有恢复数据的 torrent 由 libtorrent 校验" << std::endl;
                 return 1;
             }
             
@@ -712,14 +1362,13 @@ int main(int argc, char* argv[])
                 std::cout << std::endl;
                 
                 // 主循环：保持做种状态并定期显示状态
-                int status_counter = 0;
+                auto next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
                 while (manager.get_seeding_count() > 0) {
                     // 处理事件
                     manager.wait_and_process(1000);
                     
                     // 每 10 秒显示一次状态
-                    status_counter++;
-                    if (status_counter >= 10) {
+                    if (std::chrono::steady_clock::now() >= next_status) {
                         std::cout << std::endl;
                         std::cout << "=== 当前状态（每10秒更新） ===" << std::endl;
                         manager.print_all_status();
@@ -739,7 +1388,7 @@ int main(int argc, char* argv[])
                         std::cout << "总下载: " << format_bytes(total_download) << std::endl;
                         std::cout << std::endl;
                         
-                        status_counter = 0;
+                        next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
                     }
                 }
                 
@@ -763,6 +1412,8 @@ int main(int argc, char* argv[])
                 std::cout << "  -s, --seed    : 直接做种模式（跳过生成 torrent 文件）" << std::endl;
                 std::cout << "  torrent文件路径: 已有的 .torrent 文件路径" << std::endl;
                 std::cout << "  保存路径        : 原始文件/目录的保存路径（必须与创建 torrent 时的路径一致）" << std::endl;
+                std::cout << "  --state-dir <目录>: 恢复数据目录，重新启动后无需重新校验（默认: torrent_state）" << std::endl;
+                std::cout << "  --pre-verify    : 没有恢复数据时先用多线程哈希引擎校验本地数据，校验完成后再开始做种" << std::endl;
                 return 1;
             }
             
@@ -775,6 +1426,14 @@ int main(int argc, char* argv[])
             std::cout << std::endl;
             
             TorrentManager& manager = TorrentManager::getInstance();
+            for (int i = 4; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--state-dir" && i + 1 < argc) {
+                    manager.set_state_dir(argv[++i]);
+                } else if (arg == "--pre-verify") {
+                    manager.set_verify_before_seeding(true);
+                }
+            }
             std::string seeding_hash = manager.start_seeding(torrent_path, save_path);
             if (seeding_hash.empty()) {
                 std::cerr << "启动做种失败" << std::endl;
@@ -787,16 +1446,15 @@ int main(int argc, char* argv[])
             std::cout << std::endl;
             
             // 主循环：保持做种状态并定期显示状态
-            int status_counter = 0;
+            auto next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
             while (manager.get_seeding_count() > 0) {
                 // 处理事件
                 manager.wait_and_process(1000);
                 
                 // 每 10 秒显示一次状态
-                status_counter++;
-                if (status_counter >= 10) {
+                if (std::chrono::steady_clock::now() >= next_status) {
                     manager.print_torrent_status(seeding_hash);
-                    status_counter = 0;
+                    next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
                 }
             }
             
@@ -807,34 +1465,103 @@ int main(int argc, char* argv[])
         // 原有模式：生成 torrent 文件
         std::string file_path;
         std::string output_path;
+        int hash_threads = 0;
+        int read_ahead = 4;
+        bool use_hash_cache = true;
+        bool direct_io = false;
+        TorrentVersion torrent_version = TorrentVersion::V1;
+        bool write_resume = false;
+        int scan_threads = 0;
+        bool sparse_aware = true;
+        std::string access_order_file;
+        bool pad_boot_files = false;
+        int checkpoint_interval = 60;
         
         if (argc >= 2) {
             file_path = argv[1];
-            if (argc >= 3) {
+            if (argc >= 3 && std::string(argv[2]).rfind("--", 0) != 0) {
                 output_path = argv[2];
             } else {
                 // 如果没有指定输出路径，使用默认名称
                 std::filesystem::path p(file_path);
                 output_path = p.filename().string() + ".torrent";
             }
+            
+            // 解析可选参数
+            for (int i = 2; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--hash-threads" && i + 1 < argc) {
+                    hash_threads = std::stoi(argv[++i]);
+                } else if (arg == "--read-ahead" && i + 1 < argc) {
+                    read_ahead = std::stoi(argv[++i]);
+                } else if (arg == "--sha-backend" && i + 1 < argc) {
+                    select_sha_backend(argv[++i]);
+                } else if (arg == "--no-hash-cache") {
+                    use_hash_cache = false;
+                } else if (arg == "--direct-io") {
+                    direct_io = true;
+                } else if (arg == "--v2") {
+                    torrent_version = TorrentVersion::V2;
+                } else if (arg == "--hybrid") {
+                    torrent_version = TorrentVersion::Hybrid;
+                } else if (arg == "--write-resume") {
+                    write_resume = true;
+                } else if (arg == "--scan-threads" && i + 1 < argc) {
+                    scan_threads = std::stoi(argv[++i]);
+                } else if (arg == "--no-sparse") {
+                    sparse_aware = false;
+                } else if (arg == "--access-order" && i + 1 < argc) {
+                    access_order_file = argv[++i];
+                } else if (arg == "--pad-boot-files") {
+                    pad_boot_files = true;
+                } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+                    checkpoint_interval = std::stoi(argv[++i]);
+                }
+            }
         } else {
             // 如果没有提供参数，显示用法
-            std::cout << "用法（生成 torrent）: " << argv[0] << " <文件或目录路径> [输出.torrent文件路径]" << std::endl;
+            std::cout << "用法（生成 torrent）: " << argv[0] << " <文件或目录路径> [输出.torrent文件路径] [选项]" << std::endl;
+            std::cout << "  选项: --hash-threads <N>  哈希计算线程数（默认: CPU 核心数）" << std::endl;
+            std::cout << "        --read-ahead <N>    读取阶段可提前填充的读取块数（默认: 4）" << std::endl;
+            std::cout << "        --scan-threads <N>  目录扫描线程数（默认: CPU 核心数，最多 16）" << std::endl;
+            std::cout << "        --direct-io         使用无缓冲 I/O 读取源文件，减少页缓存占用" << std::endl;
+            std::cout << "        --sha-backend <名称> 哈希后端: scalar, avx2, shani（默认: 自动检测）" << std::endl;
+            std::cout << "        --no-hash-cache     不使用分片哈希缓存（<输出>.hashcache），重新计算所有分片" << std::endl;
+            std::cout << "        --checkpoint-interval <秒> 哈希检查点间隔，失败后重新运行从检查点继续（默认: 60，0 表示关闭）" << std::endl;
+            std::cout << "        --v2                生成仅 v2 的 torrent（每个文件一棵 SHA256 默克尔树）" << std::endl;
+            std::cout << "        --hybrid            生成 v1 + v2 混合 torrent（兼容新旧客户端）" << std::endl;
+            std::cout << "        --write-resume      同时写入快速恢复数据（<输出>.resume），做种时无需重新校验" << std::endl;
+            std::cout << "        --no-sparse         不识别稀疏空洞和全零分片" << std::endl;
+            std::cout << "        --access-order <文件> 按启动访问跟踪/优先路径列表排列文件（仅 v1）" << std::endl;
+            std::cout << "        --pad-boot-files    插入 pad 文件，使前面的分片只包含启动数据" << std::endl;
             std::cout << std::endl;
             std::cout << "用法（直接做种）: " << argv[0] << " -s <torrent文件路径> <保存路径>" << std::endl;
             std::cout << std::endl;
             std::cout << "用法（多torrent做种）: " << argv[0] << " -m <torrent1> <保存路径1> [torrent2] [保存路径2] ..." << std::endl;
+            std::cout << "                      " << argv[0] << " -m --list <清单文件> [--state-dir <目录>]" << std::endl;
             std::cout << std::endl;
             std::cout << "用法（下载）    : " << argv[0] << " -d <torrent文件路径> <保存路径>" << std::endl;
             std::cout << std::endl;
             std::cout << "用法（TorrentManager测试）: " << argv[0] << " -t <测试模式>" << std::endl;
             std::cout << std::endl;
+            std::cout << "会话配置（-s/-d/-m/-t 均可使用）: --profile <wan|lan|low-memory|配置文件[:名称]>" << std::endl;
+            std::cout << "分类策略（所有模式均可使用）: --policy <配置文件>（替换内置的 small/large/standard 分类）" << std::endl;
+            std::cout << std::endl;
+            std::cout << "用法（校验）    : " << argv[0] << " -v <torrent文件路径> <保存路径> [选项]" << std::endl;
+            std::cout << std::endl;
+            std::cout << "用法（批量生成）: " << argv[0] << " -b <清单文件或镜像库目录> <输出目录> [选项]" << std::endl;
+            std::cout << std::endl;
+            std::cout << "用法（预取配置）: " << argv[0] << " -p <torrent文件路径> [跟踪文件或目录 ...] [--min-share <0-1>]" << std::endl;
+            std::cout << std::endl;
             std::cout << "示例:" << std::endl;
             std::cout << "  生成 torrent: " << argv[0] << " C:\\MyFiles\\example.txt example.torrent" << std::endl;
             std::cout << "  直接做种    : " << argv[0] << " -s example.torrent C:\\MyFiles" << std::endl;
             std::cout << "  多torrent做种: " << argv[0] << " -m torrent1.torrent C:\\Files1 torrent2.torrent C:\\Files2" << std::endl;
             std::cout << "  下载        : " << argv[0] << " -d example.torrent C:\\Downloads" << std::endl;
             std::cout << "  测试Manager : " << argv[0] << " -t basic example.torrent C:\\Downloads" << std::endl;
+            std::cout << "  校验        : " << argv[0] << " -v example.torrent C:\\MyFiles" << std::endl;
+            std::cout << "  批量生成    : " << argv[0] << " -b D:\\Images D:\\Torrents --jobs-per-disk 2" << std::endl;
+            std::cout << "  预取配置    : " << argv[0] << " -p example.torrent" << std::endl;
             std::cout << std::endl;
             
             std::cout << "请提供文件或目录路径作为参数" << std::endl;
@@ -851,21 +1578,24 @@ int main(int argc, char* argv[])
         // 1. 使用 BitTorrent 客户端打开 torrent 文件
         // 2. 开始做种（Seeding）
         // 3. 客户端会自动向 tracker 发送 announce 请求，tracker 会记录你的做种信息
-        std::vector<std::string> trackers = {
-            // 公共 tracker 示例（可以取消注释使用）:
-            // "udp://tracker.openbittorrent.com:80/announce",
-            // "udp://tracker.publicbt.com:80/announce",
-            // "udp://tracker.istole.it:80/announce",
-            // "http://tracker.bt-chat.com/announce",
-            "http://172.16.1.63:6880/announce",
-            "http://124.71.64.241:6969/announce",
-            "http://124.71.64.241:6880/announce",
-        };
-        builder.set_trackers(trackers);
+        builder.set_trackers(default_trackers());
         
         // 设置注释
         builder.set_comment("由 DisklessWorkstation 创建");
         
+        // 设置哈希计算并行度
+        builder.set_hash_threads(hash_threads);
+        builder.set_read_ahead(read_ahead);
+        builder.set_hash_cache(use_hash_cache);
+        builder.set_direct_io(direct_io);
+        builder.set_torrent_version(torrent_version);
+        builder.set_write_resume(write_resume);
+        builder.set_scan_threads(scan_threads);
+        builder.set_sparse_aware(sparse_aware);
+        builder.set_access_order_file(access_order_file);
+        builder.set_pad_boot_files(pad_boot_files);
+        builder.set_checkpoint_interval(checkpoint_interval);
+        
         // 生成 torrent 文件
         std::cout << "输入路径: " << file_path << std::endl;
         std::cout << "输出路径: " << output_path << std::endl;
@@ -918,16 +1648,15 @@ int main(int argc, char* argv[])
                 std::cout << std::endl;
                 
                 // 主循环：保持做种状态并定期显示状态
-                int status_counter = 0;
+                auto next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
                 while (manager.get_seeding_count() > 0) {
                     // 处理事件
                     manager.wait_and_process(1000);
                     
                     // 每 10 秒显示一次状态
-                    status_counter++;
-                    if (status_counter >= 10) {
+                    if (std::chrono::steady_clock::now() >= next_status) {
                         manager.print_torrent_status(seeding_hash);
-                        status_counter = 0;
+                        next_status = std::chrono::steady_clock::now() + std::chrono::seconds(10);
                     }
                 }
                 
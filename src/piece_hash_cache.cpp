@@ -0,0 +1,262 @@
+#include "piece_hash_cache.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <algorithm>
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/bdecode.hpp>
+#include <libtorrent/entry.hpp>
+
+// 缓存格式版本（格式变化时递增，旧缓存自动失效）
+static const int hash_cache_version = 1;
+
+PieceHashCache::PieceHashCache(const std::string& cache_path)
+    : cache_path_(cache_path)
+    , piece_length_(0)
+    , creation_date_(0)
+{
+}
+
+std::string PieceHashCache::file_key(const lt::file_storage& fs_storage, lt::file_index_t index)
+{
+    // pad 文件在磁盘上不存在，路径可能重复，用偏移区分
+    if (fs_storage.pad_file_at(index)) {
+        return ".pad@" + std::to_string(fs_storage.file_offset(index));
+    }
+    return fs_storage.file_path(index);
+}
+
+bool PieceHashCache::load()
+{
+    namespace fs = std::filesystem;
+
+    files_.clear();
+    hashes_.clear();
+    piece_roots_.clear();
+    valid_.clear();
+    piece_length_ = 0;
+    creation_date_ = 0;
+
+    try {
+        std::ifstream in(fs::u8path(cache_path_), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::vector<char> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        lt::error_code ec;
+        lt::bdecode_node root = lt::bdecode(buffer, ec);
+        if (ec || root.type() != lt::bdecode_node::dict_t) {
+            std::cerr << "警告: 哈希缓存文件格式错误，将重新计算所有分片: " << cache_path_ << std::endl;
+            return false;
+        }
+        if (root.dict_find_int_value("version", 0) != hash_cache_version) {
+            std::cout << "哈希缓存版本不匹配，将重新计算所有分片" << std::endl;
+            return false;
+        }
+
+        lt::bdecode_node files = root.dict_find_list("files");
+        if (!files) {
+            std::cerr << "警告: 哈希缓存文件内容不完整，将重新计算所有分片: " << cache_path_ << std::endl;
+            return false;
+        }
+
+        for (int i = 0; i < files.list_size(); ++i) {
+            lt::bdecode_node file = files.list_at(i);
+            if (file.type() != lt::bdecode_node::dict_t) continue;
+            FileStamp stamp;
+            stamp.size = file.dict_find_int_value("size", -1);
+            stamp.mtime = file.dict_find_int_value("mtime", -1);
+            stamp.offset = file.dict_find_int_value("offset", -1);
+            files_[std::string(file.dict_find_string_value("path"))] = stamp;
+        }
+
+        // SHA1 分片哈希（仅 v2 的 torrent 没有）
+        lt::bdecode_node pieces = root.dict_find_string("pieces");
+        if (pieces && pieces.string_length() % 20 == 0) {
+            const int count = pieces.string_length() / 20;
+            hashes_.reserve(count);
+            for (int i = 0; i < count; ++i) {
+                hashes_.push_back(lt::sha1_hash(pieces.string_ptr() + i * 20));
+            }
+        }
+
+        // v2 分片默克尔根（仅 v1 的 torrent 没有）
+        lt::bdecode_node roots = root.dict_find_string("piece roots");
+        if (roots && roots.string_length() % 32 == 0) {
+            const int count = roots.string_length() / 32;
+            piece_roots_.reserve(count);
+            for (int i = 0; i < count; ++i) {
+                piece_roots_.push_back(lt::sha256_hash(roots.string_ptr() + i * 32));
+            }
+        }
+
+        // 检查点：按位记录有效的分片（高位在前），完整保存的缓存没有该键
+        lt::bdecode_node valid = root.dict_find_string("valid pieces");
+        if (valid) {
+            valid_.assign(static_cast<size_t>(valid.string_length()) * 8, 0);
+            for (int i = 0; i < valid.string_length(); ++i) {
+                const unsigned char bits = static_cast<unsigned char>(valid.string_ptr()[i]);
+                for (int b = 0; b < 8; ++b) {
+                    valid_[static_cast<size_t>(i) * 8 + b] = (bits >> (7 - b)) & 1;
+                }
+            }
+            std::cout << "找到未完成的哈希检查点: " << std::count(valid_.begin(), valid_.end(), 1)
+                      << " 个分片已完成" << std::endl;
+        }
+
+        piece_length_ = static_cast<int>(root.dict_find_int_value("piece length", 0));
+        creation_date_ = static_cast<std::time_t>(root.dict_find_int_value("creation date", 0));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 读取哈希缓存失败: " << e.what() << std::endl;
+        files_.clear();
+        hashes_.clear();
+        piece_roots_.clear();
+        valid_.clear();
+        return false;
+    }
+}
+
+std::vector<lt::piece_index_t> PieceHashCache::match(const lt::file_storage& fs_storage, const std::string& root_path,
+                                                     std::vector<lt::sha1_hash>* hashes,
+                                                     std::vector<lt::sha256_hash>* piece_roots,
+                                                     const ScannedMtimes* scanned)
+{
+    namespace fs = std::filesystem;
+
+    const int num_files = fs_storage.num_files();
+    const int num_pieces = fs_storage.num_pieces();
+    if (hashes) {
+        hashes->assign(num_pieces, lt::sha1_hash());
+    }
+    if (piece_roots) {
+        piece_roots->assign(num_pieces, lt::sha256_hash());
+    }
+
+    // 记录当前文件状态，并判断每个文件是否与缓存一致
+    current_.assign(num_files, FileStamp());
+    std::vector<char> unchanged(num_files, 0);
+    const bool layout_matches = piece_length_ == fs_storage.piece_length();
+    for (int i = 0; i < num_files; ++i) {
+        lt::file_index_t index(i);
+        FileStamp& stamp = current_[i];
+        stamp.size = fs_storage.file_size(index);
+        stamp.offset = fs_storage.file_offset(index);
+        if (!fs_storage.pad_file_at(index) && !DirectoryScanner::find_mtime(scanned, fs_storage, index, stamp.mtime)) {
+            std::error_code ec;
+            auto mtime = fs::last_write_time(fs::u8path(fs_storage.file_path(index, root_path)), ec);
+            stamp.mtime = ec ? -1 : static_cast<std::int64_t>(mtime.time_since_epoch().count());
+        }
+
+        if (layout_matches && stamp.mtime >= 0) {
+            auto it = files_.find(file_key(fs_storage, index));
+            unchanged[i] = (it != files_.end() && it->second == stamp) ? 1 : 0;
+        }
+    }
+
+    // 分片覆盖的所有文件都未变化时才复用缓存的哈希
+    // 需要的哈希类型在缓存中缺失时（例如由 v1 改为混合模式），所有分片都需要重新计算
+    int cached_pieces = num_pieces;
+    if (hashes) cached_pieces = std::min(cached_pieces, static_cast<int>(hashes_.size()));
+    if (piece_roots) cached_pieces = std::min(cached_pieces, static_cast<int>(piece_roots_.size()));
+    std::vector<lt::piece_index_t> dirty;
+    for (int p = 0; p < num_pieces; ++p) {
+        lt::piece_index_t piece(p);
+        bool reusable = p < cached_pieces && (valid_.empty() || (p < static_cast<int>(valid_.size()) && valid_[p]));
+        if (reusable) {
+            for (const auto& slice : fs_storage.map_block(piece, 0, fs_storage.piece_size(piece))) {
+                if (!unchanged[static_cast<int>(slice.file_index)]) {
+                    reusable = false;
+                    break;
+                }
+            }
+        }
+        if (reusable) {
+            if (hashes) {
+                (*hashes)[p] = hashes_[p];
+            }
+            if (piece_roots) {
+                (*piece_roots)[p] = piece_roots_[p];
+            }
+        } else {
+            dirty.push_back(piece);
+        }
+    }
+    return dirty;
+}
+
+bool PieceHashCache::save(const lt::file_storage& fs_storage, const std::vector<lt::sha1_hash>* hashes,
+                          const std::vector<lt::sha256_hash>* piece_roots, std::time_t creation_date,
+                          const std::vector<char>* valid)
+{
+    namespace fs = std::filesystem;
+
+    try {
+        lt::entry cache(lt::entry::dictionary_t);
+        cache["version"] = hash_cache_version;
+        cache["piece length"] = fs_storage.piece_length();
+        cache["creation date"] = static_cast<std::int64_t>(creation_date);
+
+        lt::entry::list_type files;
+        for (int i = 0; i < fs_storage.num_files() && i < static_cast<int>(current_.size()); ++i) {
+            lt::entry file(lt::entry::dictionary_t);
+            file["path"] = file_key(fs_storage, lt::file_index_t(i));
+            file["size"] = current_[i].size;
+            file["mtime"] = current_[i].mtime;
+            file["offset"] = current_[i].offset;
+            files.push_back(std::move(file));
+        }
+        cache["files"] = std::move(files);
+
+        if (hashes) {
+            std::string pieces;
+            pieces.reserve(hashes->size() * 20);
+            for (const auto& hash : *hashes) {
+                pieces.append(hash.data(), hash.size());
+            }
+            cache["pieces"] = std::move(pieces);
+        }
+
+        if (piece_roots) {
+            std::string roots;
+            roots.reserve(piece_roots->size() * 32);
+            for (const auto& hash : *piece_roots) {
+                roots.append(hash.data(), hash.size());
+            }
+            cache["piece roots"] = std::move(roots);
+        }
+
+        if (valid) {
+            std::string bits((valid->size() + 7) / 8, '\0');
+            for (size_t p = 0; p < valid->size(); ++p) {
+                if ((*valid)[p]) bits[p / 8] = static_cast<char>(bits[p / 8] | (0x80 >> (p % 8)));
+            }
+            cache["valid pieces"] = std::move(bits);
+        }
+
+        std::vector<char> buffer;
+        lt::bencode(std::back_inserter(buffer), cache);
+
+        // 先写入临时文件再替换，避免中途失败留下损坏的缓存
+        std::string temp_path = cache_path_ + ".tmp";
+        {
+            std::ofstream out(fs::u8path(temp_path), std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "警告: 无法写入哈希缓存: " << temp_path << std::endl;
+                return false;
+            }
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!out) {
+                std::cerr << "警告: 写入哈希缓存失败: " << temp_path << std::endl;
+                return false;
+            }
+        }
+        fs::rename(fs::u8path(temp_path), fs::u8path(cache_path_));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 保存哈希缓存失败: " << e.what() << std::endl;
+        return false;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef PIECE_HASH_CACHE_HPP
+#define PIECE_HASH_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <cstdint>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/sha1_hash.hpp>
+#include "directory_scanner.hpp"
+
+// 分片哈希缓存（<输出>.hashcache 旁路文件）
+// 记录每个文件的相对路径、大小、修改时间和在 torrent 中的偏移，以及上次计算的分片哈希
+// 重新生成 torrent 时，只有所覆盖的文件全部未变化的分片才会复用缓存的哈希
+// 计算过程中定期以检查点形式保存已完成的分片（"valid pieces" 位图），中断或失败后重新生成时从中继续
+class PieceHashCache
+{
+public:
+    explicit PieceHashCache(const std::string& cache_path);
+
+    // 加载缓存文件，不存在或格式错误时返回 false（此时所有分片都需要重新计算）
+    bool load();
+
+    // 记录当前文件状态，并找出可复用的分片哈希
+    // hashes / piece_roots: 需要的 SHA1 分片哈希和 v2 分片默克尔根（为空表示不需要）
+    // 需要的哈希类型在缓存中缺失时，所有分片都需要重新计算
+    // scanned: 目录扫描时记录的修改时间（可为空，未记录的文件直接读取文件系统）
+    // 返回: 需要重新计算的分片列表（升序）
+    std::vector<lt::piece_index_t> match(const lt::file_storage& fs_storage, const std::string& root_path,
+                                         std::vector<lt::sha1_hash>* hashes,
+                                         std::vector<lt::sha256_hash>* piece_roots,
+                                         const ScannedMtimes* scanned = nullptr);
+
+    // 保存缓存（文件状态使用 match 时记录的值，为空的哈希类型不保存）
+    // valid: 检查点中哪些分片的哈希有效（为空表示全部有效），无效分片下次重新计算
+    bool save(const lt::file_storage& fs_storage, const std::vector<lt::sha1_hash>* hashes,
+              const std::vector<lt::sha256_hash>* piece_roots, std::time_t creation_date,
+              const std::vector<char>* valid = nullptr);
+
+    // 上次生成 torrent 时使用的创建时间（未加载缓存时为 0）
+    inline std::time_t creation_date() const { return creation_date_; }
+
+    // 获取缓存文件路径
+    inline const std::string& path() const { return cache_path_; }
+
+private:
+    // 文件状态
+    struct FileStamp {
+        std::int64_t size = 0;     // 文件大小
+        std::int64_t mtime = 0;    // 修改时间（文件系统时钟计数）
+        std::int64_t offset = 0;   // 在 torrent 中的偏移
+        bool operator==(const FileStamp& other) const
+        {
+            return size == other.size && mtime == other.mtime && offset == other.offset;
+        }
+    };
+
+    // 获取文件在缓存中的键（pad 文件按偏移区分）
+    static std::string file_key(const lt::file_storage& fs_storage, lt::file_index_t index);
+
+private:
+    std::string cache_path_;                       // 缓存文件路径
+    int piece_length_;                             // 缓存对应的分片大小
+    std::time_t creation_date_;                    // 缓存对应的创建时间
+    std::map<std::string, FileStamp> files_;       // 缓存中的文件状态（以相对路径为键）
+    std::vector<lt::sha1_hash> hashes_;            // 缓存中的分片哈希
+    std::vector<lt::sha256_hash> piece_roots_;     // 缓存中的 v2 分片默克尔根（可能为空）
+    std::vector<char> valid_;                      // 检查点中有效的分片（为空表示全部有效）
+    std::vector<FileStamp> current_;               // match 时记录的当前文件状态（按文件下标）
+};
+
+#endif // PIECE_HASH_CACHE_HPP
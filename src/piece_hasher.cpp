@@ -0,0 +1,725 @@
+#include "piece_hasher.hpp"
+#include "sha_backend.hpp"
+#include "raw_file.hpp"
+#include <iostream>
+#include <memory>
+#include <cstdint>
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+// 有界阻塞队列：用于读取线程与哈希线程之间传递分片缓冲区
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+    // 放入元素，队列已满时阻塞；队列关闭后返回 false
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // 取出元素，队列为空时阻塞；队列关闭且已取空时返回 false
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // 非阻塞取出元素，队列为空时立即返回 false
+    bool try_pop(T& item)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // 关闭队列，唤醒所有等待的线程
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    std::deque<T> items_;
+    size_t capacity_;
+    bool closed_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// 读取块：一段连续分片的数据，在读取阶段与哈希线程之间通过环形缓冲区循环使用
+struct Chunk {
+    int begin = 0;             // 在分片列表中的起始下标
+    int count = 0;             // 分片数量
+    AlignedBuffer buffer;      // 分片数据（第 k 个分片位于 k * piece_length 处）
+    std::vector<char> ok;      // 每个分片是否读取成功（仅在跳过无法读取的分片时可能为 0）
+    std::vector<char> zero;    // 每个分片是否位于稀疏空洞中（未读取，内容全部为 0）
+};
+
+// 顺序读取连续分片的文件读取器（读取阶段独占，缓存当前打开的文件）
+// 偏移和缓冲区均对齐时使用无缓冲句柄整段读取，否则退回普通句柄
+class ChunkReader
+{
+public:
+    ChunkReader(const lt::file_storage& fs_storage, const std::string& root_path, bool unbuffered)
+        : fs_storage_(fs_storage), root_path_(root_path), unbuffered_(unbuffered)
+        , direct_file_index_(-1), buffered_file_index_(-1) {}
+
+    // 读取从 first 开始、共 bytes 字节的连续分片，失败时抛出 std::runtime_error
+    // out 需在 bytes 之后额外保留 RawFile::alignment 字节（无缓冲读取会按对齐长度写入）
+    void read_range(lt::piece_index_t first, std::int64_t bytes, char* out)
+    {
+        std::vector<lt::file_slice> slices = fs_storage_.map_block(first, 0, bytes);
+        for (const auto& slice : slices) {
+            // pad 文件不存在于磁盘上，内容全部为 0
+            if (fs_storage_.pad_file_at(slice.file_index)) {
+                std::memset(out, 0, static_cast<size_t>(slice.size));
+            } else {
+                read_slice(slice, out);
+            }
+            out += slice.size;
+        }
+    }
+
+    // 检查分片覆盖的所有文件区域是否都是稀疏空洞（pad 文件视为空洞），无法确定时返回 false
+    bool piece_is_hole(lt::piece_index_t piece)
+    {
+        for (const auto& slice : fs_storage_.map_block(piece, 0, fs_storage_.piece_size(piece))) {
+            if (fs_storage_.pad_file_at(slice.file_index)) continue;
+            if (buffered_file_index_ != static_cast<int>(slice.file_index) || !buffered_file_.is_open()) {
+                std::string path = fs_storage_.file_path(slice.file_index, root_path_);
+                buffered_file_index_ = buffered_file_.open(path, false) ? static_cast<int>(slice.file_index) : -1;
+            }
+            if (buffered_file_index_ < 0 || !buffered_file_.is_hole(slice.offset, slice.size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    void read_slice(const lt::file_slice& slice, char* out)
+    {
+        namespace fs = std::filesystem;
+        const int max_retries = 3;
+        const std::int64_t align = static_cast<std::int64_t>(RawFile::alignment);
+        const bool aligned = unbuffered_ && slice.offset % align == 0 &&
+                             reinterpret_cast<std::uintptr_t>(out) % RawFile::alignment == 0;
+        RawFile& file = aligned ? direct_file_ : buffered_file_;
+        int& file_index = aligned ? direct_file_index_ : buffered_file_index_;
+
+        for (int attempt = 1; ; ++attempt) {
+            std::string path = fs_storage_.file_path(slice.file_index, root_path_);
+            if (file_index != static_cast<int>(slice.file_index) || !file.is_open()) {
+                file_index = file.open(path, aligned) ? static_cast<int>(slice.file_index) : -1;
+
+                // 文件不存在时重试没有意义
+                std::error_code ec;
+                if (file_index < 0 && !fs::exists(fs::u8path(path), ec)) {
+                    throw std::runtime_error("文件不存在: " + path);
+                }
+            }
+
+            if (file.is_open()) {
+                // 无缓冲读取的长度必须对齐，多读的部分会被后续数据覆盖
+                std::int64_t length = file.is_unbuffered() ? (slice.size + align - 1) / align * align : slice.size;
+                std::int64_t n = file.read_at(slice.offset, out, length);
+                if (n >= slice.size) {
+                    // 数据已复制到缓冲区，立即释放页缓存，避免挤占镜像服务器内存
+                    file.drop_cache(slice.offset, slice.size);
+                    return;
+                }
+            }
+
+            // 读取失败（可能是 Windows 错误 995 等临时 I/O 中断），关闭文件后重试
+            file.close();
+            file_index = -1;
+            if (attempt >= max_retries) {
+                throw std::runtime_error("读取文件失败: " + path);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+    }
+
+private:
+    const lt::file_storage& fs_storage_;
+    std::string root_path_;
+    bool unbuffered_;
+    RawFile direct_file_;       // 无缓冲句柄（对齐读取）
+    RawFile buffered_file_;     // 普通句柄（未对齐的读取）
+    int direct_file_index_;
+    int buffered_file_index_;
+};
+
+// BitTorrent v2 默克尔树的叶子块大小（16KiB）
+const int v2_block_size = 16 * 1024;
+
+// 不小于 n 的最小 2 的幂（默克尔树叶子数）
+int merkle_num_leafs(int n)
+{
+    int leafs = 1;
+    while (leafs < n) leafs <<= 1;
+    return leafs;
+}
+
+// 计算默克尔树根：叶子不足时用全零哈希补齐到 num_leafs 个
+lt::sha256_hash merkle_root(std::vector<lt::sha256_hash> nodes, int num_leafs)
+{
+    nodes.resize(num_leafs);
+    char pair[64];
+    while (nodes.size() > 1) {
+        for (size_t i = 0; i < nodes.size() / 2; ++i) {
+            std::memcpy(pair, nodes[2 * i].data(), 32);
+            std::memcpy(pair + 32, nodes[2 * i + 1].data(), 32);
+            nodes[i] = ShaBackend::sha256(pair, sizeof(pair));
+        }
+        nodes.resize(nodes.size() / 2);
+    }
+    return nodes.front();
+}
+
+// 计算 v2 分片的形状：分片中属于文件的字节数，以及默克尔树补齐后的叶子数
+// 多分片文件的每个分片补齐到整个分片的叶子数；单分片文件只补齐到自身块数的 2 的幂
+void v2_piece_shape(const lt::file_storage& fs_storage, lt::piece_index_t piece, int& file_part, int& num_leafs)
+{
+    const lt::file_index_t file = fs_storage.file_index_at_piece(piece);
+    const int piece_in_file = static_cast<int>(piece) - static_cast<int>(fs_storage.piece_index_at_file(file));
+    const std::int64_t file_offset = static_cast<std::int64_t>(piece_in_file) * fs_storage.piece_length();
+    file_part = static_cast<int>(std::min<std::int64_t>(fs_storage.piece_length(), fs_storage.file_size(file) - file_offset));
+    const int blocks_per_piece = fs_storage.piece_length() / v2_block_size;
+    num_leafs = std::min(merkle_num_leafs(fs_storage.file_num_blocks(file)), blocks_per_piece);
+}
+
+// 计算 v2 分片（piece layer 中的一个节点）的默克尔根
+// v2 布局中每个文件都从分片边界开始，分片数据只属于一个文件（尾部为 pad 文件填充）
+lt::sha256_hash v2_piece_root(int file_part, int num_leafs, const char* data)
+{
+    // 每个 16KiB 块一个叶子，最后一个块按实际长度计算
+    const int full_blocks = file_part / v2_block_size;
+    const int tail = file_part % v2_block_size;
+    std::vector<lt::sha256_hash> leafs(full_blocks + (tail > 0 ? 1 : 0));
+    std::vector<const char*> blocks(full_blocks);
+    for (int b = 0; b < full_blocks; ++b) {
+        blocks[b] = data + static_cast<std::int64_t>(b) * v2_block_size;
+    }
+    if (full_blocks > 0) {
+        ShaBackend::sha256_multi(blocks.data(), v2_block_size, full_blocks, leafs.data());
+    }
+    if (tail > 0) {
+        leafs[full_blocks] = ShaBackend::sha256(data + static_cast<std::int64_t>(full_blocks) * v2_block_size, tail);
+    }
+    return merkle_root(std::move(leafs), num_leafs);
+}
+
+lt::sha256_hash v2_piece_root(const lt::file_storage& fs_storage, lt::piece_index_t piece, const char* data)
+{
+    int file_part = 0;
+    int num_leafs = 0;
+    v2_piece_shape(fs_storage, piece, file_part, num_leafs);
+    return v2_piece_root(file_part, num_leafs, data);
+}
+
+// 检查数据是否全部为 0（比计算哈希快得多）
+bool is_all_zero(const char* data, std::int64_t size)
+{
+    if (size <= 0) return true;
+    return data[0] == 0 && std::memcmp(data, data + 1, static_cast<size_t>(size - 1)) == 0;
+}
+
+} // namespace
+
+// 全零分片的哈希缓存：稀疏镜像中大量分片内容相同（全部为 0），只需计算一次
+class ZeroHashCache
+{
+public:
+    explicit ZeroHashCache(const lt::file_storage& fs_storage) : fs_storage_(fs_storage) {}
+
+    // 长度为 size 的全零数据的 SHA1
+    lt::sha1_hash sha1(int size)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sha1_.find(size);
+        if (it != sha1_.end()) return it->second;
+        lt::sha1_hash hash = ShaBackend::sha1(zeros(size), size);
+        sha1_[size] = hash;
+        return hash;
+    }
+
+    // 全零分片的 v2 默克尔根
+    lt::sha256_hash piece_root(lt::piece_index_t piece)
+    {
+        int file_part = 0;
+        int num_leafs = 0;
+        v2_piece_shape(fs_storage_, piece, file_part, num_leafs);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto key = std::make_pair(file_part, num_leafs);
+        auto it = roots_.find(key);
+        if (it != roots_.end()) return it->second;
+        lt::sha256_hash root = v2_piece_root(file_part, num_leafs, zeros(file_part));
+        roots_[key] = root;
+        return root;
+    }
+
+private:
+    const char* zeros(int size)
+    {
+        if (static_cast<int>(zeros_.size()) < size) {
+            zeros_.assign(size, 0);
+        }
+        return zeros_.data();
+    }
+
+private:
+    const lt::file_storage& fs_storage_;
+    std::mutex mutex_;
+    std::vector<char> zeros_;
+    std::map<int, lt::sha1_hash> sha1_;
+    std::map<std::pair<int, int>, lt::sha256_hash> roots_;
+};
+
+PieceHasher::PieceHasher(const lt::file_storage& fs_storage, const std::string& root_path)
+    : fs_storage_(fs_storage)
+    , root_path_(root_path)
+    , threads_(0)  // 0 表示使用 CPU 核心数
+    , read_ahead_(4)
+    , read_block_size_(8 * 1024 * 1024)
+    , unbuffered_(false)
+    , compute_v1_(true)
+    , skip_unreadable_(false)
+    , sparse_aware_(true)
+    , quiet_(false)
+    , hole_bytes_(0)
+    , zero_pieces_(0)
+    , zero_hashes_(std::make_unique<ZeroHashCache>(fs_storage))
+    , checkpoint_interval_(60)
+{
+}
+
+PieceHasher::~PieceHasher()
+{
+}
+
+lt::sha1_hash PieceHasher::zero_hash(lt::piece_index_t piece)
+{
+    return zero_hashes_->sha1(fs_storage_.piece_size(piece));
+}
+
+lt::sha256_hash PieceHasher::zero_piece_root(lt::piece_index_t piece)
+{
+    return zero_hashes_->piece_root(piece);
+}
+
+void PieceHasher::hash_all(std::vector<lt::sha1_hash>& hashes, std::vector<lt::sha256_hash>* piece_roots)
+{
+    std::vector<lt::piece_index_t> pieces;
+    pieces.reserve(fs_storage_.num_pieces());
+    for (int p = 0; p < fs_storage_.num_pieces(); ++p) {
+        pieces.push_back(lt::piece_index_t(p));
+    }
+    hash_pieces(pieces, hashes, piece_roots);
+}
+
+void PieceHasher::hash_pieces(const std::vector<lt::piece_index_t>& pieces, std::vector<lt::sha1_hash>& hashes,
+                              std::vector<lt::sha256_hash>* piece_roots)
+{
+    hashes.resize(fs_storage_.num_pieces());
+    if (piece_roots) {
+        piece_roots->resize(fs_storage_.num_pieces());
+    }
+    unreadable_.assign(fs_storage_.num_pieces(), 0);
+    zero_.assign(fs_storage_.num_pieces(), 0);
+    hole_bytes_ = 0;
+    zero_pieces_ = 0;
+
+    const int num_pieces = static_cast<int>(pieces.size());
+    if (num_pieces <= 0) {
+        return;
+    }
+
+    // 确定哈希线程数（读取由单独的读取阶段完成）
+    int num_workers = threads_;
+    if (num_workers <= 0) {
+        num_workers = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_workers <= 0) num_workers = 4;
+    }
+    num_workers = std::min(num_workers, num_pieces);
+
+    // 读取块由若干连续分片组成，大小按读取块大小取整
+    const int piece_length = fs_storage_.piece_length();
+    const int chunk_pieces = std::max(1, read_block_size_ / piece_length);
+    const std::int64_t chunk_bytes = static_cast<std::int64_t>(chunk_pieces) * piece_length;
+
+    // 环形缓冲区：每个哈希线程至少能凑齐一个批次，另外预留 read_ahead 个块供读取阶段提前填充
+    const ShaBackend::Type backend = ShaBackend::active();
+    const int batch_size = ShaBackend::preferred_batch();
+    const int chunks_per_batch = (batch_size + chunk_pieces - 1) / chunk_pieces;
+    const int ring_size = num_workers * chunks_per_batch + std::max(1, read_ahead_);
+
+    if (!quiet_) {
+        std::cout << "哈希线程数: " << num_workers << "，哈希后端: " << ShaBackend::name(backend)
+                  << "，哈希类型: " << (compute_v1_ ? "SHA1" : "") << (compute_v1_ && piece_roots ? " + " : "")
+                  << (piece_roots ? "SHA256 默克尔树" : "") << std::endl;
+        std::cout << "读取块大小: " << (chunk_bytes / 1024 / 1024) << " MB，环形缓冲区: " << ring_size
+                  << " 块，无缓冲 I/O: " << (unbuffered_ ? "是" : "否") << std::endl;
+    }
+
+    std::int64_t total_size = 0;
+    for (lt::piece_index_t p : pieces) {
+        total_size += fs_storage_.piece_size(p);
+    }
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    BoundedQueue<Chunk*> free_chunks(ring_size);
+    BoundedQueue<Chunk*> filled_chunks(ring_size);
+    for (int i = 0; i < ring_size; ++i) {
+        chunks.push_back(std::make_unique<Chunk>());
+        chunks.back()->buffer = AlignedBuffer(static_cast<size_t>(chunk_bytes) + RawFile::alignment);
+        free_chunks.push(chunks.back().get());
+    }
+
+    std::atomic<std::int64_t> bytes_hashed(0);
+    std::atomic<std::int64_t> hole_bytes(0);
+    std::atomic<int> zero_pieces(0);
+    std::atomic<int> finished_workers(0);
+    std::atomic<bool> aborted(false);
+    std::mutex error_mutex;
+    std::string error_message;
+
+    // 已完成的分片（哈希线程在计算完成后标记，检查点回调据此只读取已完成分片的哈希）
+    std::mutex completed_mutex;
+    std::vector<char> completed(fs_storage_.num_pieces(), 0);
+    auto take_checkpoint = [&]() {
+        std::vector<char> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(completed_mutex);
+            snapshot = completed;
+        }
+        checkpoint_(snapshot);
+    };
+
+    auto fail = [&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error_message.empty()) {
+            error_message = message;
+        }
+        aborted = true;
+    };
+
+    // 读取阶段：按顺序将连续分片整段读入读取块，保持磁盘队列满载
+    std::thread reader([&]() {
+        try {
+            ChunkReader chunk_reader(fs_storage_, root_path_, unbuffered_);
+            int i = 0;
+            while (i < num_pieces && !aborted) {
+                Chunk* chunk = nullptr;
+                if (!free_chunks.pop(chunk)) break;
+
+                // 合并分片列表中相邻且连续的分片
+                chunk->begin = i;
+                chunk->count = 1;
+                std::int64_t bytes = fs_storage_.piece_size(pieces[i]);
+                while (chunk->count < chunk_pieces && i + chunk->count < num_pieces &&
+                       static_cast<int>(pieces[i + chunk->count]) == static_cast<int>(pieces[i + chunk->count - 1]) + 1) {
+                    bytes += fs_storage_.piece_size(pieces[i + chunk->count]);
+                    ++chunk->count;
+                }
+                chunk->ok.assign(chunk->count, 1);
+                chunk->zero.assign(chunk->count, 0);
+
+                // 稀疏空洞中的分片不读取，直接使用全零分片的哈希
+                if (sparse_aware_) {
+                    for (int k = 0; k < chunk->count; ++k) {
+                        if (chunk_reader.piece_is_hole(pieces[i + k])) {
+                            chunk->zero[k] = 1;
+                            hole_bytes += fs_storage_.piece_size(pieces[i + k]);
+                        }
+                    }
+                }
+
+                // 读取非空洞的连续分片段
+                for (int k = 0; k < chunk->count; ) {
+                    if (chunk->zero[k]) {
+                        ++k;
+                        continue;
+                    }
+                    int end = k;
+                    std::int64_t run_bytes = 0;
+                    while (end < chunk->count && !chunk->zero[end]) {
+                        run_bytes += fs_storage_.piece_size(pieces[i + end]);
+                        ++end;
+                    }
+                    char* out = chunk->buffer.data() + static_cast<std::int64_t>(k) * piece_length;
+                    try {
+                        chunk_reader.read_range(pieces[i + k], run_bytes, out);
+                    } catch (const std::exception&) {
+                        if (!skip_unreadable_) throw;
+                        // 逐个分片重新读取，只标记真正无法读取的分片
+                        for (int r = k; r < end; ++r) {
+                            try {
+                                chunk_reader.read_range(pieces[i + r], fs_storage_.piece_size(pieces[i + r]),
+                                                        chunk->buffer.data() + static_cast<std::int64_t>(r) * piece_length);
+                            } catch (const std::exception&) {
+                                chunk->ok[r] = 0;
+                            }
+                        }
+                    }
+                    k = end;
+                }
+
+                i += chunk->count;
+                if (!filled_chunks.push(chunk)) break;
+            }
+        } catch (const std::exception& e) {
+            fail(e.what());
+        }
+        filled_chunks.close();
+    });
+
+    // 计算一组读取块中所有分片的哈希：长度相同的分片交给多缓冲后端一次完成，其余逐个计算
+    auto hash_chunks = [&](const std::vector<Chunk*>& held) {
+        std::vector<const char*> data;
+        std::vector<int> targets;
+        for (Chunk* chunk : held) {
+            for (int k = 0; k < chunk->count; ++k) {
+                lt::piece_index_t piece = pieces[chunk->begin + k];
+                int p = static_cast<int>(piece);
+                int size = fs_storage_.piece_size(piece);
+                const char* ptr = chunk->buffer.data() + static_cast<std::int64_t>(k) * piece_length;
+                if (!chunk->ok[k]) {
+                    unreadable_[p] = 1;
+                    hashes[p].clear();
+                    if (piece_roots) (*piece_roots)[p].clear();
+                    bytes_hashed += size;
+                    continue;
+                }
+                // 稀疏空洞或内容全零的分片使用缓存的全零哈希
+                if (chunk->zero[k] || is_all_zero(ptr, size)) {
+                    zero_[p] = 1;
+                    ++zero_pieces;
+                    if (compute_v1_) hashes[p] = zero_hashes_->sha1(size);
+                    if (piece_roots) (*piece_roots)[p] = zero_hashes_->piece_root(piece);
+                    bytes_hashed += size;
+                    continue;
+                }
+                if (piece_roots) {
+                    (*piece_roots)[p] = v2_piece_root(fs_storage_, piece, ptr);
+                }
+                if (!compute_v1_) {
+                    // 仅 v2：不需要 SHA1 分片哈希
+                } else if (size == piece_length) {
+                    data.push_back(ptr);
+                    targets.push_back(p);
+                } else {
+                    hashes[p] = ShaBackend::sha1(ptr, size);
+                }
+                bytes_hashed += size;
+            }
+        }
+        if (!data.empty()) {
+            std::vector<lt::sha1_hash> out(data.size());
+            ShaBackend::sha1_multi(data.data(), piece_length, static_cast<int>(data.size()), out.data());
+            for (size_t i = 0; i < targets.size(); ++i) {
+                hashes[targets[i]] = out[i];
+            }
+        }
+    };
+
+    // 哈希线程：从环形缓冲区取出读取块（凑齐一个批次），计算后归还
+    auto worker = [&]() {
+        std::vector<Chunk*> held;
+        Chunk* chunk = nullptr;
+        while (filled_chunks.pop(chunk)) {
+            held.clear();
+            held.push_back(chunk);
+            int held_pieces = chunk->count;
+            while (held_pieces < batch_size && filled_chunks.try_pop(chunk)) {
+                held.push_back(chunk);
+                held_pieces += chunk->count;
+            }
+            if (!aborted) {
+                hash_chunks(held);
+                if (checkpoint_) {
+                    std::lock_guard<std::mutex> lock(completed_mutex);
+                    for (Chunk* done : held) {
+                        for (int k = 0; k < done->count; ++k) {
+                            if (done->ok[k]) completed[static_cast<int>(pieces[done->begin + k])] = 1;
+                        }
+                    }
+                }
+            }
+            for (Chunk* done : held) {
+                free_chunks.push(done);
+            }
+        }
+        ++finished_workers;
+    };
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < num_workers; ++w) {
+        workers.emplace_back(worker);
+    }
+
+    // 主线程定期输出进度和总吞吐量，并按间隔保存检查点
+    auto last_checkpoint = start_time;
+    while (finished_workers < num_workers) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        auto now = std::chrono::steady_clock::now();
+        if (checkpoint_ && checkpoint_interval_ > 0 && !aborted &&
+            now - last_checkpoint >= std::chrono::seconds(checkpoint_interval_)) {
+            take_checkpoint();
+            last_checkpoint = now;
+        }
+        std::int64_t done = bytes_hashed;
+        if (progress_) {
+            progress_(done, total_size);
+            continue;
+        }
+        if (quiet_) {
+            continue;
+        }
+        double elapsed = std::chrono::duration<double>(now - start_time).count();
+        double mb_per_sec = elapsed > 0 ? done / 1024.0 / 1024.0 / elapsed : 0.0;
+        char line[128];
+        snprintf(line, sizeof(line), "\r正在处理中: %.1f%%  速度: %.1f MB/s    ",
+                 total_size > 0 ? done * 100.0 / total_size : 100.0, mb_per_sec);
+        std::cout << line << std::flush;
+    }
+
+    for (auto& t : workers) {
+        t.join();
+    }
+    free_chunks.close();
+    reader.join();
+    if (progress_) {
+        progress_(bytes_hashed, total_size);
+    } else if (!quiet_) {
+        std::cout << std::endl;
+    }
+
+    if (aborted) {
+        // 保存中止前已完成的分片，重新生成时只需计算剩余部分
+        if (checkpoint_) {
+            take_checkpoint();
+        }
+        throw std::runtime_error(error_message.empty() ? "哈希计算被中止" : error_message);
+    }
+
+    hole_bytes_ = hole_bytes;
+    zero_pieces_ = zero_pieces;
+    if (quiet_) {
+        return;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    char summary[128];
+    snprintf(summary, sizeof(summary), "哈希计算耗时: %.1f 秒，平均速度: %.1f MB/s",
+             elapsed, elapsed > 0 ? total_size / 1024.0 / 1024.0 / elapsed : 0.0);
+    std::cout << summary << std::endl;
+    if (zero_pieces_ > 0) {
+        snprintf(summary, sizeof(summary), "全零分片: %d 个，稀疏空洞跳过读取: %.1f MB",
+                 zero_pieces_, hole_bytes_ / 1024.0 / 1024.0);
+        std::cout << summary << std::endl;
+    }
+}
+
+int PieceHasher::verify(const lt::torrent_info& ti, std::vector<bool>& piece_ok)
+{
+    const int num_pieces = ti.num_pieces();
+    piece_ok.assign(num_pieces, false);
+
+    // 含 v1 哈希时按 SHA1 校验，仅 v2 的 torrent 按 piece layer 中的默克尔根校验
+    const bool use_v1 = ti.info_hashes().has_v1();
+
+    // 校验时缺失或损坏的文件只影响对应分片，不中止整个过程
+    bool skip_unreadable = skip_unreadable_;
+    bool compute_v1 = compute_v1_;
+    skip_unreadable_ = true;
+    compute_v1_ = use_v1;
+    std::vector<lt::sha1_hash> hashes;
+    std::vector<lt::sha256_hash> piece_roots;
+    try {
+        hash_all(hashes, use_v1 ? nullptr : &piece_roots);
+    } catch (...) {
+        skip_unreadable_ = skip_unreadable;
+        compute_v1_ = compute_v1;
+        throw;
+    }
+    skip_unreadable_ = skip_unreadable;
+    compute_v1_ = compute_v1;
+
+    if (use_v1) {
+        for (int p = 0; p < num_pieces; ++p) {
+            lt::piece_index_t piece(p);
+            piece_ok[p] = !is_unreadable(piece) && hashes[p] == ti.hash_for_piece(piece);
+        }
+    } else {
+        const lt::file_storage& files = ti.files();
+        for (int f = 0; f < files.num_files(); ++f) {
+            lt::file_index_t file(f);
+            if (files.pad_file_at(file) || files.file_size(file) == 0) continue;
+            const int first = static_cast<int>(files.piece_index_at_file(file));
+            const int count = files.file_num_pieces(file);
+            const std::vector<lt::sha256_hash> layer = file_piece_roots(ti, file);
+            for (int k = 0; k < count && k < static_cast<int>(layer.size()); ++k) {
+                lt::piece_index_t piece(first + k);
+                piece_ok[first + k] = !is_unreadable(piece) && piece_roots[first + k] == layer[k];
+            }
+        }
+    }
+
+    int failed = 0;
+    for (int p = 0; p < num_pieces; ++p) {
+        if (!piece_ok[p]) {
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+std::vector<lt::sha256_hash> PieceHasher::file_piece_roots(const lt::torrent_info& ti, lt::file_index_t file)
+{
+    const lt::file_storage& files = ti.files();
+    if (files.file_num_pieces(file) == 1) {
+        return std::vector<lt::sha256_hash>(1, files.root(file));
+    }
+    const lt::span<char const> layer = ti.piece_layer(file);
+    const std::ptrdiff_t count = layer.size() / static_cast<std::ptrdiff_t>(lt::sha256_hash::size());
+    std::vector<lt::sha256_hash> roots;
+    roots.reserve(static_cast<size_t>(count));
+    for (std::ptrdiff_t i = 0; i < count; ++i) {
+        roots.emplace_back(layer.data() + i * static_cast<std::ptrdiff_t>(lt::sha256_hash::size()));
+    }
+    return roots;
+}
@@ -0,0 +1,127 @@
+#ifndef PIECE_HASHER_HPP
+#define PIECE_HASHER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/sha1_hash.hpp>
+
+class ZeroHashCache;
+
+// 分片哈希引擎
+// 单独的读取阶段按顺序以大块对齐读取连续分片，通过有界环形缓冲区交给多个哈希线程
+// 哈希计算使用 ShaBackend（SHA-NI / AVX2 多缓冲 / 标量），多缓冲后端一次计算多个分片
+// 稀疏空洞中的分片不读取，内容全零的分片不计算，二者都直接使用缓存的全零分片哈希
+class PieceHasher
+{
+public:
+    // fs_storage: 文件存储（需在 PieceHasher 生命周期内有效）
+    // root_path: 文件所在的根路径（与 fs_storage 中的相对路径拼接）
+    PieceHasher(const lt::file_storage& fs_storage, const std::string& root_path);
+    ~PieceHasher();
+
+    // 设置工作线程数，0 表示使用 CPU 核心数
+    inline void set_threads(int threads) { threads_ = threads; }
+
+    // 设置读取阶段可提前填充的读取块数量（环形缓冲区在哈希线程所需之外的余量）
+    inline void set_read_ahead(int blocks) { read_ahead_ = blocks; }
+
+    // 设置单次读取的块大小（字节，按分片大小取整，至少一个分片）
+    inline void set_read_block_size(int bytes) { read_block_size_ = bytes; }
+
+    // 设置是否使用无缓冲 I/O（Windows: FILE_FLAG_NO_BUFFERING，Linux: O_DIRECT）
+    // 关闭时读取后立即释放页缓存
+    inline void set_unbuffered(bool unbuffered) { unbuffered_ = unbuffered; }
+
+    // 设置是否计算 SHA1 分片哈希（仅 v2 的 torrent 不需要），默认计算
+    inline void set_v1(bool enabled) { compute_v1_ = enabled; }
+
+    // 设置是否查询稀疏空洞（SEEK_DATA / FSCTL_QUERY_ALLOCATED_RANGES）并跳过读取，默认开启
+    inline void set_sparse_aware(bool enabled) { sparse_aware_ = enabled; }
+    
+    // 读取失败时是否跳过该分片继续计算（校验模式使用），默认直接中止
+    inline void set_skip_unreadable(bool skip) { skip_unreadable_ = skip; }
+    
+    // 设置安静模式：不输出线程数、耗时等信息（多个任务同时计算时由调用方统一输出）
+    inline void set_quiet(bool quiet) { quiet_ = quiet; }
+    
+    // 设置进度回调：计算期间每 500 毫秒调用一次（done / total 为已计算 / 需计算的字节数），设置后不再输出进度行
+    inline void set_progress(std::function<void(std::int64_t done, std::int64_t total)> callback)
+    {
+        progress_ = std::move(callback);
+    }
+
+    // 设置检查点回调：计算期间每隔 interval_seconds 秒调用一次，失败中止时再调用一次
+    // completed 标记已计算完成的分片（按分片下标），回调中只能读取这些分片的哈希（其余分片可能正在写入）
+    inline void set_checkpoint(std::function<void(const std::vector<char>& completed)> callback, int interval_seconds)
+    {
+        checkpoint_ = std::move(callback);
+        checkpoint_interval_ = interval_seconds;
+    }
+
+    // 计算指定分片（升序排列）的 SHA1 哈希，结果写入 hashes[piece]
+    // piece_roots 非空时同时计算 v2 分片的 SHA256 默克尔根（要求文件按分片边界对齐）
+    // hashes / piece_roots 会被调整为分片总数大小；失败时抛出 std::runtime_error
+    void hash_pieces(const std::vector<lt::piece_index_t>& pieces, std::vector<lt::sha1_hash>& hashes,
+                     std::vector<lt::sha256_hash>* piece_roots = nullptr);
+
+    // 计算所有分片的哈希
+    void hash_all(std::vector<lt::sha1_hash>& hashes, std::vector<lt::sha256_hash>* piece_roots = nullptr);
+
+    // 校验磁盘数据与 torrent 中记录的分片哈希（v1 或仅 v2 的默克尔根）
+    // piece_ok: 每个分片是否通过校验（无法读取的分片视为失败）
+    // 返回: 未通过校验的分片数量
+    int verify(const lt::torrent_info& ti, std::vector<bool>& piece_ok);
+
+    // 读取 v2 文件各分片的默克尔根：torrent_info::piece_layer 返回连续的 32 字节哈希，单分片文件没有 piece layer，分片根就是文件根
+    // 返回: 文件的分片根（piece layer 已释放或缺失时为空）
+    static std::vector<lt::sha256_hash> file_piece_roots(const lt::torrent_info& ti, lt::file_index_t file);
+
+    // 检查分片在上次计算中是否读取失败（仅在 skip_unreadable 时有效）
+    inline bool is_unreadable(lt::piece_index_t piece) const
+    {
+        return static_cast<int>(piece) < static_cast<int>(unreadable_.size()) && unreadable_[static_cast<int>(piece)] != 0;
+    }
+
+    // 检查分片在上次计算中是否为全零（稀疏空洞或内容全部为 0）
+    inline bool is_zero(lt::piece_index_t piece) const
+    {
+        return static_cast<int>(piece) < static_cast<int>(zero_.size()) && zero_[static_cast<int>(piece)] != 0;
+    }
+
+    // 上次计算中因稀疏空洞跳过读取的字节数
+    inline std::int64_t hole_bytes() const { return hole_bytes_; }
+
+    // 上次计算中全零分片的数量
+    inline int zero_pieces() const { return zero_pieces_; }
+
+    // 与指定分片等长的全零分片的 SHA1 / v2 默克尔根（结果缓存）
+    lt::sha1_hash zero_hash(lt::piece_index_t piece);
+    lt::sha256_hash zero_piece_root(lt::piece_index_t piece);
+
+private:
+    const lt::file_storage& fs_storage_;  // 文件存储
+    std::string root_path_;               // 根路径
+    int threads_;                         // 工作线程数（0 表示自动）
+    int read_ahead_;                      // 读取阶段可提前填充的读取块数量
+    int read_block_size_;                 // 单次读取的块大小（字节）
+    bool unbuffered_;                     // 是否使用无缓冲 I/O
+    bool compute_v1_;                     // 是否计算 SHA1 分片哈希
+    bool skip_unreadable_;                // 是否跳过无法读取的分片
+    bool sparse_aware_;                   // 是否查询稀疏空洞
+    bool quiet_;                          // 是否不输出信息
+    std::function<void(std::int64_t, std::int64_t)> progress_;  // 进度回调（为空时输出进度行）
+    std::vector<char> unreadable_;        // 读取失败的分片标记（各线程写入不同下标）
+    std::vector<char> zero_;              // 全零分片标记（各线程写入不同下标）
+    std::int64_t hole_bytes_;             // 稀疏空洞跳过读取的字节数
+    int zero_pieces_;                     // 全零分片数量
+    std::unique_ptr<ZeroHashCache> zero_hashes_;  // 全零分片哈希缓存
+    std::function<void(const std::vector<char>&)> checkpoint_;  // 检查点回调
+    int checkpoint_interval_;             // 检查点间隔（秒）
+};
+
+#endif // PIECE_HASHER_HPP
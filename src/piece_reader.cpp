@@ -0,0 +1,241 @@
+#include "piece_reader.hpp"
+#include <algorithm>
+
+namespace {
+
+// 等待中的请求超过该时间仍未完成时重新提交（截止时间被覆盖或 alert 队列溢出丢失 read_piece_alert 时恢复）
+const std::chrono::milliseconds kResubmitInterval(2000);
+
+// 向 libtorrent 提交分片请求：立即截止；已拥有的分片直接读取
+// 截止时间已让分片排在所有请求之前，不再修改分片优先级（读取完成后不需要恢复，也不会改变用户设置的优先级）
+// 返回: 是否成功（句柄无效时返回 false）
+bool submit_request(const lt::torrent_handle& handle, int piece, std::string& error)
+{
+    try {
+        const lt::piece_index_t index(piece);
+        handle.set_piece_deadline(index, 0);
+        if (handle.have_piece(index)) {
+            handle.read_piece(index);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+}
+
+} // namespace
+
+PieceReader::PieceReader(size_t cache_pieces)
+    : cache_pieces_(cache_pieces)
+    , cached_(0)
+    , pending_(0)
+    , use_counter_(0)
+{
+}
+
+void PieceReader::request(const TorrentKey& key, const lt::torrent_handle& handle, int piece)
+{
+    const PieceKey piece_key{key, piece};
+    std::shared_ptr<Request> request;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = requests_.find(piece_key);
+        if (it != requests_.end() && it->second->handle == handle) {
+            it->second->last_used = ++use_counter_;
+            return;
+        }
+        request = create_unsafe(piece_key, handle);
+    }
+
+    // have_piece 需要等待 libtorrent 网络线程，提交时不持有 mutex_
+    std::string error;
+    if (!submit_request(handle, piece, error)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fail_unsafe(piece_key, *request, error);
+    }
+}
+
+bool PieceReader::wait(const TorrentKey& key, const lt::torrent_handle& handle, int piece,
+                       std::chrono::steady_clock::time_point deadline, Piece& piece_data, std::string& error)
+{
+    const PieceKey piece_key{key, piece};
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    std::shared_ptr<Request> request;
+    bool submit = false;
+    auto it = requests_.find(piece_key);
+    if (it != requests_.end() && it->second->handle == handle) {
+        request = it->second;
+        request->last_used = ++use_counter_;
+    } else {
+        request = create_unsafe(piece_key, handle);
+        submit = true;
+    }
+
+    while (true) {
+        if (request->done) {
+            piece_data = request->data;
+            return true;
+        }
+        if (request->failed) {
+            error = request->error;
+            return false;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (submit) {
+            submit = false;
+            request->submitted = now;
+            lock.unlock();
+            std::string submit_error;
+            const bool submitted = submit_request(handle, piece, submit_error);
+            lock.lock();
+            if (!submitted && !request->done && !request->failed) {
+                fail_unsafe(piece_key, *request, submit_error);
+            }
+            continue;
+        }
+
+        if (now >= deadline) {
+            // 请求保留：分片到达后进入缓存，之后的读取可以直接使用
+            error = "等待分片超时";
+            return false;
+        }
+
+        const auto resubmit_at = request->submitted + kResubmitInterval;
+        if (now >= resubmit_at) {
+            submit = true;
+            continue;
+        }
+        request->ready.wait_until(lock, std::min(deadline, resubmit_at));
+    }
+}
+
+void PieceReader::on_read_piece(const lt::read_piece_alert& a)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_ == 0) {
+        return;
+    }
+
+    const PieceKey piece_key{TorrentKey::primary(a.handle.info_hashes()), static_cast<int>(a.piece)};
+    auto it = requests_.find(piece_key);
+    if (it == requests_.end() || it->second->done || it->second->handle != a.handle) {
+        return;
+    }
+    Request& request = *it->second;
+    if (a.error) {
+        fail_unsafe(piece_key, request, a.error.message());
+        return;
+    }
+
+    request.data.buffer = a.buffer;
+    request.data.size = a.size;
+    request.done = true;
+    --pending_;
+    ++cached_;
+    request.ready.notify_all();
+    evict_unsafe();
+}
+
+void PieceReader::on_piece_finished(const lt::piece_finished_alert& a)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_ == 0) {
+        return;
+    }
+
+    const PieceKey piece_key{TorrentKey::primary(a.handle.info_hashes()), static_cast<int>(a.piece_index)};
+    auto it = requests_.find(piece_key);
+    if (it == requests_.end() || it->second->done || it->second->handle != a.handle) {
+        return;
+    }
+    try {
+        a.handle.read_piece(a.piece_index);
+    } catch (const std::exception& e) {
+        fail_unsafe(piece_key, *it->second, e.what());
+    }
+}
+
+void PieceReader::cancel(const TorrentKey& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = requests_.begin(); it != requests_.end(); ) {
+        if (it->first.key == key) {
+            it = remove_unsafe(it, "torrent 已移除");
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PieceReader::cancel_all()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = requests_.begin(); it != requests_.end(); ) {
+        it = remove_unsafe(it, "torrent 已移除");
+    }
+}
+
+void PieceReader::set_cache_pieces(size_t cache_pieces)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_pieces_ = cache_pieces;
+    evict_unsafe();
+}
+
+std::shared_ptr<PieceReader::Request> PieceReader::create_unsafe(const PieceKey& key, const lt::torrent_handle& handle)
+{
+    auto it = requests_.find(key);
+    if (it != requests_.end()) {
+        // torrent 重新添加后旧句柄的请求不再有效
+        remove_unsafe(it, "torrent 已重新添加");
+    }
+
+    auto request = std::make_shared<Request>();
+    request->handle = handle;
+    request->last_used = ++use_counter_;
+    request->submitted = std::chrono::steady_clock::now();
+    requests_.emplace(key, request);
+    ++pending_;
+    return request;
+}
+
+void PieceReader::fail_unsafe(const PieceKey& key, Request& request, const std::string& error)
+{
+    auto it = requests_.find(key);
+    if (it != requests_.end() && it->second.get() == &request) {
+        remove_unsafe(it, error);
+    }
+}
+
+PieceReader::RequestMap::iterator PieceReader::remove_unsafe(RequestMap::iterator it, const std::string& error)
+{
+    Request& request = *it->second;
+    if (request.done) {
+        --cached_;
+    } else {
+        --pending_;
+        request.failed = true;
+        request.error = error;
+        request.ready.notify_all();
+    }
+    return requests_.erase(it);
+}
+
+void PieceReader::evict_unsafe()
+{
+    while (cached_ > cache_pieces_) {
+        auto oldest = requests_.end();
+        for (auto it = requests_.begin(); it != requests_.end(); ++it) {
+            if (it->second->done && (oldest == requests_.end() || it->second->last_used < oldest->second->last_used)) {
+                oldest = it;
+            }
+        }
+        if (oldest == requests_.end()) {
+            break;
+        }
+        remove_unsafe(oldest, std::string());
+    }
+}
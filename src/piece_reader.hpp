@@ -0,0 +1,110 @@
+#ifndef PIECE_READER_HPP
+#define PIECE_READER_HPP
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <boost/shared_array.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/alert_types.hpp>
+#include "torrent_registry.hpp"
+
+// 按需读取已校验的分片数据（TorrentManager::read 使用）
+// 请求的分片设为立即截止（set_piece_deadline，不修改分片优先级），已拥有或下载并通过校验（piece_finished_alert）后
+// 调用 read_piece，libtorrent 以 read_piece_alert 返回整片数据
+// 多个线程读取同一分片时共用一个请求；最近读取的分片保留在内存中，连续的小块读取不会重复读盘
+class PieceReader
+{
+public:
+    // 一个分片的数据
+    struct Piece {
+        boost::shared_array<char> buffer;   // 分片数据（与其他读取者共享，只读）
+        int size;                           // 数据长度
+
+        Piece() : size(0) {}
+    };
+
+    // cache_pieces: 读取完成后保留在内存中的分片数
+    explicit PieceReader(size_t cache_pieces = 8);
+
+    PieceReader(const PieceReader&) = delete;
+    PieceReader& operator=(const PieceReader&) = delete;
+
+    // 提交分片请求（不等待）：已缓存或已有相同请求时不重复提交
+    void request(const TorrentKey& key, const lt::torrent_handle& handle, int piece);
+
+    // 等待分片数据，最多等到 deadline（未提交的请求会先提交）
+    // 返回: 是否成功，失败时 error 为原因
+    bool wait(const TorrentKey& key, const lt::torrent_handle& handle, int piece,
+              std::chrono::steady_clock::time_point deadline, Piece& piece_data, std::string& error);
+
+    // 处理 read_piece_alert：完成对应的请求并唤醒等待的读取者
+    void on_read_piece(const lt::read_piece_alert& a);
+
+    // 处理 piece_finished_alert：有等待该分片的请求时立即读取（截止时间被其他调用覆盖时仍能完成）
+    void on_piece_finished(const lt::piece_finished_alert& a);
+
+    // 使指定 torrent 的请求失败并丢弃其缓存（torrent 移除时调用）
+    void cancel(const TorrentKey& key);
+    void cancel_all();
+
+    // 设置保留在内存中的分片数（0 表示不缓存）
+    void set_cache_pieces(size_t cache_pieces);
+
+private:
+    // 分片键（torrent 主键 + 分片索引）
+    struct PieceKey {
+        TorrentKey key;
+        int piece;
+
+        inline bool operator==(const PieceKey& other) const { return piece == other.piece && key == other.key; }
+    };
+    struct PieceKeyHash {
+        inline size_t operator()(const PieceKey& k) const
+        {
+            return static_cast<size_t>(k.key.hash() ^ (static_cast<std::uint64_t>(k.piece) * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    // 一个分片请求（等待中或已缓存）
+    struct Request {
+        lt::torrent_handle handle;                            // 提交请求时的句柄
+        bool done;                                            // 是否已取得数据
+        bool failed;                                          // 是否失败（失败的请求已从表中移除）
+        std::string error;                                    // 失败原因
+        Piece data;                                           // 分片数据（done 为 true 时有效）
+        std::uint64_t last_used;                              // 最近一次使用（用于淘汰缓存）
+        std::chrono::steady_clock::time_point submitted;      // 最近一次提交的时间
+        std::condition_variable ready;                        // 数据到达或请求失败时通知
+
+        Request() : done(false), failed(false), last_used(0) {}
+    };
+
+    using RequestMap = std::unordered_map<PieceKey, std::shared_ptr<Request>, PieceKeyHash>;
+
+    // 创建请求（同一分片旧句柄的请求会被移除，仅在持有 mutex_ 时调用；由调用方提交给 libtorrent）
+    std::shared_ptr<Request> create_unsafe(const PieceKey& key, const lt::torrent_handle& handle);
+
+    // 使请求失败：仍在表中时移除并唤醒等待者（仅在持有 mutex_ 时调用）
+    void fail_unsafe(const PieceKey& key, Request& request, const std::string& error);
+
+    // 从表中移除请求：已缓存的直接丢弃，等待中的标记为失败并唤醒等待者（仅在持有 mutex_ 时调用）
+    RequestMap::iterator remove_unsafe(RequestMap::iterator it, const std::string& error);
+
+    // 缓存超过上限时淘汰最久未使用的分片（仅在持有 mutex_ 时调用）
+    void evict_unsafe();
+
+private:
+    std::mutex mutex_;                                    // 保护以下成员
+    RequestMap requests_;                                 // 等待中和已缓存的分片
+    size_t cache_pieces_;                                 // 保留的分片数上限
+    size_t cached_;                                       // 已缓存的分片数
+    size_t pending_;                                      // 等待中的请求数
+    std::uint64_t use_counter_;                           // 使用计数
+};
+
+#endif // PIECE_READER_HPP
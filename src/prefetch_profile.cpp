@@ -0,0 +1,241 @@
+#include "prefetch_profile.hpp"
+#include "boot_trace.hpp"
+#include "torrent_registry.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/bdecode.hpp>
+#include <libtorrent/entry.hpp>
+#include <libtorrent/download_priority.hpp>
+
+namespace {
+
+// 预取配置中保存的 info hash：torrent 主键的二进制形式
+std::string binary_info_hash(const lt::torrent_info& ti)
+{
+    const TorrentKey key = TorrentKey::primary(ti.info_hashes());
+    return std::string(reinterpret_cast<const char*>(key.bytes.data()), key.size);
+}
+
+} // namespace
+
+PrefetchProfile::PrefetchProfile()
+    : num_pieces_(0)
+    , piece_length_(0)
+    , boots_(0)
+{
+}
+
+bool PrefetchProfile::compile(const lt::torrent_info& ti, const std::vector<std::string>& trace_paths,
+                              double min_share, PrefetchProfile& profile)
+{
+    const std::string expected_hash = TorrentKey::primary(ti.info_hashes()).to_hex();
+    const std::int64_t total_size = ti.total_size();
+    const int piece_length = ti.piece_length();
+    if (piece_length <= 0 || ti.num_pieces() == 0) {
+        std::cerr << "错误: torrent 没有分片" << std::endl;
+        return false;
+    }
+
+    // 每个分片在各次启动中的首次读取时间
+    std::unordered_map<int, std::vector<std::uint32_t>> first_reads;
+    int boots = 0;
+    for (const auto& path : trace_paths) {
+        std::string info_hash;
+        std::vector<BootTraceRead> reads;
+        if (!BootTraceRecorder::load(path, info_hash, reads)) {
+            continue;
+        }
+        if (!info_hash.empty() && info_hash != expected_hash) {
+            std::cout << "跳过其他 torrent 的跟踪文件: " << path << std::endl;
+            continue;
+        }
+        if (reads.empty()) {
+            std::cout << "跳过空的跟踪文件: " << path << std::endl;
+            continue;
+        }
+
+        std::unordered_map<int, std::uint32_t> first_in_boot;
+        for (const auto& read : reads) {
+            if (read.offset >= total_size) {
+                continue;
+            }
+            const std::int64_t end = std::min(total_size, read.offset + read.length);
+            const int first_piece = static_cast<int>(read.offset / piece_length);
+            const int last_piece = static_cast<int>((end - 1) / piece_length);
+            for (int p = first_piece; p <= last_piece; ++p) {
+                auto inserted = first_in_boot.emplace(p, read.ms);
+                if (!inserted.second && read.ms < inserted.first->second) {
+                    inserted.first->second = read.ms;
+                }
+            }
+        }
+        for (const auto& pair : first_in_boot) {
+            first_reads[pair.first].push_back(pair.second);
+        }
+        ++boots;
+    }
+
+    if (boots == 0) {
+        std::cerr << "错误: 没有可用的启动跟踪文件" << std::endl;
+        return false;
+    }
+
+    // 只保留在足够多的启动中出现的分片，截止时间取首次读取时间的中位数
+    min_share = std::max(0.0, std::min(1.0, min_share));
+    const int min_boots = std::max(1, static_cast<int>(std::ceil(min_share * boots)));
+    PrefetchProfile result;
+    result.info_hash_ = binary_info_hash(ti);
+    result.num_pieces_ = ti.num_pieces();
+    result.piece_length_ = piece_length;
+    result.boots_ = boots;
+    for (auto& pair : first_reads) {
+        std::vector<std::uint32_t>& times = pair.second;
+        if (static_cast<int>(times.size()) < min_boots) {
+            continue;
+        }
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        const std::uint32_t median = times[times.size() / 2];
+        result.entries_.push_back(Entry{pair.first, static_cast<int>(std::min<std::uint32_t>(median, INT32_MAX))});
+    }
+    std::sort(result.entries_.begin(), result.entries_.end(), [](const Entry& a, const Entry& b) {
+        return a.deadline_ms != b.deadline_ms ? a.deadline_ms < b.deadline_ms : a.piece < b.piece;
+    });
+
+    profile = std::move(result);
+    return true;
+}
+
+bool PrefetchProfile::save(const std::string& path) const
+{
+    namespace fs = std::filesystem;
+
+    try {
+        lt::entry root;
+        root["info-hash"] = info_hash_;
+        root["num pieces"] = num_pieces_;
+        root["piece length"] = piece_length_;
+        root["boots"] = boots_;
+        lt::entry::list_type pieces;
+        lt::entry::list_type deadlines;
+        for (const auto& entry : entries_) {
+            pieces.push_back(lt::entry(entry.piece));
+            deadlines.push_back(lt::entry(entry.deadline_ms));
+        }
+        root["pieces"] = std::move(pieces);
+        root["deadlines"] = std::move(deadlines);
+
+        std::vector<char> buffer;
+        lt::bencode(std::back_inserter(buffer), root);
+
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream out(fs::u8path(temp_path), std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "错误: 无法写入预取配置: " << temp_path << std::endl;
+                return false;
+            }
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!out) {
+                std::cerr << "错误: 写入预取配置失败: " << temp_path << std::endl;
+                return false;
+            }
+        }
+        fs::rename(fs::u8path(temp_path), fs::u8path(path));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: 保存预取配置失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool PrefetchProfile::load(const std::string& path, const lt::torrent_info& ti)
+{
+    namespace fs = std::filesystem;
+
+    try {
+        std::ifstream in(fs::u8path(path), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::vector<char> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        lt::error_code ec;
+        lt::bdecode_node root = lt::bdecode(buffer, ec);
+        if (ec || root.type() != lt::bdecode_node::dict_t) {
+            std::cerr << "警告: 预取配置格式错误: " << path << std::endl;
+            return false;
+        }
+        const lt::string_view stored_hash = root.dict_find_string_value("info-hash");
+        if (std::string(stored_hash.data(), stored_hash.size()) != binary_info_hash(ti) ||
+            root.dict_find_int_value("num pieces", -1) != ti.num_pieces()) {
+            std::cout << "预取配置与 torrent 不匹配，忽略: " << path << std::endl;
+            return false;
+        }
+
+        lt::bdecode_node pieces = root.dict_find_list("pieces");
+        lt::bdecode_node deadlines = root.dict_find_list("deadlines");
+        if (!pieces || !deadlines || pieces.list_size() != deadlines.list_size()) {
+            std::cerr << "警告: 预取配置格式错误: " << path << std::endl;
+            return false;
+        }
+
+        std::vector<Entry> entries;
+        entries.reserve(pieces.list_size());
+        for (int i = 0; i < pieces.list_size(); ++i) {
+            Entry entry;
+            entry.piece = static_cast<int>(pieces.list_int_value_at(i, -1));
+            entry.deadline_ms = static_cast<int>(std::max<std::int64_t>(0, deadlines.list_int_value_at(i, 0)));
+            if (entry.piece < 0 || entry.piece >= ti.num_pieces()) {
+                std::cerr << "警告: 预取配置中的分片索引无效: " << path << std::endl;
+                return false;
+            }
+            entries.push_back(entry);
+        }
+
+        info_hash_ = binary_info_hash(ti);
+        num_pieces_ = ti.num_pieces();
+        piece_length_ = ti.piece_length();
+        boots_ = static_cast<int>(root.dict_find_int_value("boots", 0));
+        entries_ = std::move(entries);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 读取预取配置失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void PrefetchProfile::apply(const lt::torrent_handle& handle) const
+{
+    if (entries_.empty()) {
+        return;
+    }
+
+    // 一次提交所有优先级，再按读取顺序设置截止时间（已拥有的分片 libtorrent 会忽略）
+    std::vector<std::pair<lt::piece_index_t, lt::download_priority_t>> priorities;
+    priorities.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        priorities.emplace_back(lt::piece_index_t(entry.piece), lt::top_priority);
+    }
+    handle.prioritize_pieces(priorities);
+    for (const auto& entry : entries_) {
+        handle.set_piece_deadline(lt::piece_index_t(entry.piece), entry.deadline_ms);
+    }
+}
+
+void PrefetchProfile::print_summary() const
+{
+    std::cout << "预取配置: " << entries_.size() << " 个分片（" << (total_bytes() / 1024.0 / 1024.0)
+              << " MB，占全部分片的 "
+              << (num_pieces_ > 0 ? 100.0 * static_cast<double>(entries_.size()) / num_pieces_ : 0.0)
+              << "%），来自 " << boots_ << " 次启动";
+    if (!entries_.empty()) {
+        std::cout << "，最后一个截止时间 " << (entries_.back().deadline_ms / 1000.0) << " 秒";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,63 @@
+#ifndef PREFETCH_PROFILE_HPP
+#define PREFETCH_PROFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/torrent_handle.hpp>
+
+// 预取配置（<torrent>.prefetch 旁路文件）
+// 由多次启动的访问跟踪（BootTraceRecorder）编译而成：启动时会读取的分片，按首次读取时间排序，
+// 每个分片带有截止时间（各次启动中首次读取时间的中位数）
+// TorrentManager::start_download 发现该文件时自动应用：这些分片设为最高优先级并按截止时间下载
+class PrefetchProfile
+{
+public:
+    // 一个需要预取的分片
+    struct Entry {
+        int piece;                   // 分片索引
+        int deadline_ms;             // 截止时间（距添加 torrent 的毫秒数）
+    };
+
+    PrefetchProfile();
+
+    // 获取 torrent 对应的预取配置文件路径
+    static inline std::string path_for(const std::string& torrent_path) { return torrent_path + ".prefetch"; }
+
+    // 编译跟踪文件：在至少 min_share（0-1）比例的启动中被读取的分片才会加入预取配置
+    // info hash 与 torrent 不一致的跟踪文件会被跳过
+    // 返回: 是否成功（没有可用的跟踪文件时返回 false）
+    static bool compile(const lt::torrent_info& ti, const std::vector<std::string>& trace_paths,
+                        double min_share, PrefetchProfile& profile);
+
+    // 保存（bencode 格式，先写临时文件再替换）
+    bool save(const std::string& path) const;
+
+    // 加载并与 torrent 核对（info hash 或分片数量不一致时返回 false）
+    bool load(const std::string& path, const lt::torrent_info& ti);
+
+    // 应用到已添加的 torrent：预取分片设为最高优先级，并按截止时间设置 set_piece_deadline
+    void apply(const lt::torrent_handle& handle) const;
+
+    // 按读取顺序排列的预取分片
+    inline const std::vector<Entry>& entries() const { return entries_; }
+
+    // 编译时使用的启动次数
+    inline int boots() const { return boots_; }
+
+    // 预取数据总量（字节）
+    inline std::int64_t total_bytes() const { return static_cast<std::int64_t>(entries_.size()) * piece_length_; }
+
+    // 打印摘要
+    void print_summary() const;
+
+private:
+    std::string info_hash_;          // torrent 的 info hash（二进制，优先 v1）
+    int num_pieces_;                 // torrent 的分片数量
+    int piece_length_;               // 分片大小
+    int boots_;                      // 编译时使用的启动次数
+    std::vector<Entry> entries_;     // 预取分片（按截止时间排序）
+};
+
+#endif // PREFETCH_PROFILE_HPP
@@ -0,0 +1,184 @@
+#include "profile_benchmark.hpp"
+#include "torrent_file_cache.hpp"
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <algorithm>
+#include <libtorrent/session.hpp>
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_status.hpp>
+#include <libtorrent/ip_filter.hpp>
+#include <libtorrent/socket.hpp>
+#include <boost/asio/ip/address.hpp>
+
+namespace {
+
+// 回环测试使用的 session 设置：配置中的传输参数不变，只监听回环地址并关闭所有发现和端口映射
+lt::settings_pack loopback_settings(const SessionProfile& profile)
+{
+    lt::settings_pack settings = profile.to_settings();
+    settings.set_str(lt::settings_pack::listen_interfaces, "127.0.0.1:0");
+    settings.set_bool(lt::settings_pack::enable_dht, false);
+    settings.set_bool(lt::settings_pack::enable_lsd, false);
+    settings.set_bool(lt::settings_pack::enable_upnp, false);
+    settings.set_bool(lt::settings_pack::enable_natpmp, false);
+    settings.set_int(lt::settings_pack::alert_mask, lt::alert::error_notification);
+    return settings;
+}
+
+// 配置的 IP 过滤器，额外放开回环地址
+bool loopback_filter(const SessionProfile& profile, lt::ip_filter& filter)
+{
+    if (!profile.build_ip_filter(filter)) {
+        return false;
+    }
+    filter.add_rule(boost::asio::ip::make_address("127.0.0.0"), boost::asio::ip::make_address("127.255.255.255"), 0);
+    return true;
+}
+
+std::string format_rate(double bytes_per_sec)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.1f MB/s", bytes_per_sec / (1024.0 * 1024.0));
+    return std::string(buffer);
+}
+
+} // namespace
+
+bool ProfileBenchmark::run(const SessionProfile& profile, const std::string& torrent_path, const std::string& data_path,
+                           ProfileBenchmarkResult& result, int timeout_seconds)
+{
+    namespace fs = std::filesystem;
+
+    result = ProfileBenchmarkResult();
+    result.profile = profile.name;
+
+    lt::error_code ec;
+    auto ti = TorrentFileCache::load_for_session(torrent_path, ec);
+    if (ec) {
+        result.error = "解析 torrent 文件失败: " + ec.message();
+        return false;
+    }
+
+    lt::ip_filter filter;
+    if (!loopback_filter(profile, filter)) {
+        result.error = "配置中的网段格式错误";
+        return false;
+    }
+
+    // 每次测试使用新的临时目录
+    const fs::path temp_dir = fs::temp_directory_path() /
+        ("profile_bench_" + profile.name + "_" +
+         std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::error_code fs_ec;
+    fs::create_directories(temp_dir, fs_ec);
+    if (fs_ec) {
+        result.error = "无法创建临时目录: " + fs_ec.message();
+        return false;
+    }
+
+    try {
+        lt::session seed_session(loopback_settings(profile));
+        lt::session download_session(loopback_settings(profile));
+        seed_session.set_ip_filter(filter);
+        download_session.set_ip_filter(filter);
+
+        // 做种端：数据视为完整（seed_mode），分片在第一次被请求时校验
+        lt::add_torrent_params seed_params;
+        seed_params.ti = ti;
+        seed_params.save_path = data_path;
+        seed_params.flags |= lt::torrent_flags::seed_mode;
+        seed_params.flags &= ~lt::torrent_flags::paused;
+        seed_params.flags &= ~lt::torrent_flags::auto_managed;
+        lt::torrent_handle seed_handle = seed_session.add_torrent(seed_params, ec);
+        if (ec) {
+            result.error = "做种端添加 torrent 失败: " + ec.message();
+            fs::remove_all(temp_dir, fs_ec);
+            return false;
+        }
+
+        lt::add_torrent_params download_params;
+        download_params.ti = ti;
+        download_params.save_path = temp_dir.u8string();
+        download_params.flags &= ~lt::torrent_flags::paused;
+        download_params.flags &= ~lt::torrent_flags::auto_managed;
+        lt::torrent_handle download_handle = download_session.add_torrent(download_params, ec);
+        if (ec) {
+            result.error = "下载端添加 torrent 失败: " + ec.message();
+            fs::remove_all(temp_dir, fs_ec);
+            return false;
+        }
+
+        // 等待做种端开始监听
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (seed_session.listen_port() == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (seed_session.listen_port() == 0) {
+            result.error = "做种端未能监听回环地址";
+            fs::remove_all(temp_dir, fs_ec);
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        download_handle.connect_peer(lt::tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"),
+                                                       seed_session.listen_port()));
+
+        // 每 100ms 采样一次速度，直到下载完成或超时
+        deadline = start + std::chrono::seconds(timeout_seconds);
+        lt::torrent_status status;
+        while (std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            status = download_handle.status(lt::status_flags_t{});
+            result.peak_rate = std::max(result.peak_rate, static_cast<double>(status.download_payload_rate));
+            if (status.errc) {
+                result.error = "下载出错: " + status.errc.message();
+                break;
+            }
+            if (status.is_seeding || status.is_finished) {
+                result.ok = true;
+                break;
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.bytes = status.total_wanted_done;
+        result.average_rate = result.seconds > 0 ? static_cast<double>(result.bytes) / result.seconds : 0.0;
+        if (!result.ok && result.error.empty()) {
+            result.error = "超时（" + std::to_string(timeout_seconds) + " 秒）";
+        }
+
+        download_session.remove_torrent(download_handle, lt::session::delete_files);
+        seed_session.remove_torrent(seed_handle);
+    } catch (const std::exception& e) {
+        result.ok = false;
+        result.error = e.what();
+    }
+
+    // session 析构后文件已关闭，删除临时目录
+    fs::remove_all(temp_dir, fs_ec);
+    return result.ok;
+}
+
+void ProfileBenchmark::print_results(const std::vector<ProfileBenchmarkResult>& results)
+{
+    if (results.empty()) {
+        return;
+    }
+    const double baseline = results.front().average_rate;
+    std::cout << std::endl;
+    std::cout << "=== 会话配置回环测试结果 ===" << std::endl;
+    for (const auto& r : results) {
+        char line[256];
+        if (r.ok) {
+            snprintf(line, sizeof(line), "%-16s 用时 %8.2f 秒，平均 %14s，峰值 %14s，相对 %.2fx",
+                     r.profile.c_str(), r.seconds, format_rate(r.average_rate).c_str(),
+                     format_rate(r.peak_rate).c_str(), baseline > 0 ? r.average_rate / baseline : 0.0);
+        } else {
+            snprintf(line, sizeof(line), "%-16s 失败: %s", r.profile.c_str(), r.error.c_str());
+        }
+        std::cout << line << std::endl;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PROFILE_BENCHMARK_HPP
+#define PROFILE_BENCHMARK_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "session_profile.hpp"
+
+// 单个会话配置的测试结果
+struct ProfileBenchmarkResult {
+    std::string profile;           // 配置名称
+    bool ok;                       // 是否在超时前完成下载
+    double seconds;                // 下载用时（秒，从连接开始计算）
+    std::int64_t bytes;            // 下载的数据量（字节）
+    double average_rate;           // 平均速度（字节/秒）
+    double peak_rate;              // 峰值速度（字节/秒）
+    std::string error;             // 失败原因
+
+    ProfileBenchmarkResult() : ok(false), seconds(0.0), bytes(0), average_rate(0.0), peak_rate(0.0) {}
+};
+
+// 回环传输基准测试：在同一进程中按配置创建做种和下载两个 session，通过 127.0.0.1 传输一个 torrent，
+// 比较不同配置的传输速度（不受网络影响，主要反映传输层选择、缓冲区和请求队列设置）
+// 两个 session 只监听 127.0.0.1 的临时端口，不启用 DHT/LSD/UPnP/NAT-PMP；下载到临时目录，结束后删除
+class ProfileBenchmark
+{
+public:
+    // 测试一个配置
+    // torrent_path: 测试用的 torrent；data_path: 做种数据所在的保存路径（数据必须完整）
+    // 返回: 是否完成（失败原因见 result.error）
+    static bool run(const SessionProfile& profile, const std::string& torrent_path, const std::string& data_path,
+                    ProfileBenchmarkResult& result, int timeout_seconds = 300);
+
+    // 打印对比表（以第一个结果为基准计算相对速度）
+    static void print_results(const std::vector<ProfileBenchmarkResult>& results);
+};
+
+#endif // PROFILE_BENCHMARK_HPP
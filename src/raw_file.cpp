@@ -0,0 +1,395 @@
+#include "raw_file.hpp"
+#include <new>
+#include <vector>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+AlignedBuffer::AlignedBuffer(size_t size)
+    : data_(static_cast<char*>(::operator new(size, std::align_val_t(RawFile::alignment))))
+    , size_(size)
+{
+}
+
+AlignedBuffer::~AlignedBuffer()
+{
+    if (data_) {
+        ::operator delete(data_, std::align_val_t(RawFile::alignment));
+    }
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept
+    : data_(other.data_), size_(other.size_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept
+{
+    if (this != &other) {
+        if (data_) {
+            ::operator delete(data_, std::align_val_t(RawFile::alignment));
+        }
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+// 将 UTF-8 路径转换为宽字符
+static std::wstring to_wide_path(const std::string& path)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+    if (len <= 0) return std::wstring();
+    std::vector<wchar_t> buffer(len);
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, buffer.data(), len);
+    return std::wstring(buffer.data());
+}
+
+RawFile::RawFile() : handle_(INVALID_HANDLE_VALUE), unbuffered_(false), last_error_(0) {}
+
+RawFile::~RawFile()
+{
+    close();
+}
+
+bool RawFile::open(const std::string& path, bool unbuffered)
+{
+    close();
+    std::wstring wide_path = to_wide_path(path);
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+
+    if (unbuffered) {
+        handle_ = CreateFileW(wide_path.c_str(), GENERIC_READ, share, NULL, OPEN_EXISTING,
+                              FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (handle_ != INVALID_HANDLE_VALUE) {
+            unbuffered_ = true;
+            return true;
+        }
+    }
+
+    handle_ = CreateFileW(wide_path.c_str(), GENERIC_READ, share, NULL, OPEN_EXISTING,
+                          FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle_ == INVALID_HANDLE_VALUE) {
+        last_error_ = static_cast<int>(GetLastError());
+        return false;
+    }
+    unbuffered_ = false;
+    return true;
+}
+
+void RawFile::close()
+{
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+    unbuffered_ = false;
+}
+
+bool RawFile::is_open() const
+{
+    return handle_ != INVALID_HANDLE_VALUE;
+}
+
+std::int64_t RawFile::read_at(std::int64_t offset, char* buffer, std::int64_t size)
+{
+    std::int64_t total = 0;
+    while (total < size) {
+        // ReadFile 单次最多读取 DWORD 范围，按 1GB 分段（保持扇区对齐）
+        DWORD request = static_cast<DWORD>(std::min<std::int64_t>(size - total, 1LL << 30));
+        OVERLAPPED overlapped = {};
+        std::uint64_t position = static_cast<std::uint64_t>(offset + total);
+        overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFULL);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        DWORD bytes_read = 0;
+        if (!ReadFile(handle_, buffer + total, request, &bytes_read, &overlapped)) {
+            DWORD error = GetLastError();
+            if (error == ERROR_HANDLE_EOF) break;
+            last_error_ = static_cast<int>(error);
+            return -1;
+        }
+        if (bytes_read == 0) break;
+        total += bytes_read;
+        if (bytes_read < request) break;
+    }
+    return total;
+}
+
+void RawFile::drop_cache(std::int64_t, std::int64_t)
+{
+    // Windows 没有按范围丢弃页缓存的接口，需要低缓存占用时使用无缓冲模式
+}
+
+bool RawFile::is_hole(std::int64_t offset, std::int64_t size)
+{
+    if (handle_ == INVALID_HANDLE_VALUE || size <= 0) return false;
+
+    // 查询范围内已分配的区域：非稀疏文件总是返回整个范围，没有返回任何区域说明全部是空洞
+    FILE_ALLOCATED_RANGE_BUFFER query = {};
+    query.FileOffset.QuadPart = offset;
+    query.Length.QuadPart = size;
+    FILE_ALLOCATED_RANGE_BUFFER range = {};
+    DWORD bytes_returned = 0;
+    if (!DeviceIoControl(handle_, FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query),
+                         &range, sizeof(range), &bytes_returned, NULL)) {
+        return false;
+    }
+    return bytes_returned == 0;
+}
+
+bool RawFile::create_sparse(const std::string& path, std::int64_t size)
+{
+    std::wstring wide_path = to_wide_path(path);
+    HANDLE handle = CreateFileW(wide_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                                CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // 设置稀疏属性后再扩展文件大小，扩展出的部分不占用磁盘空间
+    DWORD bytes_returned = 0;
+    DeviceIoControl(handle, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes_returned, NULL);
+    LARGE_INTEGER end;
+    end.QuadPart = size;
+    bool ok = SetFilePointerEx(handle, end, NULL, FILE_BEGIN) && SetEndOfFile(handle);
+    CloseHandle(handle);
+    return ok;
+}
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), last_error_(0) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    std::wstring wide_path = to_wide_path(path);
+    HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        last_error_ = static_cast<int>(GetLastError());
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        last_error_ = static_cast<int>(GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+    if (file_size.QuadPart <= 0) {
+        // 空文件：GetFileSizeEx 成功，没有系统错误码
+        last_error_ = ERROR_FILE_INVALID;
+        CloseHandle(file);
+        return false;
+    }
+    // 映射对象和视图建立后即可关闭文件句柄，视图在 UnmapViewOfFile 前一直有效
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        last_error_ = static_cast<int>(GetLastError());
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL) {
+        last_error_ = static_cast<int>(GetLastError());
+        return false;
+    }
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+#else
+
+RawFile::RawFile() : fd_(-1), unbuffered_(false), last_error_(0) {}
+
+RawFile::~RawFile()
+{
+    close();
+}
+
+bool RawFile::open(const std::string& path, bool unbuffered)
+{
+    close();
+
+#ifdef O_DIRECT
+    if (unbuffered) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (fd_ >= 0) {
+            unbuffered_ = true;
+            return true;
+        }
+    }
+#endif
+
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        last_error_ = errno;
+        return false;
+    }
+    unbuffered_ = false;
+
+#ifdef F_NOCACHE
+    // macOS 没有 O_DIRECT，使用 F_NOCACHE 实现类似效果（无对齐要求，仍按普通模式处理）
+    if (unbuffered) {
+        fcntl(fd_, F_NOCACHE, 1);
+    }
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+void RawFile::close()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    unbuffered_ = false;
+}
+
+bool RawFile::is_open() const
+{
+    return fd_ >= 0;
+}
+
+std::int64_t RawFile::read_at(std::int64_t offset, char* buffer, std::int64_t size)
+{
+    std::int64_t total = 0;
+    while (total < size) {
+        ssize_t n = ::pread(fd_, buffer + total, static_cast<size_t>(size - total),
+                            static_cast<off_t>(offset + total));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            last_error_ = errno;
+            return -1;
+        }
+        if (n == 0) break;
+        total += n;
+        // 无缓冲模式下的短读表示到达文件末尾，继续读取会因偏移未对齐而失败
+        if (unbuffered_ && (n % static_cast<ssize_t>(alignment)) != 0) break;
+    }
+    return total;
+}
+
+void RawFile::drop_cache(std::int64_t offset, std::int64_t size)
+{
+#ifdef POSIX_FADV_DONTNEED
+    if (fd_ >= 0 && !unbuffered_) {
+        posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+    }
+#else
+    (void)offset;
+    (void)size;
+#endif
+}
+
+bool RawFile::is_hole(std::int64_t offset, std::int64_t size)
+{
+#ifdef SEEK_DATA
+    if (fd_ < 0 || size <= 0) return false;
+
+    // 从 offset 开始查找下一个数据区域：没有数据（ENXIO）或数据在范围之后说明整个范围都是空洞
+    off_t data = ::lseek(fd_, static_cast<off_t>(offset), SEEK_DATA);
+    if (data < 0) {
+        return errno == ENXIO;
+    }
+    return static_cast<std::int64_t>(data) >= offset + size;
+#else
+    (void)offset;
+    (void)size;
+    return false;
+#endif
+}
+
+bool RawFile::create_sparse(const std::string& path, std::int64_t size)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // ftruncate 扩展出的部分在支持稀疏文件的文件系统上不占用磁盘空间
+    bool ok = ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+    ::close(fd);
+    return ok;
+}
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), last_error_(0) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        last_error_ = errno;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        last_error_ = errno;
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size <= 0) {
+        // 空文件：fstat 成功，errno 没有意义
+        last_error_ = EINVAL;
+        ::close(fd);
+        return false;
+    }
+    // 映射建立后即可关闭文件描述符，映射在 munmap 前一直有效
+    void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        last_error_ = errno;
+        return false;
+    }
+    data_ = static_cast<const char*>(addr);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+#endif
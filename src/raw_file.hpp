@@ -0,0 +1,116 @@
+#ifndef RAW_FILE_HPP
+#define RAW_FILE_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// 对齐的内存缓冲区（无缓冲 I/O 要求缓冲区地址按扇区对齐）
+class AlignedBuffer
+{
+public:
+    AlignedBuffer() : data_(nullptr), size_(0) {}
+    explicit AlignedBuffer(size_t size);
+    ~AlignedBuffer();
+
+    // 禁止拷贝，允许移动
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+    AlignedBuffer(AlignedBuffer&& other) noexcept;
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+    inline char* data() { return data_; }
+    inline const char* data() const { return data_; }
+    inline size_t size() const { return size_; }
+
+private:
+    char* data_;
+    size_t size_;
+};
+
+// 只读文件句柄，直接使用系统调用按偏移读取
+// 可选无缓冲模式（Windows: FILE_FLAG_NO_BUFFERING，Linux: O_DIRECT），读取时不经过系统页缓存
+// 普通模式下可通过 drop_cache 在读取后释放页缓存，避免大镜像挤占服务器内存
+class RawFile
+{
+public:
+    // 无缓冲读取要求的偏移、长度和缓冲区地址对齐值（覆盖 512 字节和 4K 扇区）
+    static constexpr size_t alignment = 4096;
+
+    RawFile();
+    ~RawFile();
+
+    // 禁止拷贝
+    RawFile(const RawFile&) = delete;
+    RawFile& operator=(const RawFile&) = delete;
+
+    // 打开文件（path 为 UTF-8 路径）
+    // unbuffered: 请求无缓冲模式，文件系统不支持时自动退回普通模式
+    bool open(const std::string& path, bool unbuffered);
+
+    // 关闭文件
+    void close();
+
+    // 文件是否已打开
+    bool is_open() const;
+
+    // 是否处于无缓冲模式（此时 read_at 的偏移、长度和缓冲区必须按 alignment 对齐）
+    inline bool is_unbuffered() const { return unbuffered_; }
+
+    // 从指定偏移读取最多 size 字节，返回实际读取的字节数（到达文件末尾时可能较少），失败返回 -1
+    std::int64_t read_at(std::int64_t offset, char* buffer, std::int64_t size);
+
+    // 通知系统丢弃指定范围的页缓存（无缓冲模式或不支持的平台上不做任何操作）
+    void drop_cache(std::int64_t offset, std::int64_t size);
+
+    // 检查指定范围是否完全没有分配磁盘空间（稀疏文件的空洞，读取结果全部为 0）
+    // 文件系统不支持查询或范围内有数据时返回 false
+    bool is_hole(std::int64_t offset, std::int64_t size);
+
+    // 创建指定大小的稀疏文件（path 为 UTF-8 路径），文件已存在时返回 false
+    // 文件系统不支持稀疏文件时仍会创建普通文件
+    static bool create_sparse(const std::string& path, std::int64_t size);
+
+    // 最近一次失败的系统错误码
+    inline int last_error() const { return last_error_; }
+
+private:
+#ifdef _WIN32
+    void* handle_;     // Windows 文件句柄
+#else
+    int fd_;           // POSIX 文件描述符
+#endif
+    bool unbuffered_;  // 是否为无缓冲模式
+    int last_error_;   // 最近一次系统错误码
+};
+
+// 只读内存映射文件（用于一次性解析的小文件，如 .torrent，避免先读入缓冲区再解析）
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // 禁止拷贝
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件（path 为 UTF-8 路径），空文件无法映射，返回 false（last_error 为 EINVAL / ERROR_FILE_INVALID）
+    bool open(const std::string& path);
+
+    // 解除映射
+    void close();
+
+    inline const char* data() const { return data_; }
+    inline size_t size() const { return size_; }
+
+    // 最近一次失败的系统错误码
+    inline int last_error() const { return last_error_; }
+
+private:
+    const char* data_;  // 映射地址
+    size_t size_;       // 文件大小
+    int last_error_;    // 最近一次系统错误码
+};
+
+#endif // RAW_FILE_HPP
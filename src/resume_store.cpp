@@ -0,0 +1,214 @@
+#include "resume_store.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <sstream>
+#include <algorithm>
+#include <libtorrent/read_resume_data.hpp>
+#include <libtorrent/write_resume_data.hpp>
+
+ResumeStore::ResumeStore(const std::string& state_dir, int writer_threads)
+    : stopping_(false)
+{
+    set_state_dir(state_dir);
+    for (int i = 0; i < std::max(1, writer_threads); ++i) {
+        writers_.emplace_back(&ResumeStore::writer_loop, this);
+    }
+}
+
+ResumeStore::~ResumeStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_changed_.notify_all();
+    for (auto& writer : writers_) {
+        writer.join();
+    }
+}
+
+void ResumeStore::set_state_dir(const std::string& state_dir)
+{
+    namespace fs = std::filesystem;
+
+    if (!state_dir.empty()) {
+        std::error_code ec;
+        fs::create_directories(fs::u8path(state_dir), ec);
+        if (ec) {
+            std::cerr << "警告: 无法创建状态目录，不保存恢复数据: " << state_dir << " (" << ec.message() << ")" << std::endl;
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_dir_.clear();
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_dir_ = state_dir;
+}
+
+std::string ResumeStore::state_dir() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_dir_;
+}
+
+std::string ResumeStore::path_for(const lt::info_hash_t& info_hashes) const
+{
+    // 与 TorrentManager 的标识一致：优先 v1 哈希，仅 v2 的 torrent 使用 v2 哈希
+    std::ostringstream oss;
+    if (info_hashes.has_v1()) {
+        oss << info_hashes.v1;
+    } else {
+        oss << info_hashes.v2;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_dir_.empty()) {
+        return std::string();
+    }
+    return (std::filesystem::u8path(state_dir_) / (oss.str() + ".resume")).u8string();
+}
+
+bool ResumeStore::has(const lt::info_hash_t& info_hashes) const
+{
+    std::string path = path_for(info_hashes);
+    std::error_code ec;
+    return !path.empty() && std::filesystem::exists(std::filesystem::u8path(path), ec);
+}
+
+bool ResumeStore::load(const lt::torrent_info& ti, const std::string& save_path, lt::add_torrent_params& params) const
+{
+    namespace fs = std::filesystem;
+
+    std::string path = path_for(ti.info_hashes());
+    if (path.empty()) {
+        return false;
+    }
+    try {
+        std::ifstream in(fs::u8path(path), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::vector<char> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        lt::error_code ec;
+        lt::add_torrent_params resume = lt::read_resume_data(buffer, ec);
+        if (ec) {
+            std::cerr << "警告: 恢复数据格式错误，忽略: " << path << " (" << ec.message() << ")" << std::endl;
+            return false;
+        }
+        if (!(resume.info_hashes == ti.info_hashes())) {
+            std::cerr << "警告: 恢复数据与 torrent 不匹配，忽略: " << path << std::endl;
+            return false;
+        }
+
+        // 保存路径以调用方为准；libtorrent 加载时仍会核对文件大小，不一致的文件会重新校验
+        resume.ti = params.ti;
+        resume.save_path = save_path;
+        params = std::move(resume);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 读取恢复数据失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void ResumeStore::save_async(const lt::add_torrent_params& params)
+{
+    std::string path = path_for(params.info_hashes);
+    if (path.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 同一 torrent 尚未写入的旧数据直接替换，只写最新的状态
+        auto it = std::find_if(queue_.begin(), queue_.end(),
+                               [&](const std::pair<std::string, lt::add_torrent_params>& item) { return item.first == path; });
+        if (it != queue_.end()) {
+            it->second = params;
+        } else {
+            queue_.emplace_back(path, params);
+        }
+    }
+    queue_changed_.notify_one();
+}
+
+void ResumeStore::remove(const lt::info_hash_t& info_hashes)
+{
+    std::string path = path_for(info_hashes);
+    if (path.empty()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(),
+                                [&](const std::pair<std::string, lt::add_torrent_params>& item) { return item.first == path; }),
+                 queue_.end());
+    queue_changed_.wait(lock, [&] { return writing_.count(path) == 0; });
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::u8path(path), ec);
+}
+
+void ResumeStore::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_changed_.wait(lock, [&] { return queue_.empty() && writing_.empty(); });
+}
+
+void ResumeStore::writer_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // 取出第一个没有被其他线程写入的文件
+        auto it = queue_.end();
+        queue_changed_.wait(lock, [&] {
+            it = std::find_if(queue_.begin(), queue_.end(), [&](const std::pair<std::string, lt::add_torrent_params>& item) {
+                return writing_.count(item.first) == 0;
+            });
+            return stopping_ || it != queue_.end();
+        });
+        if (it == queue_.end()) {
+            return;  // 停止时已没有可写入的数据
+        }
+
+        std::string path = std::move(it->first);
+        lt::add_torrent_params params = std::move(it->second);
+        queue_.erase(it);
+        writing_.insert(path);
+
+        lock.unlock();
+        write_file(params, path);
+        lock.lock();
+
+        writing_.erase(path);
+        queue_changed_.notify_all();
+    }
+}
+
+bool ResumeStore::write_file(const lt::add_torrent_params& params, const std::string& path)
+{
+    namespace fs = std::filesystem;
+
+    try {
+        std::vector<char> buffer = lt::write_resume_data_buf(params);
+
+        // 先写入临时文件再替换，进程在写入过程中退出也不会留下损坏的恢复数据
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream out(fs::u8path(temp_path), std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "警告: 无法写入恢复数据: " << temp_path << std::endl;
+                return false;
+            }
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!out) {
+                std::cerr << "警告: 写入恢复数据失败: " << temp_path << std::endl;
+                return false;
+            }
+        }
+        fs::rename(fs::u8path(temp_path), fs::u8path(path));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 保存恢复数据失败: " << e.what() << std::endl;
+        return false;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef RESUME_STORE_HPP
+#define RESUME_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/info_hash.hpp>
+
+// 会话恢复数据存储（状态目录下每个 torrent 一个 <info_hash>.resume 文件）
+// TorrentManager 在收到 save_resume_data_alert 后交给本类保存：编码和写入由后台写入线程并行完成，不阻塞调用线程
+// 重新启动后 start_download / start_seeding 从这里加载，已下载的分片和做种状态无需重新校验
+class ResumeStore
+{
+public:
+    // state_dir: 状态目录（为空表示不保存恢复数据），writer_threads: 后台写入线程数
+    explicit ResumeStore(const std::string& state_dir = std::string(), int writer_threads = 2);
+    ~ResumeStore();
+
+    ResumeStore(const ResumeStore&) = delete;
+    ResumeStore& operator=(const ResumeStore&) = delete;
+
+    // 设置状态目录（为空表示关闭），目录不存在时自动创建
+    void set_state_dir(const std::string& state_dir);
+
+    // 获取状态目录
+    std::string state_dir() const;
+
+    // 是否启用
+    inline bool enabled() const { return !state_dir().empty(); }
+
+    // 检查是否有指定 torrent 的恢复数据
+    bool has(const lt::info_hash_t& info_hashes) const;
+
+    // 加载恢复数据：info hash 一致时用恢复数据替换 params（保留 ti 和 save_path）
+    // 返回: 是否加载成功
+    bool load(const lt::torrent_info& ti, const std::string& save_path, lt::add_torrent_params& params) const;
+
+    // 在后台保存恢复数据（同一 torrent 尚未写入的旧数据会被替换）
+    void save_async(const lt::add_torrent_params& params);
+
+    // 删除指定 torrent 的恢复数据
+    void remove(const lt::info_hash_t& info_hashes);
+
+    // 等待所有排队的恢复数据写入完成
+    void flush();
+
+private:
+    // 获取恢复数据文件路径
+    std::string path_for(const lt::info_hash_t& info_hashes) const;
+
+    // 后台写入线程
+    void writer_loop();
+
+    // 写入一个恢复数据文件（先写临时文件再替换）
+    bool write_file(const lt::add_torrent_params& params, const std::string& path);
+
+private:
+    mutable std::mutex mutex_;                        // 保护以下成员
+    std::condition_variable queue_changed_;           // 队列变化通知
+    std::string state_dir_;                           // 状态目录
+    std::deque<std::pair<std::string, lt::add_torrent_params>> queue_;  // 待写入的恢复数据（文件路径, 参数）
+    std::set<std::string> writing_;                   // 正在写入的文件（同一文件不会被两个线程同时写入）
+    bool stopping_;                                   // 是否正在停止
+    std::vector<std::thread> writers_;                // 后台写入线程
+};
+
+#endif // RESUME_STORE_HPP
@@ -0,0 +1,167 @@
+#include "seed_resume.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/bdecode.hpp>
+#include <libtorrent/entry.hpp>
+#include <libtorrent/read_resume_data.hpp>
+#include <libtorrent/write_resume_data.hpp>
+
+bool SeedResume::stat_file(const std::string& path, std::int64_t& size, std::int64_t& mtime)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::path file_path = fs::u8path(path);
+    auto file_size = fs::file_size(file_path, ec);
+    if (ec) {
+        return false;
+    }
+    auto write_time = fs::last_write_time(file_path, ec);
+    if (ec) {
+        return false;
+    }
+    size = static_cast<std::int64_t>(file_size);
+    mtime = static_cast<std::int64_t>(write_time.time_since_epoch().count());
+    return true;
+}
+
+void SeedResume::record_files(const lt::file_storage& fs_storage, const std::string& root_path,
+                              const ScannedMtimes* scanned)
+{
+    files_.assign(fs_storage.num_files(), std::make_pair(std::int64_t(0), std::int64_t(0)));
+    for (int i = 0; i < fs_storage.num_files(); ++i) {
+        lt::file_index_t index(i);
+        if (fs_storage.pad_file_at(index)) {
+            files_[i].first = fs_storage.file_size(index);
+            continue;
+        }
+        std::int64_t size = -1;
+        std::int64_t mtime = -1;
+        if (DirectoryScanner::find_mtime(scanned, fs_storage, index, mtime)) {
+            files_[i] = std::make_pair(fs_storage.file_size(index), mtime);
+        } else if (stat_file(fs_storage.file_path(index, root_path), size, mtime)) {
+            files_[i] = std::make_pair(size, mtime);
+        } else {
+            files_[i] = std::make_pair(std::int64_t(-1), std::int64_t(-1));
+        }
+    }
+}
+
+bool SeedResume::save(const std::string& resume_path, const lt::info_hash_t& info_hashes,
+                      const std::string& save_path, int num_pieces) const
+{
+    namespace fs = std::filesystem;
+
+    try {
+        lt::add_torrent_params params;
+        params.info_hashes = info_hashes;
+        params.save_path = save_path;
+        params.have_pieces.resize(num_pieces, true);
+
+        lt::entry resume = lt::write_resume_data(params);
+
+        lt::entry::list_type file_sizes;
+        for (const auto& file : files_) {
+            lt::entry::list_type item;
+            item.push_back(lt::entry(file.first));
+            item.push_back(lt::entry(file.second));
+            file_sizes.push_back(lt::entry(std::move(item)));
+        }
+        resume["file sizes"] = std::move(file_sizes);
+
+        std::vector<char> buffer;
+        lt::bencode(std::back_inserter(buffer), resume);
+
+        // 先写入临时文件再替换，避免中途失败留下损坏的恢复数据
+        std::string temp_path = resume_path + ".tmp";
+        {
+            std::ofstream out(fs::u8path(temp_path), std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "警告: 无法写入快速恢复数据: " << temp_path << std::endl;
+                return false;
+            }
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!out) {
+                std::cerr << "警告: 写入快速恢复数据失败: " << temp_path << std::endl;
+                return false;
+            }
+        }
+        fs::rename(fs::u8path(temp_path), fs::u8path(resume_path));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 保存快速恢复数据失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SeedResume::load(const std::string& resume_path, const lt::torrent_info& ti,
+                      const std::string& save_path, lt::add_torrent_params& params)
+{
+    namespace fs = std::filesystem;
+
+    try {
+        std::ifstream in(fs::u8path(resume_path), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::vector<char> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        lt::error_code ec;
+        lt::bdecode_node root = lt::bdecode(buffer, ec);
+        if (ec || root.type() != lt::bdecode_node::dict_t) {
+            std::cerr << "警告: 快速恢复数据格式错误，将进行完整校验: " << resume_path << std::endl;
+            return false;
+        }
+
+        lt::add_torrent_params resume = lt::read_resume_data(root, ec);
+        if (ec) {
+            std::cerr << "警告: 解析快速恢复数据失败，将进行完整校验: " << ec.message() << std::endl;
+            return false;
+        }
+        if (!(resume.info_hashes == ti.info_hashes())) {
+            std::cout << "快速恢复数据与 torrent 不匹配，将进行完整校验: " << resume_path << std::endl;
+            return false;
+        }
+        if (resume.have_pieces.size() != ti.num_pieces()) {
+            std::cout << "快速恢复数据的分片数量不匹配，将进行完整校验: " << resume_path << std::endl;
+            return false;
+        }
+
+        // 核对每个文件的大小和修改时间（生成 torrent 之后被修改过的文件需要重新校验）
+        const lt::file_storage& files = ti.files();
+        lt::bdecode_node file_sizes = root.dict_find_list("file sizes");
+        if (!file_sizes || file_sizes.list_size() != files.num_files()) {
+            std::cout << "快速恢复数据缺少文件信息，将进行完整校验: " << resume_path << std::endl;
+            return false;
+        }
+        for (int i = 0; i < files.num_files(); ++i) {
+            lt::file_index_t index(i);
+            if (files.pad_file_at(index)) continue;
+
+            lt::bdecode_node item = file_sizes.list_at(i);
+            if (item.type() != lt::bdecode_node::list_t || item.list_size() < 2) {
+                return false;
+            }
+            std::int64_t size = -1;
+            std::int64_t mtime = -1;
+            std::string file_path = files.file_path(index, save_path);
+            if (!stat_file(file_path, size, mtime)) {
+                std::cout << "文件不存在，将进行完整校验: " << file_path << std::endl;
+                return false;
+            }
+            if (size != item.list_int_value_at(0) || mtime != item.list_int_value_at(1)) {
+                std::cout << "文件在生成 torrent 后已被修改，将进行完整校验: " << file_path << std::endl;
+                return false;
+            }
+        }
+
+        params.have_pieces = resume.have_pieces;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 读取快速恢复数据失败: " << e.what() << std::endl;
+        return false;
+    }
+}
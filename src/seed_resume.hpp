@@ -0,0 +1,47 @@
+#ifndef SEED_RESUME_HPP
+#define SEED_RESUME_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/info_hash.hpp>
+#include <libtorrent/add_torrent_params.hpp>
+#include "directory_scanner.hpp"
+
+// 做种快速恢复数据（<torrent>.resume 旁路文件）
+// 由 TorrentBuilder 在计算完所有分片哈希后写入：libtorrent 标准恢复数据（全部分片已校验）
+// 外加每个文件的大小和修改时间（"file sizes"，与 libtorrent 1.x 格式相同）
+// start_seeding 加载时先核对 info hash 和磁盘上的文件状态，全部一致才跳过重新校验
+class SeedResume
+{
+public:
+    // 获取 torrent 对应的恢复数据文件路径
+    static inline std::string path_for(const std::string& torrent_path) { return torrent_path + ".resume"; }
+
+    // 记录文件大小和修改时间（需在计算哈希之前调用，计算期间被修改的文件不会被误认为已校验）
+    // root_path: 文件所在的根路径（与 fs_storage 中的相对路径拼接）
+    // scanned: 目录扫描时记录的修改时间（可为空，未记录的文件直接读取文件系统）
+    void record_files(const lt::file_storage& fs_storage, const std::string& root_path,
+                      const ScannedMtimes* scanned = nullptr);
+
+    // 写入恢复数据（所有分片标记为已拥有）
+    // save_path: 做种时的保存路径（仅作记录，加载时以 start_seeding 的参数为准）
+    bool save(const std::string& resume_path, const lt::info_hash_t& info_hashes,
+              const std::string& save_path, int num_pieces) const;
+
+    // 加载恢复数据并与 torrent 和磁盘文件核对
+    // 一致时将已拥有的分片写入 params.have_pieces 并返回 true；文件不存在或不一致时返回 false（需要完整校验）
+    static bool load(const std::string& resume_path, const lt::torrent_info& ti,
+                     const std::string& save_path, lt::add_torrent_params& params);
+
+private:
+    // 读取文件当前的大小和修改时间，不存在时返回 false
+    static bool stat_file(const std::string& path, std::int64_t& size, std::int64_t& mtime);
+
+private:
+    std::vector<std::pair<std::int64_t, std::int64_t>> files_;  // 每个文件的 (大小, 修改时间)，pad 文件为 (大小, 0)
+};
+
+#endif // SEED_RESUME_HPP
@@ -1,4 +1,9 @@
 #include "seeder.hpp"
+#include "seed_resume.hpp"
+#include "torrent_file_cache.hpp"
+#include "session_profile.hpp"
+#include "torrent_policy.hpp"
+#include <libtorrent/ip_filter.hpp>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -53,45 +58,24 @@ Seeder::~Seeder()
 void Seeder::configure_session()
 {
     try {
-        // 创建 session 配置
-        lt::settings_pack settings;
+        // 使用进程默认的会话配置（默认 wan，可通过 --profile 选择），与 TorrentManager 相同
+        SessionProfile profile = SessionProfile::get_default();
+        lt::settings_pack settings = profile.to_settings();
         settings.set_int(lt::settings_pack::alert_mask, 
                          lt::alert::status_notification | 
                          lt::alert::error_notification |
                          lt::alert::peer_notification |
                          lt::alert::storage_notification);
         
-        // 设置监听接口（空字符串表示自动选择）
-        settings.set_str(lt::settings_pack::listen_interfaces, "0.0.0.0:0");
-        
-        // 启用 DHT
-        settings.set_bool(lt::settings_pack::enable_dht, false);
-        
-        // 启用本地服务发现
-        settings.set_bool(lt::settings_pack::enable_lsd, true);
-        
-        // 启用 UPnP 和 NAT-PMP
-        settings.set_bool(lt::settings_pack::enable_upnp, true);
-        settings.set_bool(lt::settings_pack::enable_natpmp, true);
-        
-        // 设置上传/下载速度限制（0 表示无限制）
-        settings.set_int(lt::settings_pack::download_rate_limit, 0);
-        settings.set_int(lt::settings_pack::upload_rate_limit, 0);
-        
-        // 设置最大连接数（大文件需要更多连接）
-        settings.set_int(lt::settings_pack::connections_limit, 200);
-        
-        // 设置磁盘缓存大小（大文件需要更大的缓存）
-        // 默认是32MB，对于大文件可以增加到256MB
-        settings.set_int(lt::settings_pack::cache_size, 256);
-        
-        // 设置磁盘缓存过期时间（毫秒）
-        settings.set_int(lt::settings_pack::cache_expiry, 300);
-        
         // 创建 session
         session_ = std::make_unique<lt::session>(settings);
         
-        std::cout << "Seeder 会话已初始化" << std::endl;
+        lt::ip_filter filter;
+        if (profile.build_ip_filter(filter)) {
+            session_->set_ip_filter(filter);
+        }
+        
+        std::cout << "Seeder 会话已初始化（会话配置: " << profile.name << "）" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "初始化 Seeder 会话失败: " << e.what() << std::endl;
         throw;
@@ -128,25 +112,14 @@ bool Seeder::start_seeding(const std::string& torrent_path, const std::string& s
             return false;
         }
         
-        // 加载 torrent 文件
-        std::ifstream torrent_file(torrent_path, std::ios::binary);
-        if (!torrent_file.is_open()) {
-            std::cerr << "错误: 无法打开 torrent 文件: " << torrent_path << std::endl;
-            return false;
-        }
-        
-        // 读取 torrent 文件内容
-        std::vector<char> torrent_data((std::istreambuf_iterator<char>(torrent_file)),
-                                       std::istreambuf_iterator<char>());
-        torrent_file.close();
-        
-        // 解析 torrent 文件，先获取 torrent_info 以检查文件大小
+        // 解析 torrent 文件（内存映射后解析，结果与 TorrentFileCache 共享），先获取 torrent_info 以检查文件大小
         lt::error_code ec;
-        lt::torrent_info ti(torrent_path, ec);
+        auto ti_ptr = TorrentFileCache::load_for_session(torrent_path, ec);
         if (ec) {
             std::cerr << "错误: 解析 torrent 文件失败: " << ec.message() << std::endl;
             return false;
         }
+        const lt::torrent_info& ti = *ti_ptr;
         
         // 获取 torrent 文件大小
         std::int64_t torrent_size = ti.total_size();
@@ -205,32 +178,28 @@ bool Seeder::start_seeding(const std::string& torrent_path, const std::string& s
         
         // 创建 add_torrent_params
         lt::add_torrent_params params;
-        params.ti = std::make_shared<lt::torrent_info>(ti);
+        params.ti = ti_ptr;
         params.save_path = save_path;
         
-        // 对于大文件（>50GB），如果文件存在，使用 seed_mode 跳过验证以快速启动做种
-        // 对于小文件或文件不存在，让 libtorrent 自动验证
-        const std::int64_t large_file_threshold = 50LL * 1024 * 1024 * 1024; // 50GB
-        
-        if (torrent_size > large_file_threshold && files_exist) {
-            // 大文件且文件存在：使用 seed_mode 跳过验证，快速启动做种
-            std::cout << "检测到大文件（总大小: " 
-                      << format_bytes(torrent_size) 
-                      << "），文件已存在，使用快速模式启动做种..." << std::endl;
+        // 按分类策略设置连接数和队列（与 TorrentManager 相同）
+        const TorrentPolicy policy = TorrentPolicy::get_default();
+        const TorrentClass& torrent_class = policy.classify(ti);
+        
+        // 优先使用生成 torrent 时写入的快速恢复数据（文件状态一致时无需重新校验）
+        const std::string resume_path = SeedResume::path_for(torrent_path);
+        if (SeedResume::load(resume_path, ti, save_path, params)) {
+            std::cout << "已加载快速恢复数据，跳过文件校验直接做种: " << resume_path << std::endl;
+        } else if (torrent_class.trust_existing_files && files_exist && TorrentPolicy::data_present(ti, save_path)) {
+            // 分类信任已有文件且所有文件大小一致：使用 seed_mode 跳过校验，快速启动做种
+            std::cout << "分类 " << torrent_class.name << " 信任已有文件（总大小: "
+                      << format_bytes(torrent_size) << "），跳过校验直接做种..." << std::endl;
             params.flags |= lt::torrent_flags::seed_mode;
-            params.flags |= lt::torrent_flags::auto_managed;
         } else {
-            // 小文件或文件不存在：让 libtorrent 自动验证
-            if (torrent_size > large_file_threshold) {
-                std::cout << "检测到大文件（总大小: " 
-                          << format_bytes(torrent_size) 
-                          << "），将进行文件验证（可能需要一些时间）..." << std::endl;
-            }
-            params.flags |= lt::torrent_flags::auto_managed;
+            // 让 libtorrent 校验文件
+            std::cout << "将由 libtorrent 校验文件（总大小: " << format_bytes(torrent_size)
+                      << "，分类: " << torrent_class.name << "）..." << std::endl;
         }
-        
-        // 确保做种时不被暂停
-        params.flags &= ~lt::torrent_flags::paused;
+        torrent_class.apply(params, true);
         
         // 添加 torrent 到 session
         lt::torrent_handle th = session_->add_torrent(params, ec);
@@ -239,6 +208,7 @@ bool Seeder::start_seeding(const std::string& torrent_path, const std::string& s
             std::cerr << "错误: 添加 torrent 失败: " << ec.message() << std::endl;
             return false;
         }
+        torrent_class.apply_handle(th);
         
         // 对于做种，不需要设置 upload_mode
         // upload_mode 主要用于下载时控制是否允许上传
@@ -384,6 +354,9 @@ bool Seeder::wait_and_process(int timeout_ms)
     }
     
     try {
+        // 等待 alert（最多 timeout_ms），有 alert 时立即返回处理，而不是处理完再固定休眠
+        session_->wait_for_alert(lt::milliseconds(timeout_ms));
+        
         // 处理 alerts
         std::vector<lt::alert*> alerts;
         session_->pop_alerts(&alerts);
@@ -448,9 +421,6 @@ bool Seeder::wait_and_process(int timeout_ms)
             }
         }
         
-        // 等待指定时间
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
-        
         // 清理无效的 torrent 句柄
         torrent_handles_.erase(
             std::remove_if(torrent_handles_.begin(), torrent_handles_.end(),
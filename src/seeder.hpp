@@ -34,6 +34,7 @@ public:
     void print_status() const;
     
     // 等待并处理事件（用于保持做种状态）
+    // 最多等待 timeout_ms，有 alert 时立即返回
     // 返回 false 表示应该退出
     bool wait_and_process(int timeout_ms = 1000);
     
@@ -0,0 +1,488 @@
+#include "session_profile.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <cstdint>
+#include <boost/asio/ip/address.hpp>
+
+namespace {
+
+// 去掉首尾空白
+std::string trim(const std::string& text)
+{
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+bool parse_bool(const std::string& value, bool& result)
+{
+    std::string lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (lower == "true" || lower == "1" || lower == "yes" || lower == "on") {
+        result = true;
+        return true;
+    }
+    if (lower == "false" || lower == "0" || lower == "no" || lower == "off") {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+bool parse_int(const std::string& value, int& result)
+{
+    try {
+        size_t used = 0;
+        long long parsed = std::stoll(value, &used, 0);
+        if (used != value.size() || parsed < INT32_MIN || parsed > INT32_MAX) {
+            return false;
+        }
+        result = static_cast<int>(parsed);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// 按逗号分隔
+std::vector<std::string> split_list(const std::string& value)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// 解析 CIDR 网段为地址范围
+bool parse_network(const std::string& cidr, boost::asio::ip::address& first, boost::asio::ip::address& last)
+{
+    size_t slash = cidr.find('/');
+    boost::system::error_code ec;
+    boost::asio::ip::address base = boost::asio::ip::make_address(cidr.substr(0, slash), ec);
+    if (ec) {
+        return false;
+    }
+    const int max_prefix = base.is_v4() ? 32 : 128;
+    int prefix = max_prefix;
+    if (slash != std::string::npos && (!parse_int(cidr.substr(slash + 1), prefix) || prefix < 0 || prefix > max_prefix)) {
+        return false;
+    }
+
+    // 按字节计算：前 prefix 位保留，其余位在起始地址中清零，在结束地址中置一
+    auto apply_mask = [prefix](auto bytes, bool fill) {
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            int keep = std::max(0, std::min(8, prefix - static_cast<int>(i) * 8));
+            unsigned char host_mask = static_cast<unsigned char>(0xFF >> keep);
+            bytes[i] = static_cast<unsigned char>(fill ? (bytes[i] | host_mask) : (bytes[i] & ~host_mask));
+        }
+        return bytes;
+    };
+    if (base.is_v4()) {
+        auto bytes = base.to_v4().to_bytes();
+        first = boost::asio::ip::address_v4(apply_mask(bytes, false));
+        last = boost::asio::ip::address_v4(apply_mask(bytes, true));
+    } else {
+        auto bytes = base.to_v6().to_bytes();
+        first = boost::asio::ip::address_v6(apply_mask(bytes, false));
+        last = boost::asio::ip::address_v6(apply_mask(bytes, true));
+    }
+    return true;
+}
+
+// 设置配置字段，不属于 SessionProfile 字段的键保存到 extra_settings
+bool set_field(SessionProfile& profile, const std::string& key, const std::string& value)
+{
+    struct BoolField { const char* key; bool SessionProfile::*member; };
+    struct IntField { const char* key; int SessionProfile::*member; };
+    static const BoolField bool_fields[] = {
+        {"enable_dht", &SessionProfile::enable_dht},
+        {"enable_lsd", &SessionProfile::enable_lsd},
+        {"enable_upnp", &SessionProfile::enable_upnp},
+        {"enable_natpmp", &SessionProfile::enable_natpmp},
+        {"enable_outgoing_utp", &SessionProfile::enable_outgoing_utp},
+        {"prefer_tcp", &SessionProfile::prefer_tcp},
+        {"allow_multiple_connections_per_ip", &SessionProfile::allow_multiple_connections_per_ip},
+    };
+    static const IntField int_fields[] = {
+        {"connections_limit", &SessionProfile::connections_limit},
+        {"min_announce_interval", &SessionProfile::min_announce_interval},
+        {"cache_size", &SessionProfile::cache_size},
+        {"cache_expiry", &SessionProfile::cache_expiry},
+        {"max_queued_disk_bytes", &SessionProfile::max_queued_disk_bytes},
+        {"send_buffer_low_watermark", &SessionProfile::send_buffer_low_watermark},
+        {"send_buffer_watermark", &SessionProfile::send_buffer_watermark},
+        {"send_buffer_watermark_factor", &SessionProfile::send_buffer_watermark_factor},
+        {"max_out_request_queue", &SessionProfile::max_out_request_queue},
+        {"max_allowed_in_request_queue", &SessionProfile::max_allowed_in_request_queue},
+    };
+
+    for (const auto& field : bool_fields) {
+        if (key == field.key) {
+            return parse_bool(value, profile.*field.member);
+        }
+    }
+    for (const auto& field : int_fields) {
+        if (key == field.key) {
+            return parse_int(value, profile.*field.member);
+        }
+    }
+    if (key == "listen_interfaces") {
+        profile.listen_interfaces = value;
+        return true;
+    }
+    if (key == "dht_bootstrap_nodes") {
+        profile.dht_bootstrap_nodes = value;
+        return true;
+    }
+    if (key == "allowed_networks") {
+        profile.allowed_networks = split_list(value);
+        boost::asio::ip::address first, last;
+        for (const auto& network : profile.allowed_networks) {
+            if (!parse_network(network, first, last)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (key == "alert_mask") {
+        return false;  // alert_mask 由各类自行管理，配置中不能修改
+    }
+    if (lt::setting_by_name(key) < 0) {
+        return false;
+    }
+    profile.extra_settings.emplace_back(key, value);
+    return true;
+}
+
+// 进程默认配置
+std::mutex default_mutex;
+SessionProfile& default_profile()
+{
+    static SessionProfile profile;
+    return profile;
+}
+
+} // namespace
+
+SessionProfile::SessionProfile()
+    : name("wan")
+    , listen_interfaces("0.0.0.0:6881-6891,[::]:6881-6891")
+    , enable_dht(true)
+    , enable_lsd(true)
+    , enable_upnp(true)
+    , enable_natpmp(true)
+    , dht_bootstrap_nodes("router.bittorrent.com:6881,"
+                          "router.utorrent.com:6881,"
+                          "dht.transmissionbt.com:6881,"
+                          "dht.aelitis.com:6881")
+    , enable_outgoing_utp(true)
+    , prefer_tcp(false)
+    , connections_limit(200)
+    , allow_multiple_connections_per_ip(true)
+    , min_announce_interval(30)
+    , cache_size(512)
+    , cache_expiry(300)
+    , max_queued_disk_bytes(1024 * 1024 * 1024)  // 1GB
+    , send_buffer_low_watermark(10 * 1024)       // 发送缓冲区和请求队列使用 libtorrent 默认值
+    , send_buffer_watermark(500 * 1024)
+    , send_buffer_watermark_factor(50)
+    , max_out_request_queue(500)
+    , max_allowed_in_request_queue(500)
+{
+}
+
+bool SessionProfile::builtin(const std::string& name, SessionProfile& profile)
+{
+    SessionProfile result;
+    if (name == "wan") {
+        // 公网：与原 TorrentManager 的配置相同
+    } else if (name == "lan") {
+        // 封闭的万兆局域网：不做公网发现和端口映射，只连接局域网地址；
+        // 优先 TCP（uTP 的拥塞控制在低延迟高带宽链路上限制吞吐量），加大发送缓冲区和请求队列以填满带宽
+        result.enable_dht = false;
+        result.enable_upnp = false;
+        result.enable_natpmp = false;
+        result.dht_bootstrap_nodes.clear();
+        result.enable_outgoing_utp = false;
+        result.prefer_tcp = true;
+        result.allowed_networks = {"10.0.0.0/8", "172.16.0.0/12", "192.168.0.0/16", "169.254.0.0/16",
+                                   "127.0.0.0/8", "fc00::/7", "fe80::/10", "::1/128"};
+        result.cache_size = 2048;
+        result.send_buffer_low_watermark = 1024 * 1024;    // 1MB
+        result.send_buffer_watermark = 16 * 1024 * 1024;   // 16MB
+        result.send_buffer_watermark_factor = 150;
+        result.max_out_request_queue = 1500;
+        result.max_allowed_in_request_queue = 2000;
+    } else if (name == "low-memory") {
+        // 低内存：减少连接数、磁盘队列、发送缓冲区和请求队列
+        result.connections_limit = 50;
+        result.cache_size = 64;
+        result.max_queued_disk_bytes = 4 * 1024 * 1024;   // 4MB
+        result.send_buffer_low_watermark = 8 * 1024;
+        result.send_buffer_watermark = 128 * 1024;
+        result.send_buffer_watermark_factor = 50;
+        result.max_out_request_queue = 100;
+        result.max_allowed_in_request_queue = 100;
+    } else {
+        return false;
+    }
+    result.name = name;
+    profile = result;
+    return true;
+}
+
+std::vector<std::string> SessionProfile::builtin_names()
+{
+    return {"wan", "lan", "low-memory"};
+}
+
+lt::settings_pack SessionProfile::to_settings() const
+{
+    lt::settings_pack settings;
+    settings.set_str(lt::settings_pack::listen_interfaces, listen_interfaces);
+    settings.set_bool(lt::settings_pack::enable_dht, enable_dht);
+    settings.set_bool(lt::settings_pack::enable_lsd, enable_lsd);
+    settings.set_bool(lt::settings_pack::enable_upnp, enable_upnp);
+    settings.set_bool(lt::settings_pack::enable_natpmp, enable_natpmp);
+    settings.set_str(lt::settings_pack::dht_bootstrap_nodes, dht_bootstrap_nodes);
+
+    settings.set_bool(lt::settings_pack::enable_incoming_tcp, true);
+    settings.set_bool(lt::settings_pack::enable_outgoing_tcp, true);
+    settings.set_bool(lt::settings_pack::enable_incoming_utp, true);
+    settings.set_bool(lt::settings_pack::enable_outgoing_utp, enable_outgoing_utp);
+    settings.set_int(lt::settings_pack::mixed_mode_algorithm,
+                     prefer_tcp ? lt::settings_pack::prefer_tcp : lt::settings_pack::peer_proportional);
+
+    // 上传/下载速度不限制
+    settings.set_int(lt::settings_pack::download_rate_limit, 0);
+    settings.set_int(lt::settings_pack::upload_rate_limit, 0);
+    settings.set_int(lt::settings_pack::connections_limit, connections_limit);
+    settings.set_bool(lt::settings_pack::allow_multiple_connections_per_ip, allow_multiple_connections_per_ip);
+    settings.set_int(lt::settings_pack::min_announce_interval, min_announce_interval);
+
+    settings.set_int(lt::settings_pack::cache_size, cache_size);
+    settings.set_int(lt::settings_pack::cache_expiry, cache_expiry);
+    settings.set_int(lt::settings_pack::max_queued_disk_bytes, max_queued_disk_bytes);
+    settings.set_int(lt::settings_pack::send_buffer_low_watermark, send_buffer_low_watermark);
+    settings.set_int(lt::settings_pack::send_buffer_watermark, send_buffer_watermark);
+    settings.set_int(lt::settings_pack::send_buffer_watermark_factor, send_buffer_watermark_factor);
+    settings.set_int(lt::settings_pack::max_out_request_queue, max_out_request_queue);
+    settings.set_int(lt::settings_pack::max_allowed_in_request_queue, max_allowed_in_request_queue);
+
+    // 配置文件中的其他 libtorrent 设置（加载时已检查设置名）
+    for (const auto& extra : extra_settings) {
+        int setting = lt::setting_by_name(extra.first);
+        if (setting < 0) {
+            continue;
+        }
+        switch (setting & lt::settings_pack::type_mask) {
+            case lt::settings_pack::string_type_base:
+                settings.set_str(setting, extra.second);
+                break;
+            case lt::settings_pack::int_type_base: {
+                int value;
+                if (parse_int(extra.second, value)) {
+                    settings.set_int(setting, value);
+                }
+                break;
+            }
+            case lt::settings_pack::bool_type_base: {
+                bool value;
+                if (parse_bool(extra.second, value)) {
+                    settings.set_bool(setting, value);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return settings;
+}
+
+bool SessionProfile::build_ip_filter(lt::ip_filter& filter) const
+{
+    lt::ip_filter result;
+    if (!allowed_networks.empty()) {
+        // 先屏蔽所有地址，再放开允许的网段
+        result.add_rule(boost::asio::ip::make_address("0.0.0.0"), boost::asio::ip::make_address("255.255.255.255"),
+                        lt::ip_filter::blocked);
+        result.add_rule(boost::asio::ip::make_address("::"),
+                        boost::asio::ip::make_address("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"),
+                        lt::ip_filter::blocked);
+        for (const auto& network : allowed_networks) {
+            boost::asio::ip::address first, last;
+            if (!parse_network(network, first, last)) {
+                std::cerr << "错误: 无效的网段: " << network << std::endl;
+                return false;
+            }
+            result.add_rule(first, last, 0);
+        }
+    }
+    filter = result;
+    return true;
+}
+
+void SessionProfile::print() const
+{
+    std::cout << "会话配置: " << name << std::endl;
+    std::cout << "  监听地址: " << listen_interfaces << std::endl;
+    std::cout << "  DHT: " << (enable_dht ? "启用" : "禁用")
+              << "，LSD: " << (enable_lsd ? "启用" : "禁用")
+              << "，UPnP/NAT-PMP: " << (enable_upnp || enable_natpmp ? "启用" : "禁用") << std::endl;
+    std::cout << "  传输: " << (enable_outgoing_utp ? "TCP + uTP" : "TCP（只接受传入的 uTP）")
+              << (prefer_tcp ? "，优先 TCP" : "") << std::endl;
+    if (allowed_networks.empty()) {
+        std::cout << "  允许的网段: 不限制" << std::endl;
+    } else {
+        std::cout << "  允许的网段:";
+        for (const auto& network : allowed_networks) {
+            std::cout << " " << network;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  最大连接数: " << connections_limit
+              << "，发送缓冲区: " << send_buffer_low_watermark / 1024 << " KB - " << send_buffer_watermark / 1024
+              << " KB（" << send_buffer_watermark_factor << "%）"
+              << "，请求队列: " << max_out_request_queue << " / " << max_allowed_in_request_queue << std::endl;
+    if (!extra_settings.empty()) {
+        std::cout << "  其他设置:";
+        for (const auto& extra : extra_settings) {
+            std::cout << " " << extra.first << "=" << extra.second;
+        }
+        std::cout << std::endl;
+    }
+}
+
+bool SessionProfile::load_file(const std::string& path, std::vector<SessionProfile>& profiles)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "错误: 无法打开会话配置文件: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<SessionProfile> loaded;
+    std::string line;
+    int line_number = 0;
+    bool ok = true;
+    while (std::getline(in, line)) {
+        ++line_number;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+
+        if (line.front() == '[' && line.back() == ']') {
+            SessionProfile profile;
+            profile.name = trim(line.substr(1, line.size() - 2));
+            loaded.push_back(profile);
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || loaded.empty()) {
+            std::cerr << "错误: " << path << ":" << line_number << " 格式错误: " << line << std::endl;
+            ok = false;
+            continue;
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        SessionProfile& profile = loaded.back();
+
+        if (key == "base") {
+            // 继承内置配置（或同一文件中前面的配置），之后的键覆盖继承的值
+            SessionProfile base;
+            bool found = builtin(value, base);
+            for (size_t i = 0; !found && i + 1 < loaded.size(); ++i) {
+                if (loaded[i].name == value) {
+                    base = loaded[i];
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::cerr << "错误: " << path << ":" << line_number << " 未知的基础配置: " << value << std::endl;
+                ok = false;
+                continue;
+            }
+            base.name = profile.name;
+            profile = base;
+            continue;
+        }
+
+        if (!set_field(profile, key, value)) {
+            std::cerr << "错误: " << path << ":" << line_number << " 无效的设置: " << key << " = " << value << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        return false;
+    }
+    if (loaded.empty()) {
+        std::cerr << "错误: 会话配置文件中没有配置: " << path << std::endl;
+        return false;
+    }
+    profiles.insert(profiles.end(), loaded.begin(), loaded.end());
+    return true;
+}
+
+bool SessionProfile::resolve(const std::string& spec, SessionProfile& profile)
+{
+    if (builtin(spec, profile)) {
+        return true;
+    }
+
+    // 配置文件路径[:名称]（Windows 盘符中的冒号不作为分隔符）
+    std::string path = spec;
+    std::string name;
+    size_t colon = spec.rfind(':');
+    if (colon != std::string::npos && colon > 1 && spec.find_first_of("/\\", colon) == std::string::npos) {
+        path = spec.substr(0, colon);
+        name = spec.substr(colon + 1);
+    }
+
+    std::vector<SessionProfile> profiles;
+    if (!load_file(path, profiles)) {
+        return false;
+    }
+    if (name.empty()) {
+        profile = profiles.front();
+        return true;
+    }
+    for (const auto& candidate : profiles) {
+        if (candidate.name == name) {
+            profile = candidate;
+            return true;
+        }
+    }
+    std::cerr << "错误: 配置文件中没有名为 " << name << " 的配置: " << path << std::endl;
+    return false;
+}
+
+void SessionProfile::set_default(const SessionProfile& profile)
+{
+    std::lock_guard<std::mutex> lock(default_mutex);
+    default_profile() = profile;
+}
+
+SessionProfile SessionProfile::get_default()
+{
+    std::lock_guard<std::mutex> lock(default_mutex);
+    return default_profile();
+}
@@ -0,0 +1,77 @@
+#ifndef SESSION_PROFILE_HPP
+#define SESSION_PROFILE_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <libtorrent/settings_pack.hpp>
+#include <libtorrent/ip_filter.hpp>
+
+// 会话调优配置（命名配置）
+// 内置 wan（默认，公网）、lan（封闭的万兆局域网）和 low-memory（低内存）三种，也可从配置文件加载
+// TorrentManager、Downloader 和 Seeder 创建 session 时使用当前的默认配置；TorrentManager 可在运行时通过 apply_settings 切换
+struct SessionProfile {
+    std::string name;                          // 配置名称
+
+    // 网络
+    std::string listen_interfaces;             // 监听地址（libtorrent listen_interfaces 格式）
+    bool enable_dht;                           // DHT
+    bool enable_lsd;                           // 本地服务发现
+    bool enable_upnp;                          // UPnP 端口映射
+    bool enable_natpmp;                        // NAT-PMP 端口映射
+    std::string dht_bootstrap_nodes;           // DHT 引导节点
+    bool enable_outgoing_utp;                  // 主动发起 uTP 连接（传入的 uTP 连接始终接受）
+    bool prefer_tcp;                           // 混合 TCP/uTP 时优先 TCP（不按比例限制 TCP 速率）
+    std::vector<std::string> allowed_networks; // 只允许这些网段的 peer（CIDR，如 10.0.0.0/8），为空表示不限制
+
+    // 连接
+    int connections_limit;                     // 最大连接数
+    bool allow_multiple_connections_per_ip;    // 允许同一 IP 的多个连接
+    int min_announce_interval;                 // 最短 announce 间隔（秒）
+
+    // 磁盘和缓冲区
+    int cache_size;                            // 磁盘缓存（16 KiB 块）
+    int cache_expiry;                          // 磁盘缓存过期时间
+    int max_queued_disk_bytes;                 // 磁盘写入队列（字节）
+    int send_buffer_low_watermark;             // 发送缓冲区低于该值时从磁盘读取更多数据（字节）
+    int send_buffer_watermark;                 // 发送缓冲区上限（字节）
+    int send_buffer_watermark_factor;          // 按上传速度放大发送缓冲区的百分比
+    int max_out_request_queue;                 // 向每个 peer 发出的未完成请求数上限
+    int max_allowed_in_request_queue;          // 每个 peer 允许排队的请求数上限
+
+    // 其他 libtorrent 设置（配置文件中不属于以上字段的键，按 libtorrent 设置名应用）
+    std::vector<std::pair<std::string, std::string>> extra_settings;
+
+    // 默认值与 wan 配置相同
+    SessionProfile();
+
+    // 生成 settings_pack（不包含 alert_mask，由各类自行设置）
+    lt::settings_pack to_settings() const;
+
+    // 生成 IP 过滤器：allowed_networks 以外的地址全部屏蔽
+    // 返回: 是否有效（网段格式错误时返回 false，filter 不变）
+    bool build_ip_filter(lt::ip_filter& filter) const;
+
+    // 打印配置摘要
+    void print() const;
+
+    // 获取内置配置（wan / lan / low-memory）
+    // 返回: 名称是否存在
+    static bool builtin(const std::string& name, SessionProfile& profile);
+
+    // 内置配置名称
+    static std::vector<std::string> builtin_names();
+
+    // 从配置文件加载（INI 格式：[名称] 开始一个配置，键 = 值，# 开头为注释，base = 内置配置名 表示继承）
+    // 返回: 是否成功（文件不存在或有格式错误时返回 false）
+    static bool load_file(const std::string& path, std::vector<SessionProfile>& profiles);
+
+    // 按描述解析配置：内置名称、配置文件路径（使用第一个配置）或 配置文件路径:名称
+    static bool resolve(const std::string& spec, SessionProfile& profile);
+
+    // 进程默认配置（创建 session 前设置；未设置时为 wan）
+    static void set_default(const SessionProfile& profile);
+    static SessionProfile get_default();
+};
+
+#endif // SESSION_PROFILE_HPP
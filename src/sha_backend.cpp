@@ -0,0 +1,630 @@
+#include "sha_backend.hpp"
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SHA_BACKEND_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC 无需为内建函数指定目标指令集，GCC/Clang 需要按函数启用
+#if defined(SHA_BACKEND_X86) && !defined(_MSC_VER)
+#define TARGET_SHANI __attribute__((target("sha,sse4.1,ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SHANI
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+const std::uint32_t sha1_init[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+const std::uint32_t sha256_init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+alignas(16) const std::uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline std::uint32_t load_be32(const unsigned char* p)
+{
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+           (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+}
+
+inline void store_be32(unsigned char* p, std::uint32_t v)
+{
+    p[0] = static_cast<unsigned char>(v >> 24);
+    p[1] = static_cast<unsigned char>(v >> 16);
+    p[2] = static_cast<unsigned char>(v >> 8);
+    p[3] = static_cast<unsigned char>(v);
+}
+
+inline std::uint32_t rol(std::uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+inline std::uint32_t ror(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+// 构造消息尾部填充块（1 或 2 个 64 字节块），返回块数
+int build_tail(const unsigned char* data, size_t len, unsigned char tail[128])
+{
+    size_t rem = len % 64;
+    std::memset(tail, 0, 128);
+    std::memcpy(tail, data + (len - rem), rem);
+    tail[rem] = 0x80;
+    int blocks = (rem + 9 <= 64) ? 1 : 2;
+    std::uint64_t bits = static_cast<std::uint64_t>(len) * 8;
+    unsigned char* end = tail + blocks * 64;
+    for (int i = 0; i < 8; ++i) {
+        end[-1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    return blocks;
+}
+
+// ---------------------------------------------------------------------------
+// 标量实现
+// ---------------------------------------------------------------------------
+
+void sha1_blocks_scalar(std::uint32_t state[5], const unsigned char* data, size_t blocks)
+{
+    std::uint32_t w[80];
+    for (; blocks > 0; --blocks, data += 64) {
+        for (int t = 0; t < 16; ++t) w[t] = load_be32(data + 4 * t);
+        for (int t = 16; t < 80; ++t) w[t] = rol(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; ++t) {
+            std::uint32_t f, k;
+            if (t < 20)      { f = d ^ (b & (c ^ d));       k = 0x5A827999; }
+            else if (t < 40) { f = b ^ c ^ d;               k = 0x6ED9EBA1; }
+            else if (t < 60) { f = (b & c) | (d & (b | c)); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;               k = 0xCA62C1D6; }
+            std::uint32_t temp = rol(a, 5) + f + e + k + w[t];
+            e = d; d = c; c = rol(b, 30); b = a; a = temp;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+    }
+}
+
+void sha256_blocks_scalar(std::uint32_t state[8], const unsigned char* data, size_t blocks)
+{
+    std::uint32_t w[64];
+    for (; blocks > 0; --blocks, data += 64) {
+        for (int t = 0; t < 16; ++t) w[t] = load_be32(data + 4 * t);
+        for (int t = 16; t < 64; ++t) {
+            std::uint32_t s0 = ror(w[t - 15], 7) ^ ror(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            std::uint32_t s1 = ror(w[t - 2], 17) ^ ror(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            std::uint32_t s1 = ror(e, 6) ^ ror(e, 11) ^ ror(e, 25);
+            std::uint32_t ch = (e & f) ^ (~e & g);
+            std::uint32_t t1 = h + s1 + ch + sha256_k[t] + w[t];
+            std::uint32_t s0 = ror(a, 2) ^ ror(a, 13) ^ ror(a, 22);
+            std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            std::uint32_t t2 = s0 + maj;
+            h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef SHA_BACKEND_X86
+
+// ---------------------------------------------------------------------------
+// SHA-NI 实现（每 4 轮一步，按步号展开）
+// ---------------------------------------------------------------------------
+
+template <int K>
+TARGET_SHANI inline void sha1_ni_step(__m128i& abcd, __m128i (&e)[2], __m128i (&msg)[4])
+{
+    const int cur = K % 2;
+    if (K == 0) {
+        e[cur] = _mm_add_epi32(e[cur], msg[0]);
+    } else {
+        e[cur] = _mm_sha1nexte_epu32(e[cur], msg[K % 4]);
+    }
+    e[1 - cur] = abcd;
+    if (K >= 3) msg[(K + 1) % 4] = _mm_sha1msg2_epu32(msg[(K + 1) % 4], msg[K % 4]);
+    abcd = _mm_sha1rnds4_epu32(abcd, e[cur], K / 5);
+    if (K >= 1) msg[(K + 3) % 4] = _mm_sha1msg1_epu32(msg[(K + 3) % 4], msg[K % 4]);
+    if (K >= 2) msg[(K + 2) % 4] = _mm_xor_si128(msg[(K + 2) % 4], msg[K % 4]);
+}
+
+template <int... Ks>
+TARGET_SHANI inline void sha1_ni_steps(__m128i& abcd, __m128i (&e)[2], __m128i (&msg)[4])
+{
+    (sha1_ni_step<Ks>(abcd, e, msg), ...);
+}
+
+TARGET_SHANI void sha1_blocks_shani(std::uint32_t state[5], const unsigned char* data, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abcd_save = abcd;
+        const __m128i e_save = e0;
+        __m128i e[2] = { e0, _mm_setzero_si128() };
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), mask);
+        }
+
+        sha1_ni_steps<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19>(abcd, e, msg);
+
+        // 第 19 步之后 e[0] 保存的是下一轮的 E 输入
+        e0 = _mm_sha1nexte_epu32(e[0], e_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    abcd = _mm_shuffle_epi32(abcd, 0x1B);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+    state[4] = static_cast<std::uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+template <int K>
+TARGET_SHANI inline void sha256_ni_step(__m128i& state0, __m128i& state1, __m128i (&msg)[4])
+{
+    __m128i m = _mm_add_epi32(msg[K % 4], _mm_load_si128(reinterpret_cast<const __m128i*>(sha256_k + 4 * K)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+    if (K >= 3) {
+        __m128i tmp = _mm_alignr_epi8(msg[K % 4], msg[(K + 3) % 4], 4);
+        msg[(K + 1) % 4] = _mm_add_epi32(msg[(K + 1) % 4], tmp);
+        msg[(K + 1) % 4] = _mm_sha256msg2_epu32(msg[(K + 1) % 4], msg[K % 4]);
+    }
+    m = _mm_shuffle_epi32(m, 0x0E);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+    if (K >= 1) msg[(K + 3) % 4] = _mm_sha256msg1_epu32(msg[(K + 3) % 4], msg[K % 4]);
+}
+
+template <int... Ks>
+TARGET_SHANI inline void sha256_ni_steps(__m128i& state0, __m128i& state1, __m128i (&msg)[4])
+{
+    (sha256_ni_step<Ks>(state0, state1, msg), ...);
+}
+
+TARGET_SHANI void sha256_blocks_shani(std::uint32_t state[8], const unsigned char* data, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abef_save = state0;
+        const __m128i cdgh_save = state1;
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), mask);
+        }
+
+        sha256_ni_steps<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15>(state0, state1, msg);
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 多缓冲实现（8 路，每个 32 位通道对应一个缓冲区）
+// ---------------------------------------------------------------------------
+
+TARGET_AVX2 inline __m256i rol8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+TARGET_AVX2 inline __m256i ror8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// 从 8 个缓冲区各读取 8 个大端 32 位字，转置后 w[i] 的第 j 个通道为缓冲区 j 的第 i 个字
+TARGET_AVX2 inline void load_transpose8(const unsigned char* const p[8], size_t offset, __m256i w[8])
+{
+    const __m256i bswap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i r[8];
+    for (int i = 0; i < 8; ++i) {
+        r[i] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p[i] + offset)), bswap);
+    }
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    w[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    w[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    w[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    w[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    w[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    w[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    w[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    w[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// state[i] 的第 j 个通道为缓冲区 j 的第 i 个状态字
+TARGET_AVX2 void sha1_blocks_avx2(__m256i state[5], const unsigned char* const p[8], size_t blocks)
+{
+    const __m256i k0 = _mm256_set1_epi32(0x5A827999);
+    const __m256i k1 = _mm256_set1_epi32(0x6ED9EBA1);
+    const __m256i k2 = _mm256_set1_epi32(static_cast<int>(0x8F1BBCDC));
+    const __m256i k3 = _mm256_set1_epi32(static_cast<int>(0xCA62C1D6));
+
+    for (size_t blk = 0; blk < blocks; ++blk) {
+        __m256i w[16];
+        load_transpose8(p, blk * 64, w);
+        load_transpose8(p, blk * 64 + 32, w + 8);
+
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; ++t) {
+            __m256i wt;
+            if (t < 16) {
+                wt = w[t];
+            } else {
+                wt = _mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                                      _mm256_xor_si256(w[(t - 14) & 15], w[t & 15]));
+                wt = rol8(wt, 1);
+                w[t & 15] = wt;
+            }
+            __m256i f, k;
+            if (t < 20) {
+                f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+                k = k0;
+            } else if (t < 40) {
+                f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+                k = k1;
+            } else if (t < 60) {
+                f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+                k = k2;
+            } else {
+                f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+                k = k3;
+            }
+            __m256i temp = _mm256_add_epi32(_mm256_add_epi32(rol8(a, 5), f),
+                                            _mm256_add_epi32(_mm256_add_epi32(e, k), wt));
+            e = d; d = c; c = rol8(b, 30); b = a; a = temp;
+        }
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+    }
+}
+
+TARGET_AVX2 void sha256_blocks_avx2(__m256i state[8], const unsigned char* const p[8], size_t blocks)
+{
+    for (size_t blk = 0; blk < blocks; ++blk) {
+        __m256i w[16];
+        load_transpose8(p, blk * 64, w);
+        load_transpose8(p, blk * 64 + 32, w + 8);
+
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            __m256i wt;
+            if (t < 16) {
+                wt = w[t];
+            } else {
+                __m256i w15 = w[(t - 15) & 15];
+                __m256i w2 = w[(t - 2) & 15];
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ror8(w15, 7), ror8(w15, 18)), _mm256_srli_epi32(w15, 3));
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ror8(w2, 17), ror8(w2, 19)), _mm256_srli_epi32(w2, 10));
+                wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+                w[t & 15] = wt;
+            }
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ror8(e, 6), ror8(e, 11)), ror8(e, 25));
+            __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+                                          _mm256_add_epi32(_mm256_add_epi32(ch, wt),
+                                                           _mm256_set1_epi32(static_cast<int>(sha256_k[t]))));
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ror8(a, 2), ror8(a, 13)), ror8(a, 22));
+            __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            __m256i t2 = _mm256_add_epi32(s0, maj);
+            h = g; g = f; f = e; e = _mm256_add_epi32(d, t1); d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+        }
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+        state[5] = _mm256_add_epi32(state[5], f);
+        state[6] = _mm256_add_epi32(state[6], g);
+        state[7] = _mm256_add_epi32(state[7], h);
+    }
+}
+
+// 8 路等长缓冲区哈希：Words 为状态字数（SHA1 为 5，SHA256 为 8）
+template <int Words, typename Blocks>
+TARGET_AVX2 void hash_multi_avx2(const char* const* data, size_t len, int count,
+                                 const std::uint32_t (&init)[Words], Blocks blocks_fn,
+                                 unsigned char* out, size_t out_stride)
+{
+    for (int base = 0; base < count; base += 8) {
+        const int lanes = std::min(8, count - base);
+
+        // 不足 8 路时用第一个缓冲区补齐，结果丢弃
+        const unsigned char* p[8];
+        for (int i = 0; i < 8; ++i) {
+            p[i] = reinterpret_cast<const unsigned char*>(data[base + (i < lanes ? i : 0)]);
+        }
+
+        __m256i state[Words];
+        for (int i = 0; i < Words; ++i) {
+            state[i] = _mm256_set1_epi32(static_cast<int>(init[i]));
+        }
+
+        blocks_fn(state, p, len / 64);
+
+        alignas(32) unsigned char tails[8][128];
+        const unsigned char* tail_ptrs[8];
+        int tail_blocks = 1;
+        for (int i = 0; i < 8; ++i) {
+            tail_blocks = build_tail(p[i], len, tails[i]);
+            tail_ptrs[i] = tails[i];
+        }
+        blocks_fn(state, tail_ptrs, static_cast<size_t>(tail_blocks));
+
+        alignas(32) std::uint32_t words[Words][8];
+        for (int i = 0; i < Words; ++i) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+        }
+        for (int lane = 0; lane < lanes; ++lane) {
+            unsigned char* digest = out + (base + lane) * out_stride;
+            for (int i = 0; i < Words; ++i) {
+                store_be32(digest + 4 * i, words[i][lane]);
+            }
+        }
+    }
+}
+
+// 检测 CPU 特性
+struct CpuFeatures {
+    bool sha = false;
+    bool sse41 = false;
+    bool ssse3 = false;
+    bool avx2 = false;
+};
+
+void cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+CpuFeatures detect_cpu_features()
+{
+    CpuFeatures features;
+    unsigned int regs[4] = {0, 0, 0, 0};
+    cpuid(0, 0, regs);
+    const unsigned int max_leaf = regs[0];
+    if (max_leaf < 1) return features;
+
+    cpuid(1, 0, regs);
+    features.ssse3 = (regs[2] & (1u << 9)) != 0;
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+
+    // AVX2 还需要操作系统保存 YMM 寄存器状态
+    bool ymm_enabled = false;
+    if (osxsave && avx) {
+#ifdef _MSC_VER
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned int eax = 0, edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+        ymm_enabled = (xcr0 & 0x6) == 0x6;
+    }
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = ymm_enabled && (regs[1] & (1u << 5)) != 0;
+        features.sha = (regs[1] & (1u << 29)) != 0;
+    }
+    return features;
+}
+
+const CpuFeatures& cpu_features()
+{
+    static const CpuFeatures features = detect_cpu_features();
+    return features;
+}
+
+#endif // SHA_BACKEND_X86
+
+// 单缓冲区哈希：整块直接处理，尾部补齐后再处理
+template <int Words, typename Blocks>
+void hash_single(const char* data, size_t len, const std::uint32_t (&init)[Words],
+                 Blocks blocks_fn, unsigned char* out)
+{
+    std::uint32_t state[Words];
+    std::memcpy(state, init, sizeof(state));
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    blocks_fn(state, p, len / 64);
+
+    unsigned char tail[128];
+    int tail_blocks = build_tail(p, len, tail);
+    blocks_fn(state, tail, static_cast<size_t>(tail_blocks));
+
+    for (int i = 0; i < Words; ++i) {
+        store_be32(out + 4 * i, state[i]);
+    }
+}
+
+std::atomic<int> active_backend(-1);
+
+} // namespace
+
+ShaBackend::Type ShaBackend::detect()
+{
+#ifdef SHA_BACKEND_X86
+    const CpuFeatures& features = cpu_features();
+    if (features.sha && features.sse41 && features.ssse3) {
+        return Type::ShaNi;
+    }
+    if (features.avx2) {
+        return Type::Avx2MultiBuffer;
+    }
+#endif
+    return Type::Scalar;
+}
+
+ShaBackend::Type ShaBackend::active()
+{
+    int type = active_backend.load(std::memory_order_relaxed);
+    if (type < 0) {
+        type = static_cast<int>(detect());
+        active_backend.store(type, std::memory_order_relaxed);
+    }
+    return static_cast<Type>(type);
+}
+
+bool ShaBackend::is_supported(Type type)
+{
+    switch (type) {
+        case Type::Scalar:
+            return true;
+#ifdef SHA_BACKEND_X86
+        case Type::Avx2MultiBuffer:
+            return cpu_features().avx2;
+        case Type::ShaNi:
+            return cpu_features().sha && cpu_features().sse41 && cpu_features().ssse3;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool ShaBackend::set_active(Type type)
+{
+    if (!is_supported(type)) {
+        return false;
+    }
+    active_backend.store(static_cast<int>(type), std::memory_order_relaxed);
+    return true;
+}
+
+const char* ShaBackend::name(Type type)
+{
+    switch (type) {
+        case Type::ShaNi:
+            return "SHA-NI";
+        case Type::Avx2MultiBuffer:
+            return "AVX2 多缓冲";
+        default:
+            return "标量";
+    }
+}
+
+int ShaBackend::preferred_batch()
+{
+    return active() == Type::Avx2MultiBuffer ? 8 : 1;
+}
+
+lt::sha1_hash ShaBackend::sha1(const char* data, size_t len)
+{
+    lt::sha1_hash result;
+    unsigned char* out = reinterpret_cast<unsigned char*>(result.data());
+#ifdef SHA_BACKEND_X86
+    if (active() == Type::ShaNi) {
+        hash_single<5>(data, len, sha1_init, sha1_blocks_shani, out);
+        return result;
+    }
+#endif
+    hash_single<5>(data, len, sha1_init, sha1_blocks_scalar, out);
+    return result;
+}
+
+lt::sha256_hash ShaBackend::sha256(const char* data, size_t len)
+{
+    lt::sha256_hash result;
+    unsigned char* out = reinterpret_cast<unsigned char*>(result.data());
+#ifdef SHA_BACKEND_X86
+    if (active() == Type::ShaNi) {
+        hash_single<8>(data, len, sha256_init, sha256_blocks_shani, out);
+        return result;
+    }
+#endif
+    hash_single<8>(data, len, sha256_init, sha256_blocks_scalar, out);
+    return result;
+}
+
+void ShaBackend::sha1_multi(const char* const* data, size_t len, int count, lt::sha1_hash* out)
+{
+#ifdef SHA_BACKEND_X86
+    if (active() == Type::Avx2MultiBuffer && count > 1) {
+        unsigned char* base = reinterpret_cast<unsigned char*>(out[0].data());
+        hash_multi_avx2<5>(data, len, count, sha1_init, sha1_blocks_avx2, base, sizeof(lt::sha1_hash));
+        return;
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+        out[i] = sha1(data[i], len);
+    }
+}
+
+void ShaBackend::sha256_multi(const char* const* data, size_t len, int count, lt::sha256_hash* out)
+{
+#ifdef SHA_BACKEND_X86
+    if (active() == Type::Avx2MultiBuffer && count > 1) {
+        unsigned char* base = reinterpret_cast<unsigned char*>(out[0].data());
+        hash_multi_avx2<8>(data, len, count, sha256_init, sha256_blocks_avx2, base, sizeof(lt::sha256_hash));
+        return;
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+        out[i] = sha256(data[i], len);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef SHA_BACKEND_HPP
+#define SHA_BACKEND_HPP
+
+#include <cstddef>
+#include <libtorrent/sha1_hash.hpp>
+
+// SHA 哈希后端
+// 运行时检测 CPU 指令集，自动选择 SHA-NI、AVX2 多缓冲或标量实现
+class ShaBackend
+{
+public:
+    // 后端类型
+    enum class Type {
+        Scalar,           // 标量实现（所有 CPU 可用）
+        Avx2MultiBuffer,  // AVX2 多缓冲（每核同时计算 8 个缓冲区）
+        ShaNi             // Intel/AMD SHA 扩展指令
+    };
+
+    // 检测当前 CPU 支持的最快后端
+    static Type detect();
+
+    // 获取当前使用的后端（首次调用时自动检测）
+    static Type active();
+
+    // 强制使用指定后端，CPU 不支持时返回 false 并保持原后端
+    static bool set_active(Type type);
+
+    // 检查 CPU 是否支持指定后端
+    static bool is_supported(Type type);
+
+    // 获取后端名称
+    static const char* name(Type type);
+
+    // 每次调用 *_multi 时建议的缓冲区数量（多缓冲后端为 8，其他为 1）
+    static int preferred_batch();
+
+    // 计算单个缓冲区的 SHA1 / SHA256
+    static lt::sha1_hash sha1(const char* data, size_t len);
+    static lt::sha256_hash sha256(const char* data, size_t len);
+
+    // 同时计算多个等长缓冲区的 SHA1 / SHA256
+    // data: count 个缓冲区指针，每个长度均为 len；结果写入 out[0..count)
+    static void sha1_multi(const char* const* data, size_t len, int count, lt::sha1_hash* out);
+    static void sha256_multi(const char* const* data, size_t len, int count, lt::sha256_hash* out);
+};
+
+#endif // SHA_BACKEND_HPP
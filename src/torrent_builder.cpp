@@ -1,4 +1,10 @@
 #include "torrent_builder.hpp"
+#include "piece_hasher.hpp"
+#include "piece_hash_cache.hpp"
+#include "seed_resume.hpp"
+#include "bencode_writer.hpp"
+#include "zero_pieces.hpp"
+#include "torrent_policy.hpp"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -6,6 +12,7 @@
 #include <algorithm>
 #include <vector>
 #include <cstdio>
+#include <ctime>
 #ifdef _WIN32
 #include <windows.h>
 #include <io.h>
@@ -136,9 +143,29 @@ static std::string format_exception_message(const std::exception& e)
 TorrentBuilder::TorrentBuilder()
     : creator_("DisklessWorkstation")
     , piece_size_(0)  // 0 表示使用默认大小
+    , hash_threads_(0)  // 0 表示使用 CPU 核心数
+    , read_ahead_(4)
+    , direct_io_(false)
+    , use_hash_cache_(true)
+    , version_(TorrentVersion::V1)
+    , write_resume_(false)
+    , scan_threads_(0)
+    , sparse_aware_(true)
+    , pad_boot_files_(false)
+    , last_total_size_(0)
+    , checkpoint_interval_(60)
+    , checkpoint_pieces_(0)
+    , quiet_(false)
 {
 }
 
+std::ostream& TorrentBuilder::log() const
+{
+    // 每个线程一个丢弃输出的流：安静模式下多个生成任务同时写入时不共享流状态
+    thread_local std::ostream discard(nullptr);
+    return quiet_ ? discard : std::cout;
+}
+
 bool TorrentBuilder::create_torrent(const std::string& file_path, const std::string& output_path)
 {
     try {
@@ -152,32 +179,27 @@ bool TorrentBuilder::create_torrent(const std::string& file_path, const std::str
         lt::file_storage fs_storage;
         
         // 添加文件到存储
-        add_files_to_storage(fs_storage, file_path);
+        if (!add_files_to_storage(fs_storage, file_path)) return false;
+        last_total_size_ = fs_storage.total_size();
 
-        // 计算总文件大小，为大文件设置合适的分片大小
-        std::int64_t total_size = fs_storage.total_size();
-        if (total_size > 0) {
-            // 对于大文件（>4GB），使用16MB的分片大小
-            // 对于超大文件（>50GB），使用16MB分片大小以确保性能
-            if (total_size > 4LL * 1024 * 1024 * 1024) {  // 4GB
-                int recommended_piece_size = 16 * 1024 * 1024;  // 16MB
-                if (piece_size_ == 0 || piece_size_ < recommended_piece_size) {
-                    fs_storage.set_piece_length(recommended_piece_size);
-                    std::cout << "检测到大文件（总大小: " 
-                              << (total_size / 1024.0 / 1024.0 / 1024.0) 
-                              << " GB），已设置分片大小为 16MB" << std::endl;
-                }
-            } else if (piece_size_ > 0) {
-                // 如果用户指定了分片大小，使用用户指定的值
-                fs_storage.set_piece_length(piece_size_);
-            }
+        // v2 要求分片大小为不小于 16KiB 的 2 的幂
+        if (version_ != TorrentVersion::V1 && piece_size_ > 0 &&
+            (piece_size_ < 16 * 1024 || (piece_size_ & (piece_size_ - 1)) != 0)) {
+            std::cerr << "错误: v2/混合 torrent 的分片大小必须是不小于 16KB 的 2 的幂: " << piece_size_ << std::endl;
+            return false;
         }
-
-        // 创建 torrent 对象
-        lt::create_torrent torrent(fs_storage);
         
-        // 注意：分片大小在创建 create_torrent 时自动计算，通常不需要手动设置
-        // 如果需要自定义分片大小，可以在创建 fs_storage 后、创建 torrent 前设置
+        // 创建 torrent 对象
+        // v2/混合模式下 libtorrent 会规范化文件顺序并插入 pad 文件，使每个文件从分片边界开始
+        lt::create_torrent::create_flags_t create_flags = {};
+        if (version_ == TorrentVersion::V1) {
+            create_flags = lt::create_torrent::v1_only;
+        } else if (version_ == TorrentVersion::V2) {
+            create_flags = lt::create_torrent::v2_only;
+        }
+        // 使用 add_files_to_storage 中选定的分片大小（为 0 时由 libtorrent 自动选择）
+        lt::create_torrent torrent(fs_storage, fs_storage.piece_length(), create_flags);
+        log() << "协议版本: " << (version_ == TorrentVersion::V1 ? "v1" : version_ == TorrentVersion::V2 ? "v2" : "混合 (v1 + v2)") << std::endl;
         
         // 添加 tracker
         for (const auto& tracker : trackers_) {
@@ -195,22 +217,22 @@ bool TorrentBuilder::create_torrent(const std::string& file_path, const std::str
         }
         
         // 计算哈希值
-        std::cout << "正在计算文件哈希值..." << std::endl;
-        std::cout << "文件数量: " << fs_storage.num_files() << std::endl;
-        std::cout << "总大小: " << format_bytes(fs_storage.total_size()) << std::endl;
-        std::cout << "分片大小: " << format_bytes(fs_storage.piece_length()) << std::endl;
-        std::cout << "分片数量: " << fs_storage.num_pieces() << std::endl;
+        log() << "正在计算文件哈希值..." << std::endl;
+        log() << "文件数量: " << fs_storage.num_files() << std::endl;
+        log() << "总大小: " << format_bytes(fs_storage.total_size()) << std::endl;
+        log() << "分片大小: " << format_bytes(fs_storage.piece_length()) << std::endl;
+        log() << "分片数量: " << fs_storage.num_pieces() << std::endl;
         
         // 显示前几个文件的路径，用于调试和确定正确的根路径
         namespace fs = std::filesystem;
         std::string actual_root_path = root_path;
         
         if (fs_storage.num_files() > 0) {
-            std::cout << "前几个文件在 storage 中的路径（用于调试）:" << std::endl;
+            log() << "前几个文件在 storage 中的路径（用于调试）:" << std::endl;
             for (int i = 0; i < std::min(5, static_cast<int>(fs_storage.num_files())); ++i) {
                 lt::file_index_t idx(i);
                 std::string file_path_in_storage = fs_storage.file_path(idx);
-                std::cout << "  [" << i << "] " << file_path_in_storage << std::endl;
+                log() << "  [" << i << "] " << file_path_in_storage << std::endl;
                 
                 // 根据 storage 中的文件路径来确定正确的根路径
                 // 如果路径以目录名开头（如 "Data/file.txt"），说明 root_path 应该是父目录
@@ -234,16 +256,16 @@ bool TorrentBuilder::create_torrent(const std::string& file_path, const std::str
                         if (fs::is_directory(input_path_obj)) {
                             actual_root_path = input_path_obj.string();
                             std::replace(actual_root_path.begin(), actual_root_path.end(), '\\', '/');
-                            std::cout << "  注意：根据 storage 路径，将根路径调整为: " << actual_root_path << std::endl;
+                            log() << "  注意：根据 storage 路径，将根路径调整为: " << actual_root_path << std::endl;
                         }
                     }
                 }
             }
         }
         
-        std::cout << "使用的根路径: " << actual_root_path << std::endl;
-        std::cout << "这可能需要一些时间，请稍候..." << std::endl;
-        std::cout << std::endl;
+        log() << "使用的根路径: " << actual_root_path << std::endl;
+        log() << "这可能需要一些时间，请稍候..." << std::endl;
+        log() << std::endl;
         
         // 验证根路径存在且可访问
         // 将正斜杠路径转换回 Windows 格式进行验证
@@ -282,59 +304,41 @@ bool TorrentBuilder::create_torrent(const std::string& file_path, const std::str
         // 更新 root_path 为实际使用的路径
         root_path = actual_root_path;
         
+        // 在计算哈希之前记录文件状态，供快速恢复数据使用
+        SeedResume seed_resume;
+        if (write_resume_) {
+            seed_resume.record_files(torrent.files(), root_path, &scanned_mtimes_);
+        }
+        
         try {
             // 错误 995 (ERROR_OPERATION_ABORTED) 通常表示 I/O 操作被中断
             // 可能原因：
-            // 1. 路径不匹配：set_piece_hashes 的 root_path 与 add_files 时使用的路径不一致
+            // 1. 路径不匹配：哈希计算的 root_path 与 add_files 时使用的路径不一致
             // 2. 文件句柄问题：同时打开太多文件或文件被锁定
-            // 3. 异步 I/O 问题：libtorrent 内部的 I/O 操作被中断
-            // 4. 资源限制：虽然内存足够，但可能有其他资源限制
+            // 3. 资源限制：虽然内存足够，但可能有其他资源限制
+            // 哈希引擎的读取线程会对单次读取失败进行有限次重试
             
             // 使用根据 storage 路径确定的根路径
             std::string libtorrent_path = root_path;
             std::replace(libtorrent_path.begin(), libtorrent_path.end(), '\\', '/');
             
             // 对于大文件，输出进度提示
-            std::cout << "开始计算哈希值..." << std::endl;
-            std::cout << "使用根路径: " << libtorrent_path << std::endl;
-            const std::int64_t very_large_threshold = 50LL * 1024 * 1024 * 1024; // 50GB
-            if (fs_storage.total_size() > very_large_threshold) {
-                std::cout << "注意：对于 50GB+ 的大文件，这可能需要几分钟到十几分钟，请耐心等待..." << std::endl;
+            log() << "开始计算哈希值..." << std::endl;
+            log() << "使用根路径: " << libtorrent_path << std::endl;
+            // 按分类策略判断是否为大镜像（与下载/做种端使用同一套阈值）
+            const TorrentPolicy policy = TorrentPolicy::get_default();
+            if (policy.classify(fs_storage.total_size(), fs_storage.num_pieces(), fs_storage.num_files()).name == "large") {
+                log() << "注意：大镜像的哈希计算可能需要几分钟到十几分钟，请耐心等待..." << std::endl;
             }
-            std::cout << "正在处理中，请勿中断程序..." << std::flush;
             
-            // 使用 set_piece_hashes 计算哈希值
-            // 这个函数会读取所有文件并计算每个分片的 SHA1 哈希
-            // 在 Windows 上，错误 995 可能是由于路径不匹配、文件句柄限制或其他资源问题
-#ifdef _WIN32
-            const int max_retries = 3;
-            int attempt = 0;
-            while (true) {
-                ++attempt;
-                lt::error_code ec;
-                lt::set_piece_hashes(torrent, libtorrent_path.c_str(), ec);
-                
-                if (!ec) {
-                    break;
-                }
-                
-                // 特殊处理 Windows 错误 995：I/O 操作被中止
-                if (ec.category() == lt::system_category() && ec.value() == 995 && attempt < max_retries) {
-                    std::cerr << std::endl;
-                    std::cerr << "警告: 计算文件哈希值时 I/O 操作被中止 (错误代码: 995)，正在进行第 "
-                              << attempt << " 次重试..." << std::endl;
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                    continue;
-                }
-                
-                // 其他错误或重试仍失败，抛出系统错误由外层处理
-                throw std::system_error(ec);
-            }
-#else
-            lt::set_piece_hashes(torrent, libtorrent_path.c_str());
-#endif
+            // 使用多线程哈希引擎计算所有分片的 SHA1 哈希
+            // 每个线程负责一段连续的分片区间，读取和计算并行进行，不再受单核 SHA1 速度限制
+            // 未变化的分片直接复用哈希缓存，全部复用时沿用上次的创建时间，使输出文件完全一致
+            std::time_t creation_date = std::time(nullptr);
+            compute_piece_hashes(torrent, torrent.files(), libtorrent_path, output_path, creation_date);
+            torrent.set_creation_date(creation_date);
             
-            std::cout << "\r文件哈希值计算完成！                              " << std::endl;
+            log() << "文件哈希值计算完成！" << std::endl;
         } catch (const std::system_error& e) {
             std::cerr << "计算文件哈希值时发生系统错误: " << format_exception_message(e) << std::endl;
             std::cerr << std::endl;
@@ -347,6 +351,10 @@ bool TorrentBuilder::create_torrent(const std::string& file_path, const std::str
             throw;
         } catch (const std::exception& e) {
             std::cerr << "计算文件哈希值时出错: " << format_exception_message(e) << std::endl;
+            if (checkpoint_pieces_ > 0) {
+                std::cerr << "已完成的 " << checkpoint_pieces_ << " 个分片已保存到哈希检查点，"
+                          << "排除问题后重新运行将从检查点继续（源文件有变化的分片会重新计算）" << std::endl;
+            }
             std::cerr << std::endl;
             std::cerr << "提示: 对于大文件（>50GB），请确保:" << std::endl;
             std::cerr << "  - 有足够的磁盘空间（建议至少是文件大小的 10%）" << std::endl;
@@ -358,33 +366,49 @@ bool TorrentBuilder::create_torrent(const std::string& file_path, const std::str
         // 生成 torrent 字典
         lt::entry torrent_entry = torrent.generate();
         
-        // 提取信息哈希
-        lt::sha1_hash info_hash_v1 = extract_info_hash(torrent_entry);
+        // 记录全零分片表（位于 info 字典之外，不影响 info hash）
+        int zero_count = ZeroPieceMap::write(torrent_entry, zero_pieces_);
+        if (zero_count > 0) {
+            log() << "全零分片: " << zero_count << " / " << fs_storage.num_pieces()
+                  << "（已写入全零分片表，下载端可直接保留为稀疏空洞）" << std::endl;
+        }
         
-        // 写入文件
-        if (!write_torrent_file(torrent_entry, output_path)) {
+        // 写入文件（单次流式编码，同时计算信息哈希）
+        lt::info_hash_t info_hashes;
+        if (!write_torrent_file(torrent_entry, output_path, info_hashes)) {
             return false;
         }
         
         // 显示结果信息
-        std::cout << "成功生成 torrent 文件: " << output_path << std::endl;
-        if (!info_hash_v1.is_all_zeros()) {
-            std::cout << "Info Hash v1: " << info_hash_v1 << std::endl;
+        log() << "成功生成 torrent 文件: " << output_path << std::endl;
+        if (info_hashes.has_v1()) {
+            log() << "Info Hash v1: " << info_hashes.v1 << std::endl;
+        }
+        if (info_hashes.has_v2()) {
+            log() << "Info Hash v2: " << info_hashes.v2 << std::endl;
+        }
+        
+        // 所有分片刚刚从磁盘计算过哈希，写入快速恢复数据，做种时无需再次读取全部数据
+        if (write_resume_) {
+            std::string resume_path = SeedResume::path_for(output_path);
+            if (seed_resume.save(resume_path, info_hashes, root_path, torrent.files().num_pieces())) {
+                log() << "快速恢复数据已保存: " << resume_path << std::endl;
+            }
         }
         
         // 显示 tracker 信息
         if (!trackers_.empty()) {
-            std::cout << "已添加 " << trackers_.size() << " 个 Tracker:" << std::endl;
+            log() << "已添加 " << trackers_.size() << " 个 Tracker:" << std::endl;
             for (size_t i = 0; i < trackers_.size(); ++i) {
-                std::cout << "  [" << (i + 1) << "] " << trackers_[i] << std::endl;
+                log() << "  [" << (i + 1) << "] " << trackers_[i] << std::endl;
             }
-            std::cout << std::endl;
-            std::cout << "提示: Tracker URL 已写入 torrent 文件。" << std::endl;
-            std::cout << "      使用 BitTorrent 客户端打开 torrent 文件并开始做种后，" << std::endl;
-            std::cout << "      客户端会自动向这些 Tracker 报告，Tracker 会记录你的做种信息。" << std::endl;
+            log() << std::endl;
+            log() << "提示: Tracker URL 已写入 torrent 文件。" << std::endl;
+            log() << "      使用 BitTorrent 客户端打开 torrent 文件并开始做种后，" << std::endl;
+            log() << "      客户端会自动向这些 Tracker 报告，Tracker 会记录你的做种信息。" << std::endl;
         } else {
-            std::cout << "警告: 未添加任何 Tracker。" << std::endl;
-            std::cout << "      建议添加 Tracker URL 以便其他用户能够发现你的做种。" << std::endl;
+            log() << "警告: 未添加任何 Tracker。" << std::endl;
+            log() << "      建议添加 Tracker URL 以便其他用户能够发现你的做种。" << std::endl;
         }
         
         return true;
@@ -408,21 +432,7 @@ bool TorrentBuilder::validate_path(const std::string& file_path)
         return false;
     }
     
-    // 检查是否为空目录
-    if (fs::is_directory(file_path)) {
-        bool has_files = false;
-        for (const auto& entry : fs::recursive_directory_iterator(file_path)) {
-            if (fs::is_regular_file(entry)) {
-                has_files = true;
-                break;
-            }
-        }
-        if (!has_files) {
-            std::cerr << "错误: 目录为空，无法创建 torrent: " << file_path << std::endl;
-            return false;
-        }
-    }
-    
+    // 是否为空目录在扫描时检查，这里不再单独遍历整个目录树
     return true;
 }
 
@@ -479,71 +489,250 @@ std::string TorrentBuilder::determine_root_path(const std::string& file_path)
     return root_path;
 }
 
-void TorrentBuilder::add_files_to_storage(lt::file_storage& fs_storage, const std::string& file_path)
+bool TorrentBuilder::add_files_to_storage(lt::file_storage& fs_storage, const std::string& file_path)
 {
-    namespace fs = std::filesystem;
+    // 一次并行遍历收集所有文件，直接填充 file_storage
+    // 路径格式与 lt::add_files 相同：目录 "D:/A/B" 中的文件 "D:/A/B/file.txt" 在 storage 中为 "B/file.txt"
+    // 文件按路径排序，不依赖文件系统的枚举顺序，相同内容总是得到相同的 info hash
+    DirectoryScanner scanner(file_path);
+    scanner.set_threads(scan_threads_);
+    scanner.set_quiet(quiet_);
+    if (!scanner.scan()) {
+        return false;
+    }
+    if (scanner.files().empty()) {
+        std::cerr << "错误: 目录为空，无法创建 torrent: " << file_path << std::endl;
+        return false;
+    }
     
-    // 规范化路径：移除末尾的反斜杠，转换为标准格式
-    std::string normalized_path = file_path;
-    while (!normalized_path.empty() && (normalized_path.back() == '\\' || normalized_path.back() == '/')) {
-        normalized_path.pop_back();
+    // 按访问顺序排列文件（v2/混合模式下 libtorrent 会按路径重新排序文件，访问顺序无法保留）
+    if (!access_order_file_.empty()) {
+        if (version_ != TorrentVersion::V1) {
+            std::cerr << "警告: v2/混合 torrent 的文件顺序由协议规定，忽略访问顺序文件: " << access_order_file_ << std::endl;
+        } else {
+            std::vector<std::string> access_order;
+            if (!load_access_order(access_order)) {
+                return false;
+            }
+            int matched = scanner.apply_access_order(access_order);
+            log() << "访问顺序: " << access_order.size() << " 条记录，匹配 " << matched
+                  << " 个文件，已排列在 torrent 最前面" << std::endl;
+        }
     }
     
-    // 转换为绝对路径
-    fs::path path_obj(normalized_path);
-    if (!path_obj.is_absolute()) {
-        path_obj = fs::absolute(path_obj);
+    // 在添加文件之前确定分片大小：插入 pad 文件需要知道分片边界
+    int piece_length = choose_piece_length(scanner.total_size(), static_cast<int>(scanner.files().size()));
+    int pad_piece_length = 0;
+    if (pad_boot_files_ && scanner.boot_files() > 0 && version_ == TorrentVersion::V1) {
+        if (piece_length == 0) {
+            // 与 libtorrent 的自动选择规则一致：约 2048 个分片，16KB ~ 4MB 之间的 2 的幂
+            std::int64_t target = scanner.total_size() / 2048;
+            piece_length = 16 * 1024;
+            while (piece_length < 4 * 1024 * 1024 && piece_length < target) {
+                piece_length *= 2;
+            }
+        }
+        pad_piece_length = piece_length;
+    }
+    
+    scanner.add_to_storage(fs_storage, pad_piece_length);
+    if (piece_length > 0) {
+        fs_storage.set_piece_length(piece_length);
+    }
+    if (pad_piece_length > 0) {
+        log() << "已插入 pad 文件，启动数据对齐到 " << (pad_piece_length / 1024) << " KB 分片边界（填充 "
+              << ((fs_storage.total_size() - scanner.total_size()) / 1024.0) << " KB）" << std::endl;
     }
-    normalized_path = path_obj.lexically_normal().string();
-    
-    // 在 Windows 上，libtorrent 期望使用正斜杠路径（根据文档）
-    // 根据 libtorrent 文档，add_files 接受正斜杠路径，即使是在 Windows 上
-    std::replace(normalized_path.begin(), normalized_path.end(), '\\', '/');
-    
-    // 添加文件到存储
-    // 注意：根据 libtorrent 的行为：
-    // - 如果输入是目录 "D:/A/B"，add_files 会在 storage 中创建相对于父目录的路径
-    // - 例如：文件 "D:/A/B/file.txt" 在 storage 中会是 "B/file.txt"
-    // - 但是，在某些版本中，也可能是 "file.txt"（相对于输入目录）
-    // 为了确保兼容性，我们需要确保路径格式正确
-    lt::add_files(fs_storage, normalized_path, [](std::string const&) { return true; });
+    scanned_mtimes_ = scanner.mtimes();
+    return true;
+}
+
+int TorrentBuilder::choose_piece_length(std::int64_t total_size, int num_files) const
+{
+    // 分类策略规定了最小分片大小时（默认超过 4GB 的 torrent 不小于 16MB），使用不小于该值的分片大小以确保性能
+    // 生成前分片数未知，只按总大小和文件数分类
+    const TorrentPolicy policy = TorrentPolicy::get_default();
+    const TorrentClass& torrent_class = policy.classify(total_size, -1, num_files);
+    const int recommended_piece_size = torrent_class.min_build_piece_size;
+    if (recommended_piece_size > 0 && (piece_size_ == 0 || piece_size_ < recommended_piece_size)) {
+        log() << "分类 " << torrent_class.name << "（总大小: " << format_bytes(total_size)
+              << "），已设置分片大小为 " << format_bytes(recommended_piece_size) << std::endl;
+        return recommended_piece_size;
+    }
+    // 如果用户指定了分片大小，使用用户指定的值
+    return piece_size_;
+}
+
+bool TorrentBuilder::load_access_order(std::vector<std::string>& access_order) const
+{
+    namespace fs = std::filesystem;
+    
+    std::ifstream in(fs::u8path(access_order_file_));
+    if (!in.is_open()) {
+        std::cerr << "错误: 无法打开访问顺序文件: " << access_order_file_ << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        // 跟踪记录可能包含时间戳等其他列，路径位于最后一列
+        size_t tab = line.rfind('\t');
+        if (tab != std::string::npos) {
+            line = line.substr(tab + 1);
+        }
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        size_t start = line.find_first_not_of(' ');
+        if (start == std::string::npos || line[start] == '#') continue;
+        access_order.push_back(line.substr(start));
+    }
+    return true;
 }
 
-lt::sha1_hash TorrentBuilder::extract_info_hash(const lt::entry& torrent_entry)
+void TorrentBuilder::compute_piece_hashes(lt::create_torrent& torrent, const lt::file_storage& fs_storage,
+                                          const std::string& root_path, const std::string& output_path,
+                                          std::time_t& creation_date)
 {
-    lt::sha1_hash info_hash_v1;
+    const int num_pieces = fs_storage.num_pieces();
+    const bool need_v1 = version_ != TorrentVersion::V2;
+    const bool need_v2 = version_ != TorrentVersion::V1;
+    std::vector<lt::sha1_hash> piece_hashes;
+    std::vector<lt::sha256_hash> piece_roots;
+    std::vector<lt::piece_index_t> dirty_pieces;
+    PieceHashCache cache(output_path + ".hashcache");
+    
+    if (use_hash_cache_) {
+        // 先记录文件状态再计算哈希：计算期间被修改的文件下次会重新计算
+        bool loaded = cache.load();
+        dirty_pieces = cache.match(fs_storage, root_path, need_v1 ? &piece_hashes : nullptr,
+                                   need_v2 ? &piece_roots : nullptr, &scanned_mtimes_);
+        if (loaded) {
+            log() << "哈希缓存: 复用 " << (num_pieces - static_cast<int>(dirty_pieces.size()))
+                  << " / " << num_pieces << " 个分片，需要重新计算 " << dirty_pieces.size() << " 个分片" << std::endl;
+        } else {
+            log() << "未找到可用的哈希缓存，将计算所有分片: " << cache.path() << std::endl;
+        }
+    } else {
+        for (int p = 0; p < num_pieces; ++p) {
+            dirty_pieces.push_back(lt::piece_index_t(p));
+        }
+    }
+    
+    PieceHasher hasher(fs_storage, root_path);
+    hasher.set_threads(hash_threads_);
+    hasher.set_read_ahead(read_ahead_);
+    hasher.set_unbuffered(direct_io_);
+    hasher.set_v1(need_v1);
+    hasher.set_sparse_aware(sparse_aware_);
+    hasher.set_quiet(quiet_);
+    if (progress_) {
+        hasher.set_progress(progress_);
+    }
+    
+    // 定期将已完成的分片写入哈希缓存作为检查点，失败或中断后重新生成时从中继续
+    checkpoint_pieces_ = 0;
+    if (use_hash_cache_ && checkpoint_interval_ > 0) {
+        std::vector<char> reused(num_pieces, 1);
+        for (lt::piece_index_t piece : dirty_pieces) {
+            reused[static_cast<int>(piece)] = 0;
+        }
+        hasher.set_checkpoint([&, reused](const std::vector<char>& completed) {
+            // 只复制有效分片的哈希，其余分片可能正在被哈希线程写入
+            std::vector<char> valid(num_pieces, 0);
+            std::vector<lt::sha1_hash> hashes_done(need_v1 ? num_pieces : 0);
+            std::vector<lt::sha256_hash> roots_done(need_v2 ? num_pieces : 0);
+            int valid_pieces = 0;
+            for (int p = 0; p < num_pieces; ++p) {
+                if (!reused[p] && !completed[p]) continue;
+                valid[p] = 1;
+                ++valid_pieces;
+                if (need_v1) hashes_done[p] = piece_hashes[p];
+                if (need_v2) roots_done[p] = piece_roots[p];
+            }
+            if (cache.save(fs_storage, need_v1 ? &hashes_done : nullptr, need_v2 ? &roots_done : nullptr,
+                           creation_date, &valid)) {
+                checkpoint_pieces_ = valid_pieces;
+            }
+        }, checkpoint_interval_);
+    }
+    hasher.hash_pieces(dirty_pieces, piece_hashes, need_v2 ? &piece_roots : nullptr);
+    
+    // create_torrent 不是线程安全的，所有线程结束后统一写入分片哈希
+    if (need_v1) {
+        for (int p = 0; p < num_pieces; ++p) {
+            torrent.set_hash(lt::piece_index_t(p), piece_hashes[p]);
+        }
+    }
+    
+    // 找出全零分片（包括复用缓存的分片）：与等长全零分片的哈希比较
+    zero_pieces_.assign(num_pieces, false);
+    if (sparse_aware_) {
+        for (int p = 0; p < num_pieces; ++p) {
+            lt::piece_index_t piece(p);
+            zero_pieces_[p] = need_v1 ? piece_hashes[p] == hasher.zero_hash(piece)
+                                      : piece_roots[p] == hasher.zero_piece_root(piece);
+        }
+    }
     
-    if (torrent_entry.type() == lt::entry::dictionary_t) {
-        const lt::entry::dictionary_type& dict = torrent_entry.dict();
-        auto info_it = dict.find("info");
-        if (info_it != dict.end()) {
-            // 计算 info 部分的 SHA1 哈希
-            std::vector<char> info_buf;
-            lt::bencode(std::back_inserter(info_buf), info_it->second);
-            info_hash_v1 = lt::sha1_hash(lt::hasher(info_buf).final());
+    // v2：按文件写入 piece layer，libtorrent 在 generate 时据此计算每个文件的默克尔根
+    if (need_v2) {
+        for (int f = 0; f < fs_storage.num_files(); ++f) {
+            lt::file_index_t file(f);
+            if (fs_storage.pad_file_at(file) || fs_storage.file_size(file) == 0) continue;
+            const int first = static_cast<int>(fs_storage.piece_index_at_file(file));
+            const int count = fs_storage.file_num_pieces(file);
+            for (int k = 0; k < count; ++k) {
+                torrent.set_hash2(file, lt::piece_index_t::diff_type(k), piece_roots[first + k]);
+            }
         }
     }
     
-    return info_hash_v1;
+    if (use_hash_cache_) {
+        if (dirty_pieces.empty() && cache.creation_date() > 0) {
+            creation_date = cache.creation_date();
+        }
+        if (cache.save(fs_storage, need_v1 ? &piece_hashes : nullptr, need_v2 ? &piece_roots : nullptr,
+                       creation_date)) {
+            log() << "哈希缓存已保存: " << cache.path() << std::endl;
+        }
+    }
 }
 
-bool TorrentBuilder::write_torrent_file(const lt::entry& torrent_entry, const std::string& output_path)
+bool TorrentBuilder::write_torrent_file(const lt::entry& torrent_entry, const std::string& output_path,
+                                        lt::info_hash_t& info_hashes)
 {
-    // 编码为 bencode 格式
-    std::vector<char> torrent_data;
-    lt::bencode(std::back_inserter(torrent_data), torrent_entry);
-    
-    // 写入文件
-    std::ofstream out(output_path, std::ios::binary);
-    if (!out.is_open()) {
-        std::cerr << "错误: 无法创建输出文件: " << output_path << std::endl;
-        return false;
+    namespace fs = std::filesystem;
+    
+    // 先写入临时文件再替换，避免中途失败留下不完整的 torrent 文件
+    std::string temp_path = output_path + ".tmp";
+    std::int64_t file_size = 0;
+    {
+        std::ofstream out(fs::u8path(temp_path), std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "错误: 无法创建输出文件: " << temp_path << std::endl;
+            return false;
+        }
+        
+        // 单次编码直接写入文件，编码 info 字典时顺带计算哈希
+        BencodeWriter writer(out);
+        if (!writer.write_torrent(torrent_entry, version_ != TorrentVersion::V2, version_ != TorrentVersion::V1)) {
+            std::cerr << "错误: 写入输出文件失败: " << temp_path << std::endl;
+            out.close();
+            std::error_code ec;
+            fs::remove(fs::u8path(temp_path), ec);
+            return false;
+        }
+        info_hashes = writer.info_hashes();
+        file_size = writer.bytes_written();
     }
     
-    out.write(torrent_data.data(), torrent_data.size());
-    out.close();
+    std::error_code ec;
+    fs::rename(fs::u8path(temp_path), fs::u8path(output_path), ec);
+    if (ec) {
+        std::cerr << "错误: 无法创建输出文件: " << output_path << " (" << ec.message() << ")" << std::endl;
+        fs::remove(fs::u8path(temp_path), ec);
+        return false;
+    }
     
-    std::cout << "文件大小: " << torrent_data.size() << " 字节" << std::endl;
+    log() << "文件大小: " << file_size << " 字节" << std::endl;
     
     return true;
 }
\ No newline at end of file
@@ -3,9 +3,23 @@
 
 #include <string>
 #include <vector>
+#include <ctime>
+#include <cstdint>
+#include <functional>
+#include <ostream>
 #include <libtorrent/file_storage.hpp>
+#include <libtorrent/create_torrent.hpp>
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/sha1_hash.hpp>
+#include <libtorrent/info_hash.hpp>
+#include "directory_scanner.hpp"
+
+// Torrent 协议版本
+enum class TorrentVersion {
+    V1,      // 仅 v1（SHA1 分片哈希）
+    V2,      // 仅 v2（每个文件一棵 SHA256 默克尔树）
+    Hybrid   // 混合（同时包含 v1 和 v2 信息，新旧客户端均可使用）
+};
 
 // Torrent 种子生成器类
 class TorrentBuilder
@@ -31,30 +45,112 @@ public:
     // 设置分片大小（字节），0 表示使用默认大小或自动选择
     inline void set_piece_size(int piece_size) { piece_size_ = piece_size; }
     
+    // 设置哈希计算线程数，0 表示使用 CPU 核心数
+    inline void set_hash_threads(int threads) { hash_threads_ = threads; }
+    
+    // 获取哈希计算线程数（0 表示自动）
+    inline int hash_threads() const { return hash_threads_; }
+    
+    // 设置读取阶段可提前填充的读取块数量
+    inline void set_read_ahead(int blocks) { read_ahead_ = blocks; }
+    
+    // 设置是否使用无缓冲 I/O 读取源文件（减少镜像服务器的页缓存占用）
+    inline void set_direct_io(bool enabled) { direct_io_ = enabled; }
+    
+    // 设置是否在 torrent 旁写入快速恢复数据（<输出>.resume），做种时据此跳过重新校验
+    inline void set_write_resume(bool enabled) { write_resume_ = enabled; }
+    
+    // 设置生成的 torrent 协议版本，默认仅 v1
+    inline void set_torrent_version(TorrentVersion version) { version_ = version; }
+    
+    // 设置目录扫描线程数，0 表示自动
+    inline void set_scan_threads(int threads) { scan_threads_ = threads; }
+    
+    // 设置是否识别稀疏空洞和全零分片（跳过读取空洞，并在 torrent 中记录全零分片表），默认开启
+    inline void set_sparse_aware(bool enabled) { sparse_aware_ = enabled; }
+    
+    // 设置访问顺序文件（启动访问跟踪或优先路径列表，每行一个路径，# 开头为注释）
+    // 列出的文件按列表顺序排在 torrent 最前面，顺序下载分片时与启动 I/O 顺序一致；仅对 v1 torrent 生效
+    inline void set_access_order_file(const std::string& path) { access_order_file_ = path; }
+    
+    // 设置是否在启动文件处插入 pad 文件，使前面的分片只包含启动数据
+    inline void set_pad_boot_files(bool enabled) { pad_boot_files_ = enabled; }
+    
+    // 设置哈希检查点间隔（秒），0 表示不保存检查点，默认 60
+    // 检查点写入哈希缓存文件，生成失败或中断后重新运行时跳过已完成的分片（需启用哈希缓存）
+    inline void set_checkpoint_interval(int seconds) { checkpoint_interval_ = seconds; }
+    
+    // 设置是否使用分片哈希缓存（<输出>.hashcache），默认启用
+    inline void set_hash_cache(bool enabled) { use_hash_cache_ = enabled; }
+    
+    // 设置安静模式：不输出生成过程中的信息和进度行，只输出错误（批量生成时由 BatchBuilder 统一输出进度）
+    inline void set_quiet(bool quiet) { quiet_ = quiet; }
+    
+    // 设置哈希进度回调：每 500 毫秒调用一次（done / total 为已计算 / 需计算的字节数，复用哈希缓存的分片不计入）
+    inline void set_progress(std::function<void(std::int64_t done, std::int64_t total)> callback)
+    {
+        progress_ = std::move(callback);
+    }
+    
+    // 获取最近一次生成的 torrent 中的数据总大小（字节）
+    inline std::int64_t last_total_size() const { return last_total_size_; }
+    
     // 获取当前配置的 tracker 列表
     inline const std::vector<std::string>& get_trackers() const { return trackers_; }
 
 private:
+    // 普通信息的输出流（安静模式下丢弃）
+    std::ostream& log() const;
+    
     // 验证路径是否存在
     bool validate_path(const std::string& file_path);
     
     // 确定根路径（父目录）
     std::string determine_root_path(const std::string& file_path);
     
-    // 添加文件或目录到存储
-    void add_files_to_storage(lt::file_storage& fs_storage, const std::string& file_path);
+    // 并行扫描文件或目录并添加到存储（按路径排序），同时记录文件修改时间供后续阶段使用
+    // 失败或目录为空时返回 false
+    // 指定了访问顺序文件时按访问顺序排列文件
+    bool add_files_to_storage(lt::file_storage& fs_storage, const std::string& file_path);
+    
+    // 根据分类策略和用户设置选择分片大小，返回 0 表示由 libtorrent 自动选择
+    int choose_piece_length(std::int64_t total_size, int num_files) const;
+    
+    // 读取访问顺序文件，每行取最后一个制表符之后的字段作为路径，失败时返回 false
+    bool load_access_order(std::vector<std::string>& access_order) const;
     
-    // 从 entry 中提取 info_hash
-    lt::sha1_hash extract_info_hash(const lt::entry& torrent_entry);
+    // 多线程计算所有分片的哈希（v1 SHA1 / v2 默克尔根）并写入 torrent
+    // 启用哈希缓存时只重新计算文件发生变化的分片；creation_date 在全部分片复用时改为缓存中的创建时间
+    void compute_piece_hashes(lt::create_torrent& torrent, const lt::file_storage& fs_storage,
+                              const std::string& root_path, const std::string& output_path,
+                              std::time_t& creation_date);
     
-    // 写入 torrent 文件
-    bool write_torrent_file(const lt::entry& torrent_entry, const std::string& output_path);
+    // 流式编码并写入 torrent 文件，同时计算 info_hash（v1 为 info 字典的 SHA1，v2 为 SHA256）
+    bool write_torrent_file(const lt::entry& torrent_entry, const std::string& output_path,
+                            lt::info_hash_t& info_hashes);
 
 private:
     std::vector<std::string> trackers_;  // tracker 列表
     std::string comment_;                // 注释
     std::string creator_;                 // 创建者
     int piece_size_;                     // 分片大小（0 表示使用默认或自动选择）
+    int hash_threads_;                   // 哈希计算线程数（0 表示自动）
+    int read_ahead_;                     // 读取阶段可提前填充的读取块数量
+    bool direct_io_;                     // 是否使用无缓冲 I/O
+    bool use_hash_cache_;                // 是否使用分片哈希缓存
+    TorrentVersion version_;             // 生成的 torrent 协议版本
+    bool write_resume_;                  // 是否写入快速恢复数据
+    int scan_threads_;                   // 目录扫描线程数（0 表示自动）
+    ScannedMtimes scanned_mtimes_;       // 扫描时记录的文件修改时间
+    bool sparse_aware_;                  // 是否识别稀疏空洞和全零分片
+    std::vector<bool> zero_pieces_;      // 全零分片标记（compute_piece_hashes 中计算）
+    std::string access_order_file_;      // 访问顺序文件（为空表示按路径排序）
+    bool pad_boot_files_;                // 是否在启动文件处插入 pad 文件
+    std::int64_t last_total_size_;       // 最近一次生成的数据总大小
+    int checkpoint_interval_;            // 哈希检查点间隔（秒，0 表示不保存）
+    int checkpoint_pieces_;              // 最近一次保存的检查点中已完成的分片数量
+    bool quiet_;                         // 是否只输出错误
+    std::function<void(std::int64_t, std::int64_t)> progress_;  // 哈希进度回调
 };
 
 #endif // TORRENT_BUILDER_HPP
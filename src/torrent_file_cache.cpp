@@ -0,0 +1,240 @@
+#include "torrent_file_cache.hpp"
+#include "raw_file.hpp"
+#include "zero_pieces.hpp"
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <filesystem>
+#include <cerrno>
+#include <libtorrent/bdecode.hpp>
+#include <libtorrent/error_code.hpp>
+
+namespace {
+
+// 缓存条目
+struct CacheEntry {
+    std::int64_t mtime;                          // 文件修改时间
+    std::uint64_t size;                          // 文件大小
+    std::uint64_t last_used;                     // 最近访问序号（用于淘汰）
+    std::shared_ptr<lt::torrent_info> ti;        // 解析结果
+    std::shared_ptr<const std::vector<bool>> zero_pieces;  // 全零分片表（没有时为空）
+};
+
+// 缓存状态（函数内静态变量，避免静态初始化顺序问题）
+struct CacheState {
+    std::mutex mutex;
+    std::unordered_map<std::string, CacheEntry> entries;  // 以规范化路径为键
+    size_t capacity = 4096;
+    size_t trim_at = 4096;                                // 条目数超过该值时淘汰
+    std::uint64_t clock = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+};
+
+CacheState& state()
+{
+    static CacheState instance;
+    return instance;
+}
+
+// 缓存键：同一文件的不同写法（相对/绝对路径）共用一个条目
+std::string cache_key(const std::string& torrent_path)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path absolute = fs::absolute(fs::u8path(torrent_path), ec);
+    if (ec) {
+        return torrent_path;
+    }
+    return absolute.lexically_normal().u8string();
+}
+
+// 读取文件的修改时间和大小
+bool stat_file(const std::string& path, std::int64_t& mtime, std::uint64_t& size)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path file_path = fs::u8path(path);
+    size = fs::file_size(file_path, ec);
+    if (ec) {
+        return false;
+    }
+    auto time = fs::last_write_time(file_path, ec);
+    if (ec) {
+        return false;
+    }
+    mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+// 淘汰最久未使用且只被缓存引用的条目（仅在已持有 mutex 时调用）
+// 超过 trim_at 时才扫描一次，淘汰到容量的 3/4；条目都在使用中时提高 trim_at，插入的均摊开销为 O(1)
+void trim_unsafe(CacheState& cache)
+{
+    if (cache.entries.size() <= cache.trim_at) {
+        return;
+    }
+    std::vector<std::pair<std::uint64_t, std::string>> unused;
+    for (const auto& pair : cache.entries) {
+        if (pair.second.ti.use_count() == 1) {
+            unused.emplace_back(pair.second.last_used, pair.first);
+        }
+    }
+    std::sort(unused.begin(), unused.end());
+    const size_t target = cache.capacity - cache.capacity / 4;
+    for (const auto& item : unused) {
+        if (cache.entries.size() <= target) {
+            break;
+        }
+        cache.entries.erase(item.second);
+    }
+    cache.trim_at = std::max(cache.capacity, cache.entries.size() * 2);
+}
+
+// 加载缓存条目：命中时只检查修改时间和大小，未命中时映射文件并解析
+bool load_entry(const std::string& torrent_path, lt::error_code& ec, std::shared_ptr<lt::torrent_info>& ti,
+                std::shared_ptr<const std::vector<bool>>& zero_pieces)
+{
+    ec.clear();
+    CacheState& cache = state();
+    const std::string key = cache_key(torrent_path);
+
+    std::int64_t mtime = 0;
+    std::uint64_t size = 0;
+    if (!stat_file(key, mtime, size)) {
+        ec = lt::error_code(ENOENT, lt::generic_category());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.entries.find(key);
+        if (it != cache.entries.end() && it->second.mtime == mtime && it->second.size == size) {
+            it->second.last_used = ++cache.clock;
+            ++cache.hits;
+            ti = it->second.ti;
+            zero_pieces = it->second.zero_pieces;
+            return true;
+        }
+    }
+
+    // 未命中：映射文件并只 bdecode 一次，torrent_info 和全零分片表都从同一个节点读取（不持有锁，多个线程可同时解析不同文件）
+    MappedFile file;
+    if (size == 0) {
+        ec = lt::errors::make_error_code(lt::errors::torrent_file_parse_failed);
+        return false;
+    }
+    if (!file.open(key)) {
+        if (file.last_error() != 0) {
+            ec = lt::error_code(file.last_error(), lt::system_category());
+        } else {
+            ec = lt::errors::make_error_code(lt::errors::torrent_file_parse_failed);
+        }
+        return false;
+    }
+    lt::bdecode_node root = lt::bdecode(lt::span<char const>(file.data(), static_cast<std::ptrdiff_t>(file.size())),
+                                        ec, nullptr, 100, 3000000);
+    if (ec) {
+        return false;
+    }
+    auto parsed = std::make_shared<lt::torrent_info>(root, ec);
+    if (ec) {
+        return false;
+    }
+    std::shared_ptr<const std::vector<bool>> parsed_zero;
+    std::vector<bool> zero;
+    if (ZeroPieceMap::read(root, parsed->num_pieces(), zero)) {
+        parsed_zero = std::make_shared<const std::vector<bool>>(std::move(zero));
+    }
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    ++cache.misses;
+    CacheEntry& entry = cache.entries[key];
+    if (entry.ti && entry.mtime == mtime && entry.size == size) {
+        // 其他线程已经解析了同一版本的文件，使用先放入缓存的实例
+        entry.last_used = ++cache.clock;
+        ti = entry.ti;
+        zero_pieces = entry.zero_pieces;
+        return true;
+    }
+    entry.mtime = mtime;
+    entry.size = size;
+    entry.last_used = ++cache.clock;
+    entry.ti = parsed;
+    entry.zero_pieces = parsed_zero;
+    trim_unsafe(cache);
+    ti = parsed;
+    zero_pieces = parsed_zero;
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<lt::torrent_info> TorrentFileCache::load_for_session(const std::string& torrent_path, lt::error_code& ec)
+{
+    std::shared_ptr<lt::torrent_info> ti;
+    std::shared_ptr<const std::vector<bool>> zero_pieces;
+    if (!load_entry(torrent_path, ec, ti, zero_pieces) || !ti) {
+        // 调用方只检查 ec：返回空指针时必须带有错误码
+        if (!ec) {
+            ec = lt::errors::make_error_code(lt::errors::torrent_file_parse_failed);
+        }
+        return nullptr;
+    }
+    return ti;
+}
+
+std::shared_ptr<const std::vector<bool>> TorrentFileCache::load_zero_pieces(const std::string& torrent_path)
+{
+    lt::error_code ec;
+    std::shared_ptr<lt::torrent_info> ti;
+    std::shared_ptr<const std::vector<bool>> zero_pieces;
+    if (!load_entry(torrent_path, ec, ti, zero_pieces)) {
+        return nullptr;
+    }
+    return zero_pieces;
+}
+
+std::shared_ptr<const lt::torrent_info> TorrentFileCache::load(const std::string& torrent_path, lt::error_code& ec)
+{
+    return load_for_session(torrent_path, ec);
+}
+
+void TorrentFileCache::evict(const std::string& torrent_path)
+{
+    CacheState& cache = state();
+    const std::string key = cache_key(torrent_path);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.entries.erase(key);
+}
+
+void TorrentFileCache::clear()
+{
+    CacheState& cache = state();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.entries.clear();
+}
+
+void TorrentFileCache::set_capacity(size_t capacity)
+{
+    CacheState& cache = state();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.capacity = capacity;
+    cache.trim_at = capacity;
+    trim_unsafe(cache);
+}
+
+std::uint64_t TorrentFileCache::hits()
+{
+    CacheState& cache = state();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return cache.hits;
+}
+
+std::uint64_t TorrentFileCache::misses()
+{
+    CacheState& cache = state();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return cache.misses;
+}
@@ -0,0 +1,47 @@
+#ifndef TORRENT_FILE_CACHE_HPP
+#define TORRENT_FILE_CACHE_HPP
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/error_code.hpp>
+
+// .torrent 解析结果的进程级缓存
+// 文件通过内存映射后只 bdecode 一次，不再读入中间缓冲区；解析结果以 (路径, 修改时间, 大小) 为键共享，
+// 重新添加同一个 torrent、做种前的检查和状态显示使用同一个不可变的 torrent_info，不再重复解析
+// 顶层的全零分片表（x-zero-pieces）在同一次解析中读取，与 torrent_info 一起缓存
+// 文件被修改后自动重新解析；缓存超过容量时淘汰不再被其他地方引用的条目
+// 线程安全
+class TorrentFileCache
+{
+public:
+    // 加载 torrent 文件（命中缓存时不访问文件内容，只检查修改时间和大小）
+    // 返回: 解析结果（与缓存及其他调用方共享，不能修改），失败时返回空指针并设置 ec
+    static std::shared_ptr<const lt::torrent_info> load(const std::string& torrent_path, lt::error_code& ec);
+
+    // 用于 add_torrent_params::ti 的版本（libtorrent 要求非 const 指针，返回的仍是共享实例，调用方不能修改）
+    // session 中的 torrent 会修改 torrent_info（初始化后释放 v2 piece layer、重命名文件等）：
+    // add_torrent / async_add_torrent 的 const& 重载会复制一份，rvalue 重载不复制，使用前必须先复制
+    static std::shared_ptr<lt::torrent_info> load_for_session(const std::string& torrent_path, lt::error_code& ec);
+    
+    // 获取 torrent 文件中的全零分片表（与 load 共用缓存，不重新读取文件）
+    // 返回: 每个分片是否为全零，没有该表、格式错误或无法加载时返回空指针
+    static std::shared_ptr<const std::vector<bool>> load_zero_pieces(const std::string& torrent_path);
+
+    // 删除指定文件的缓存
+    static void evict(const std::string& torrent_path);
+
+    // 清空缓存
+    static void clear();
+
+    // 设置缓存容量（条目数，默认 4096）；仍在使用中的条目不计入淘汰
+    static void set_capacity(size_t capacity);
+
+    // 缓存命中 / 解析次数（用于诊断）
+    static std::uint64_t hits();
+    static std::uint64_t misses();
+};
+
+#endif // TORRENT_FILE_CACHE_HPP
@@ -1,4 +1,10 @@
 #include "torrent_manager.hpp"
+#include "zero_pieces.hpp"
+#include "seed_resume.hpp"
+#include "piece_hasher.hpp"
+#include "torrent_file_cache.hpp"
+#include "prefetch_profile.hpp"
+#include <libtorrent/ip_filter.hpp>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -12,7 +18,9 @@
 #include <thread>
 #include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <algorithm>
+#include <iterator>
 
 // 辅助函数：格式化字节数
 static std::string format_bytes(std::int64_t bytes)
@@ -59,13 +67,32 @@ TorrentManager& TorrentManager::getInstance()
 // 私有构造函数
 TorrentManager::TorrentManager()
     : session_(nullptr)
+    , resume_store_("torrent_state")
+    , resume_interval_(60)
+    , verify_before_seeding_(false)
+    , last_resume_save_(std::chrono::steady_clock::now())
+    , event_pending_(false)
+    , resume_replies_(0)
+    , snapshot_dirty_(false)
+    , snapshot_(std::make_shared<const TorrentSnapshot>())
+    , snapshot_version_(0)
 {
     configure_session();
+    
+    // alert 由独立线程分发，session 只产生已注册处理函数所需类别的 alert
+    alert_dispatcher_ = std::make_unique<AlertDispatcher>(*session_);
+    register_alert_handlers();
+    alert_dispatcher_->start();
 }
 
 // 析构函数
 TorrentManager::~TorrentManager()
 {
+    // 退出前保存所有 torrent 的恢复数据，下次启动无需重新校验
+    flush_resume_data();
+    if (alert_dispatcher_) {
+        alert_dispatcher_->stop();
+    }
     stop_all();
 }
 
@@ -73,72 +100,21 @@ TorrentManager::~TorrentManager()
 void TorrentManager::configure_session()
 {
     try {
-        // 创建 session 配置（合并 Downloader 和 Seeder 的最佳配置）
-        lt::settings_pack settings;
-        settings.set_int(lt::settings_pack::alert_mask, 
-                         lt::alert::status_notification | 
-                         lt::alert::error_notification |
-                         lt::alert::peer_notification |
-                         lt::alert::storage_notification |
-                         lt::alert::tracker_notification);  // 添加 tracker 通知
-        
-        // 设置监听接口
-        // 使用 6881-6891 端口范围，libtorrent 会自动选择可用端口
-        // 格式: "IP:端口" 或 "0.0.0.0:端口" 表示所有接口
-        settings.set_str(lt::settings_pack::listen_interfaces, "0.0.0.0:6881-6891,[::]:6881-6891");
-        
-        // 启用 DHT（对等节点发现的重要方式）
-        settings.set_bool(lt::settings_pack::enable_dht, true);
-        
-        // 启用本地服务发现（局域网内发现其他客户端）
-        settings.set_bool(lt::settings_pack::enable_lsd, true);
-        
-        // 启用 UPnP 和 NAT-PMP（自动端口映射）
-        settings.set_bool(lt::settings_pack::enable_upnp, true);
-        settings.set_bool(lt::settings_pack::enable_natpmp, true);
-        
-        // 设置上传/下载速度限制（0 表示无限制）
-        settings.set_int(lt::settings_pack::download_rate_limit, 0);
-        settings.set_int(lt::settings_pack::upload_rate_limit, 0);
-        
-        // 设置最大连接数（支持并发下载和做种）
-        settings.set_int(lt::settings_pack::connections_limit, 200);
-        
-        // 设置磁盘缓存大小（大文件需要更大的缓存）
-        settings.set_int(lt::settings_pack::cache_size, 512);
-        
-        // 设置磁盘缓存过期时间（毫秒）
-        settings.set_int(lt::settings_pack::cache_expiry, 300);
-        
-        // 设置磁盘写入队列大小（大文件需要更大的队列）
-        settings.set_int(lt::settings_pack::max_queued_disk_bytes, 1024 * 1024 * 1024); // 1GB
-        
-        // 允许来自同一 IP 的多个连接（用于本地测试）
-        settings.set_bool(lt::settings_pack::allow_multiple_connections_per_ip, true);
-        
-        // 设置 announce 间隔（更频繁地向 tracker 报告）
-        settings.set_int(lt::settings_pack::min_announce_interval, 30);
-        
-        // 允许传入连接
-        settings.set_bool(lt::settings_pack::enable_incoming_tcp, true);
-        settings.set_bool(lt::settings_pack::enable_incoming_utp, true);
-        settings.set_bool(lt::settings_pack::enable_outgoing_tcp, true);
-        settings.set_bool(lt::settings_pack::enable_outgoing_utp, true);
-        
-        // 设置 DHT 引导节点（加速 DHT 网络发现）
-        settings.set_str(lt::settings_pack::dht_bootstrap_nodes,
-            "router.bittorrent.com:6881,"
-            "router.utorrent.com:6881,"
-            "dht.transmissionbt.com:6881,"
-            "dht.aelitis.com:6881");
+        // 使用进程默认的会话配置（默认 wan，可通过 --profile 选择，运行时用 apply_profile 切换）
+        // alert_mask 由 AlertDispatcher 根据已订阅的 alert 设置（tracker/peer 等未处理的 alert 不再产生）
+        profile_ = SessionProfile::get_default();
+        lt::settings_pack settings = profile_.to_settings();
         
         // 创建 session
         session_ = std::make_unique<lt::session>(settings);
         
-        std::cout << "TorrentManager 会话已初始化（监听端口范围: 6881-6891）" << std::endl;
-        std::cout << "  - DHT: 启用（含引导节点）" << std::endl;
-        std::cout << "  - LSD (本地发现): 启用" << std::endl;
-        std::cout << "  - UPnP/NAT-PMP: 启用" << std::endl;
+        lt::ip_filter filter;
+        if (profile_.build_ip_filter(filter)) {
+            session_->set_ip_filter(filter);
+        }
+        
+        std::cout << "TorrentManager 会话已初始化" << std::endl;
+        profile_.print();
         std::cout << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "初始化 TorrentManager 会话失败: " << e.what() << std::endl;
@@ -146,6 +122,39 @@ void TorrentManager::configure_session()
     }
 }
 
+// 切换会话配置
+bool TorrentManager::apply_profile(const SessionProfile& profile)
+{
+    if (!session_) {
+        return false;
+    }
+    
+    try {
+        lt::ip_filter filter;
+        if (!profile.build_ip_filter(filter)) {
+            return false;
+        }
+        
+        // 只应用配置中的设置，alert_mask 保持 AlertDispatcher 设置的值
+        session_->apply_settings(profile.to_settings());
+        session_->set_ip_filter(filter);
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        profile_ = profile;
+        std::cout << "已切换会话配置: " << profile.name << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "切换会话配置失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::string TorrentManager::current_profile() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return profile_.name;
+}
+
 // 验证路径
 bool TorrentManager::validate_paths(const std::string& torrent_path, const std::string& save_path, bool create_save_path)
 {
@@ -186,11 +195,36 @@ bool TorrentManager::validate_paths(const std::string& torrent_path, const std::
 // 从 torrent_info 获取 info_hash 字符串
 std::string TorrentManager::get_info_hash_string(const lt::torrent_info& ti) const
 {
-    lt::sha1_hash hash = ti.info_hash();
-    // 将 sha1_hash 转换为十六进制字符串
-    std::ostringstream oss;
-    oss << hash;
-    return oss.str();
+    return TorrentKey::primary(ti.info_hashes()).to_hex();
+}
+
+// 从 torrent_info 获取 v2 info_hash 字符串
+std::string TorrentManager::get_info_hash_v2_string(const lt::torrent_info& ti) const
+{
+    lt::info_hash_t hashes = ti.info_hashes();
+    if (!hashes.has_v2()) {
+        return "";
+    }
+    return TorrentKey::from_v2(hashes.v2).to_hex();
+}
+
+// 按 info_hash 查找 torrent（v1 哈希或 v2 哈希均可）
+TorrentInfo* TorrentManager::find_torrent_unsafe(const std::string& info_hash)
+{
+    TorrentKey key;
+    if (!TorrentKey::from_hex(info_hash, key)) {
+        return nullptr;
+    }
+    return torrents_.find(key);
+}
+
+const TorrentInfo* TorrentManager::find_torrent_unsafe(const std::string& info_hash) const
+{
+    TorrentKey key;
+    if (!TorrentKey::from_hex(info_hash, key)) {
+        return nullptr;
+    }
+    return torrents_.find(key);
 }
 
 // 开始下载
@@ -204,26 +238,20 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
             return "";
         }
         
-        // 加载 torrent 文件
-        std::ifstream torrent_file(torrent_path, std::ios::binary);
-        if (!torrent_file.is_open()) {
-            std::cerr << "错误: 无法打开 torrent 文件: " << torrent_path << std::endl;
-            return "";
-        }
-        
-        // 解析 torrent 文件
+        // 解析 torrent 文件（内存映射后解析，结果与 TorrentFileCache 共享；add_torrent 的 const& 重载为 session 复制一份）
         lt::error_code ec;
-        lt::torrent_info ti(torrent_path, ec);
+        auto ti_ptr = TorrentFileCache::load_for_session(torrent_path, ec);
         if (ec) {
             std::cerr << "错误: 解析 torrent 文件失败: " << ec.message() << std::endl;
             return "";
         }
+        const lt::torrent_info& ti = *ti_ptr;
         
         // 获取 info_hash
         std::string info_hash = get_info_hash_string(ti);
         
         // 检查是否已存在
-        if (torrents_.find(info_hash) != torrents_.end()) {
+        if (torrents_.find(TorrentKey::primary(ti.info_hashes())) != nullptr) {
             std::cerr << "错误: 该 torrent 已存在（info_hash: " << info_hash << "）" << std::endl;
             return "";
         }
@@ -236,6 +264,7 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
         std::cout << "  文件大小: " << format_bytes(torrent_size) << std::endl;
         std::cout << "  分片大小: " << format_bytes(ti.piece_length()) << std::endl;
         std::cout << "  分片数量: " << ti.num_pieces() << std::endl;
+        std::cout << "  协议版本: " << (ti.info_hashes().has_v1() ? (ti.info_hashes().has_v2() ? "混合 (v1 + v2)" : "v1") : "v2") << std::endl;
         std::cout << "  文件数量: " << ti.num_files() << std::endl;
         
         // 显示 torrent 中的 tracker 信息
@@ -251,26 +280,24 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
         
         // 创建 add_torrent_params
         lt::add_torrent_params params;
-        params.ti = std::make_shared<lt::torrent_info>(ti);
+        params.ti = ti_ptr;
         params.save_path = save_path;
         
-        // 针对大文件的优化设置
-        const std::int64_t large_file_threshold = 50LL * 1024 * 1024 * 1024; // 50GB
-        
-        if (torrent_size > large_file_threshold) {
-            std::cout << "检测到大文件（总大小: " 
-                      << format_bytes(torrent_size) 
-                      << "），应用大文件下载优化..." << std::endl;
-            
-            params.flags &= ~lt::torrent_flags::auto_managed;
-            params.flags &= ~lt::torrent_flags::paused;
-            
-            std::cout << "使用手动下载模式（跳过自动管理）..." << std::endl;
+        // 优先加载上次运行保存的恢复数据（已下载的分片无需重新校验，从中断处继续）
+        if (resume_store_.load(ti, save_path, params)) {
+            std::cout << "已加载恢复数据，从上次的下载进度继续: " << resume_store_.state_dir() << std::endl;
         } else {
-            params.flags |= lt::torrent_flags::auto_managed;
-            params.flags &= ~lt::torrent_flags::paused;  // 确保不处于暂停状态
+            // 全零分片无需下载：新建稀疏文件并直接标记为已拥有
+            ZeroPieceMap::prepare_download(torrent_path, ti, save_path, params);
         }
         
+        // 按分类策略设置连接数、队列和文件优先级
+        const TorrentPolicy policy = TorrentPolicy::get_default();
+        const TorrentClass& torrent_class = policy.classify(ti);
+        torrent_class.apply(params, false);
+        std::cout << "分类: " << torrent_class.name << "（连接数 " << torrent_class.max_connections
+                  << (torrent_class.auto_managed ? "，自动管理" : "，手动管理") << "）" << std::endl;
+        
         // 添加 torrent 到 session
         lt::torrent_handle th = session_->add_torrent(params, ec);
         
@@ -278,25 +305,13 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
             std::cerr << "错误: 添加 torrent 失败: " << ec.message() << std::endl;
             return "";
         }
+        torrent_class.apply_handle(th);
         
-        // 设置下载优先级（非上传模式）
-        th.set_upload_mode(false);
-        
-        // 对于大文件，设置更高的下载优先级和更多连接
-        if (torrent_size > large_file_threshold) {
-            th.set_max_connections(200);
-            
-            std::vector<int> priorities;
-            for (int i = 0; i < ti.num_files(); ++i) {
-                priorities.push_back(7); // 最高优先级
-            }
-            th.prioritize_files(priorities);
-            
-            th.resume();
-            
-            std::cout << "已强制开始下载..." << std::endl;
-        } else {
-            th.set_max_connections(100);
+        // torrent 旁有预取配置时，启动会读取的分片优先并按截止时间下载
+        PrefetchProfile prefetch;
+        if (prefetch.load(PrefetchProfile::path_for(torrent_path), ti)) {
+            prefetch.apply(th);
+            prefetch.print_summary();
         }
         
         // 确保下载已开始
@@ -315,9 +330,21 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
         info.torrent_path = torrent_path;
         info.save_path = save_path;
         info.info_hash = info_hash;
+        info.info_hash_v2 = get_info_hash_v2_string(ti);
+        info.key = TorrentKey::primary(ti.info_hashes());
+        info.key_v2 = TorrentKey::secondary(ti.info_hashes());
         info.is_valid = true;
         
-        torrents_[info_hash] = info;
+        // 初始状态，首个 state_update_alert 到达后替换
+        info.status.handle = th;
+        info.status.info_hashes = ti.info_hashes();
+        info.status.state = lt::torrent_status::checking_resume_data;
+        info.status.total_wanted = torrent_size;
+        info.status.flags = params.flags;
+        
+        torrents_.insert(std::move(info));
+        publish_snapshot_unsafe();
+        session_->post_torrent_updates(lt::status_flags_t{});
         
         std::cout << "开始下载 [info_hash: " << info_hash.substr(0, 8) << "...]" << std::endl;
         std::cout << "Torrent 文件: " << torrent_path << std::endl;
@@ -328,9 +355,6 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
         std::cout << "正在向 Tracker 和 DHT 网络请求对等节点..." << std::endl;
         std::cout << std::endl;
         
-        // 等待 torrent 状态更新
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        
         return info_hash;
     } catch (const std::exception& e) {
         std::cerr << "开始下载时出错: " << e.what() << std::endl;
@@ -341,34 +365,57 @@ std::string TorrentManager::start_download(const std::string& torrent_path, cons
 // 开始做种
 std::string TorrentManager::start_seeding(const std::string& torrent_path, const std::string& save_path)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // 启用预先校验且没有快速恢复数据时先用多线程哈希引擎校验本地数据（阻塞调用线程，但不持有 mutex_）
+    // 校验结果作为恢复数据交给 libtorrent，比 libtorrent 自身的检查快，也不会在未校验的情况下做种
+    VerifyResult verified;
+    bool use_verified = false;
+    if (verify_before_seeding_) {
+        std::error_code ec;
+        lt::error_code load_ec;
+        auto ti = TorrentFileCache::load(torrent_path, load_ec);
+        const bool has_state = ti && resume_store_.has(ti->info_hashes());
+        if (!has_state && !std::filesystem::exists(std::filesystem::u8path(SeedResume::path_for(torrent_path)), ec)) {
+            use_verified = verify_torrent(torrent_path, save_path, verified);
+            if (use_verified) {
+                print_verify_report(verified);
+            }
+        }
+    }
     
+    std::lock_guard<std::mutex> lock(mutex_);
+    return start_seeding_unsafe(torrent_path, save_path, use_verified ? &verified : nullptr);
+}
+
+std::string TorrentManager::start_seeding(const std::string& torrent_path, const std::string& save_path,
+                                          const VerifyResult& verified)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return start_seeding_unsafe(torrent_path, save_path, &verified);
+}
+
+std::string TorrentManager::start_seeding_unsafe(const std::string& torrent_path, const std::string& save_path,
+                                                 const VerifyResult* verified)
+{
     try {
         // 验证路径
         if (!validate_paths(torrent_path, save_path, false)) {
             return "";
         }
         
-        // 加载 torrent 文件
-        std::ifstream torrent_file(torrent_path, std::ios::binary);
-        if (!torrent_file.is_open()) {
-            std::cerr << "错误: 无法打开 torrent 文件: " << torrent_path << std::endl;
-            return "";
-        }
-        
-        // 解析 torrent 文件
+        // 解析 torrent 文件（内存映射后解析，结果与 TorrentFileCache 共享；add_torrent 的 const& 重载为 session 复制一份）
         lt::error_code ec;
-        lt::torrent_info ti(torrent_path, ec);
+        auto ti_ptr = TorrentFileCache::load_for_session(torrent_path, ec);
         if (ec) {
             std::cerr << "错误: 解析 torrent 文件失败: " << ec.message() << std::endl;
             return "";
         }
+        const lt::torrent_info& ti = *ti_ptr;
         
         // 获取 info_hash
         std::string info_hash = get_info_hash_string(ti);
         
         // 检查是否已存在
-        if (torrents_.find(info_hash) != torrents_.end()) {
+        if (torrents_.find(TorrentKey::primary(ti.info_hashes())) != nullptr) {
             std::cerr << "错误: 该 torrent 已存在（info_hash: " << info_hash << "）" << std::endl;
             return "";
         }
@@ -407,29 +454,51 @@ std::string TorrentManager::start_seeding(const std::string& torrent_path, const
         
         // 创建 add_torrent_params
         lt::add_torrent_params params;
-        params.ti = std::make_shared<lt::torrent_info>(ti);
+        params.ti = ti_ptr;
         params.save_path = save_path;
         
-        // 对于大文件（>50GB），如果文件存在，使用 seed_mode 跳过验证以快速启动做种
-        const std::int64_t large_file_threshold = 50LL * 1024 * 1024 * 1024; // 50GB
-        
-        if (torrent_size > large_file_threshold && files_exist) {
-            std::cout << "检测到大文件（总大小: " 
-                      << format_bytes(torrent_size) 
-                      << "），文件已存在，使用快速模式启动做种..." << std::endl;
-            params.flags |= lt::torrent_flags::seed_mode;
-            params.flags |= lt::torrent_flags::auto_managed;
+        // 优先使用校验结果，其次是生成 torrent 时写入的快速恢复数据（文件状态一致时无需重新校验）
+        const std::string resume_path = SeedResume::path_for(torrent_path);
+        const bool verified_matches = verified && verified->is_valid &&
+                                      verified->info_hashes == ti.info_hashes() &&
+                                      static_cast<int>(verified->piece_ok.size()) == ti.num_pieces();
+        bool resume_loaded = false;
+        bool state_loaded = !verified_matches && resume_store_.load(ti, save_path, params);
+        if (state_loaded) {
+            std::cout << "已加载上次运行保存的恢复数据，跳过文件校验直接做种: " << resume_store_.state_dir() << std::endl;
+        } else if (verified_matches) {
+            params.have_pieces.resize(ti.num_pieces(), false);
+            for (int p = 0; p < ti.num_pieces(); ++p) {
+                if (verified->piece_ok[p]) {
+                    params.have_pieces.set_bit(lt::piece_index_t(p));
+                }
+            }
+            std::cout << "使用本地校验结果启动做种: " << (ti.num_pieces() - verified->failed_pieces) << " / "
+                      << ti.num_pieces() << " 个分片已校验通过" << std::endl;
         } else {
-            if (torrent_size > large_file_threshold) {
-                std::cout << "检测到大文件（总大小: " 
-                          << format_bytes(torrent_size) 
-                          << "），将进行文件验证（可能需要一些时间）..." << std::endl;
+            if (verified) {
+                std::cout << "校验结果与 torrent 不匹配，忽略" << std::endl;
             }
-            params.flags |= lt::torrent_flags::auto_managed;
+            resume_loaded = SeedResume::load(resume_path, ti, save_path, params);
         }
         
-        // 确保做种时不被暂停
-        params.flags &= ~lt::torrent_flags::paused;
+        // 按分类策略设置连接数和队列
+        const TorrentPolicy policy = TorrentPolicy::get_default();
+        const TorrentClass& torrent_class = policy.classify(ti);
+        torrent_class.apply(params, true);
+        
+        if (resume_loaded) {
+            std::cout << "已加载快速恢复数据，跳过文件校验直接做种: " << resume_path << std::endl;
+        } else if (!verified_matches && !state_loaded) {
+            // 默认不根据文件是否存在使用 seed_mode，避免在数据损坏时直接做种；分类设置了 trust_existing_files 时除外
+            if (torrent_class.trust_existing_files && TorrentPolicy::data_present(ti, save_path)) {
+                params.flags |= lt::torrent_flags::seed_mode;
+                std::cout << "分类 " << torrent_class.name << " 信任已有文件，所有文件大小一致，跳过校验直接做种" << std::endl;
+            } else {
+                std::cout << "没有可用的校验结果或快速恢复数据，将由 libtorrent 校验文件"
+                          << "（总大小: " << format_bytes(torrent_size) << "，可能需要一些时间）..." << std::endl;
+            }
+        }
         
         // 添加 torrent 到 session
         lt::torrent_handle th = session_->add_torrent(params, ec);
@@ -438,9 +507,7 @@ std::string TorrentManager::start_seeding(const std::string& torrent_path, const
             std::cerr << "错误: 添加 torrent 失败: " << ec.message() << std::endl;
             return "";
         }
-        
-        // 设置更多连接数
-        th.set_max_connections(100);
+        torrent_class.apply_handle(th);
         
         // 强制向 tracker 发送 announce 请求
         th.force_reannounce();
@@ -455,9 +522,21 @@ std::string TorrentManager::start_seeding(const std::string& torrent_path, const
         info.torrent_path = torrent_path;
         info.save_path = save_path;
         info.info_hash = info_hash;
+        info.info_hash_v2 = get_info_hash_v2_string(ti);
+        info.key = TorrentKey::primary(ti.info_hashes());
+        info.key_v2 = TorrentKey::secondary(ti.info_hashes());
         info.is_valid = true;
         
-        torrents_[info_hash] = info;
+        // 初始状态，首个 state_update_alert 到达后替换
+        info.status.handle = th;
+        info.status.info_hashes = ti.info_hashes();
+        info.status.state = lt::torrent_status::checking_resume_data;
+        info.status.total_wanted = torrent_size;
+        info.status.flags = params.flags;
+        
+        torrents_.insert(std::move(info));
+        publish_snapshot_unsafe();
+        session_->post_torrent_updates(lt::status_flags_t{});
         
         std::cout << "开始做种 [info_hash: " << info_hash.substr(0, 8) << "...]" << std::endl;
         std::cout << "Torrent 文件: " << torrent_path << std::endl;
@@ -468,9 +547,6 @@ std::string TorrentManager::start_seeding(const std::string& torrent_path, const
         std::cout << "正在向 Tracker 和 DHT 网络发布做种信息..." << std::endl;
         std::cout << std::endl;
         
-        // 等待 torrent 状态更新
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        
         return info_hash;
     } catch (const std::exception& e) {
         std::cerr << "开始做种时出错: " << e.what() << std::endl;
@@ -478,20 +554,356 @@ std::string TorrentManager::start_seeding(const std::string& torrent_path, const
     }
 }
 
+// 为批量添加解析 torrent 并生成 add_torrent_params
+bool TorrentManager::prepare_add_params(const AddRequest& request, const TorrentPolicy& policy,
+                                        lt::add_torrent_params& params, TorrentInfo& info, bool& queue_first,
+                                        std::string& error)
+{
+    namespace fs = std::filesystem;
+    
+    try {
+        // 验证路径（与 validate_paths 相同的规则，但不输出，由调用方汇总结果）
+        std::error_code fs_ec;
+        if (!fs::exists(fs::u8path(request.torrent_path), fs_ec)) {
+            error = "Torrent 文件不存在";
+            return false;
+        }
+        if (!fs::exists(fs::u8path(request.save_path), fs_ec)) {
+            if (request.type == TorrentType::Seeding) {
+                error = "保存路径不存在: " + request.save_path;
+                return false;
+            }
+            fs::create_directories(fs::u8path(request.save_path), fs_ec);
+            if (fs_ec) {
+                error = "无法创建保存目录: " + request.save_path + " (" + fs_ec.message() + ")";
+                return false;
+            }
+        } else if (!fs::is_directory(fs::u8path(request.save_path), fs_ec)) {
+            error = "保存路径不是目录: " + request.save_path;
+            return false;
+        }
+        
+        // 解析 torrent 文件
+        lt::error_code ec;
+        auto ti = TorrentFileCache::load_for_session(request.torrent_path, ec);
+        if (ec) {
+            error = "解析 torrent 文件失败: " + ec.message();
+            return false;
+        }
+        
+        // async_add_torrent 使用 rvalue 重载，不会复制 torrent_info：给 session 单独一份，缓存中的共享实例不被修改
+        params = lt::add_torrent_params();
+        params.ti = std::make_shared<lt::torrent_info>(*ti);
+        params.save_path = request.save_path;
+        
+        const std::int64_t torrent_size = ti->total_size();
+        const TorrentClass& torrent_class = policy.classify(*ti);
+        if (request.type == TorrentType::Download) {
+            // 与 start_download 相同：优先恢复数据，其次标记全零分片
+            if (!resume_store_.load(*ti, request.save_path, params)) {
+                ZeroPieceMap::prepare_download(request.torrent_path, *ti, request.save_path, params);
+            }
+            torrent_class.apply(params, false);
+        } else {
+            // 与 start_seeding 相同：优先恢复数据，其次生成 torrent 时写入的快速恢复数据，都没有时由 libtorrent 校验
+            if (!resume_store_.load(*ti, request.save_path, params) &&
+                !SeedResume::load(SeedResume::path_for(request.torrent_path), *ti, request.save_path, params) &&
+                torrent_class.trust_existing_files && TorrentPolicy::data_present(*ti, request.save_path)) {
+                params.flags |= lt::torrent_flags::seed_mode;
+            }
+            torrent_class.apply(params, true);
+        }
+        queue_first = torrent_class.queue_first && torrent_class.auto_managed;
+        
+        info.type = request.type;
+        info.torrent_path = request.torrent_path;
+        info.save_path = request.save_path;
+        info.info_hash = get_info_hash_string(*ti);
+        info.info_hash_v2 = get_info_hash_v2_string(*ti);
+        info.key = TorrentKey::primary(ti->info_hashes());
+        info.key_v2 = TorrentKey::secondary(ti->info_hashes());
+        info.is_valid = true;
+        
+        // 初始状态，首个 state_update_alert 到达后替换
+        info.status.info_hashes = ti->info_hashes();
+        info.status.state = lt::torrent_status::checking_resume_data;
+        info.status.total_wanted = torrent_size;
+        info.status.flags = params.flags;
+        return true;
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+}
+
+// 批量添加 torrent
+std::vector<std::future<AddResult>> TorrentManager::add_torrents_async(const std::vector<AddRequest>& requests,
+                                                                       int parse_threads,
+                                                                       std::function<void(const AddResult&)> on_added)
+{
+    std::vector<std::future<AddResult>> futures;
+    futures.reserve(requests.size());
+    if (requests.empty()) {
+        return futures;
+    }
+    
+    auto callback = on_added ? std::make_shared<std::function<void(const AddResult&)>>(std::move(on_added))
+                             : std::shared_ptr<std::function<void(const AddResult&)>>();
+    
+    // 每个请求对应一个 PendingAdd，解析成功的在提交时移入 pending_adds_
+    std::vector<PendingAdd> adds(requests.size());
+    std::vector<lt::add_torrent_params> params(requests.size());
+    std::vector<char> parsed(requests.size(), 0);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        futures.push_back(adds[i].promise.get_future());
+        adds[i].result.torrent_path = requests[i].torrent_path;
+        adds[i].on_added = callback;
+    }
+    
+    // 并行解析 .torrent 文件（不持有 mutex_），所有请求使用同一份分类策略
+    const TorrentPolicy policy = TorrentPolicy::get_default();
+    if (parse_threads <= 0) {
+        parse_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    parse_threads = std::max(1, std::min(parse_threads, static_cast<int>(requests.size())));
+    std::atomic<size_t> next_index(0);
+    auto parse_worker = [&]() {
+        for (size_t i = next_index.fetch_add(1); i < requests.size(); i = next_index.fetch_add(1)) {
+            parsed[i] = prepare_add_params(requests[i], policy, params[i], adds[i].info, adds[i].queue_first,
+                                           adds[i].result.error) ? 1 : 0;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < parse_threads; ++t) {
+        workers.emplace_back(parse_worker);
+    }
+    parse_worker();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // 提交到 session：async_add_torrent 立即返回，结果由 add_torrent_alert 通知
+    std::vector<PendingAdd> failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < requests.size(); ++i) {
+            PendingAdd& add = adds[i];
+            if (parsed[i]) {
+                add.result.info_hash = add.info.info_hash;
+                const TorrentKey key = add.info.key;
+                if (torrents_.find(key) != nullptr || pending_adds_.count(key) != 0) {
+                    add.result.error = "该 torrent 已存在（info_hash: " + add.info.info_hash + "）";
+                } else {
+                    pending_adds_.emplace(key, std::move(add));
+                    session_->async_add_torrent(std::move(params[i]));
+                    continue;
+                }
+            }
+            failed.push_back(std::move(add));
+        }
+    }
+    
+    for (auto& add : failed) {
+        if (add.on_added) {
+            try {
+                (*add.on_added)(add.result);
+            } catch (const std::exception& e) {
+                std::cerr << "批量添加回调出错: " << e.what() << std::endl;
+            }
+        }
+        add.promise.set_value(std::move(add.result));
+    }
+    return futures;
+}
+
+// 处理 add_torrent_alert
+void TorrentManager::on_torrent_added(const lt::add_torrent_alert& a)
+{
+    const lt::info_hash_t hashes = a.params.ti ? a.params.ti->info_hashes() : a.params.info_hashes;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_adds_.find(TorrentKey::primary(hashes));
+    if (it == pending_adds_.end()) {
+        return;  // 不是批量添加提交的 torrent
+    }
+    PendingAdd add = std::move(it->second);
+    pending_adds_.erase(it);
+    
+    if (a.error) {
+        add.result.error = "添加 torrent 失败: " + a.error.message();
+    } else {
+        if (add.queue_first) {
+            a.handle.queue_position_top();
+        }
+        add.info.handle = a.handle;
+        add.info.status.handle = a.handle;
+        torrents_.insert(std::move(add.info));
+        add.result.ok = true;
+        snapshot_dirty_ = true;
+    }
+    completed_adds_.push_back(std::move(add));
+}
+
+// 一批 alert 处理完成
+void TorrentManager::on_alert_batch()
+{
+    std::vector<PendingAdd> completed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (snapshot_dirty_) {
+            publish_snapshot_unsafe();
+        } else if (!changed_statuses_.empty()) {
+            publish_status_changes_unsafe();
+        }
+        completed.swap(completed_adds_);
+    }
+    if (completed.empty()) {
+        return;
+    }
+    
+    // 新加入的 torrent 需要第一次完整的状态更新
+    session_->post_torrent_updates(lt::status_flags_t{});
+    
+    // 回调和 future 在不持有 mutex_ 时通知，回调中可以调用 TorrentManager 的其他函数
+    for (auto& add : completed) {
+        if (add.on_added) {
+            try {
+                (*add.on_added)(add.result);
+            } catch (const std::exception& e) {
+                std::cerr << "批量添加回调出错: " << e.what() << std::endl;
+            }
+        }
+        add.promise.set_value(std::move(add.result));
+    }
+}
+
+// 用多线程哈希引擎校验本地数据（不经过 session）
+bool TorrentManager::verify_torrent(const std::string& torrent_path, const std::string& save_path,
+                                    VerifyResult& result, int hash_threads, bool direct_io)
+{
+    result = VerifyResult();
+    result.torrent_path = torrent_path;
+    result.save_path = save_path;
+    
+    try {
+        lt::error_code ec;
+        auto ti_ptr = TorrentFileCache::load(torrent_path, ec);
+        if (ec) {
+            std::cerr << "错误: 解析 torrent 文件失败: " << ec.message() << std::endl;
+            return false;
+        }
+        const lt::torrent_info& ti = *ti_ptr;
+        
+        std::cout << "正在校验本地数据: " << save_path << "（" << format_bytes(ti.total_size()) << "，"
+                  << ti.num_pieces() << " 个分片）" << std::endl;
+        
+        PieceHasher hasher(ti.files(), save_path);
+        hasher.set_threads(hash_threads);
+        hasher.set_unbuffered(direct_io);
+        
+        auto start = std::chrono::steady_clock::now();
+        std::vector<bool> piece_ok;
+        result.failed_pieces = hasher.verify(ti, piece_ok);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        result.info_hashes = ti.info_hashes();
+        result.num_pieces = ti.num_pieces();
+        result.piece_ok = std::move(piece_ok);
+        for (int p = 0; p < result.num_pieces; ++p) {
+            if (result.piece_ok[p]) continue;
+            if (hasher.is_unreadable(lt::piece_index_t(p))) {
+                result.unreadable_pieces.push_back(p);
+            } else {
+                result.mismatched_pieces.push_back(p);
+            }
+        }
+        result.is_valid = true;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "校验本地数据时出错: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void TorrentManager::print_verify_report(const VerifyResult& result, int max_listed)
+{
+    if (!result.is_valid) {
+        std::cout << "校验未完成: " << result.torrent_path << std::endl;
+        return;
+    }
+    
+    char line[160];
+    snprintf(line, sizeof(line), "分片总数: %d，校验通过: %d，哈希不匹配: %d，无法读取: %d（用时 %.1f 秒）",
+             result.num_pieces, result.num_pieces - result.failed_pieces,
+             static_cast<int>(result.mismatched_pieces.size()), static_cast<int>(result.unreadable_pieces.size()),
+             result.seconds);
+    std::cout << line << std::endl;
+    if (result.failed_pieces == 0) {
+        return;
+    }
+    
+    // 列出未通过校验的分片及其涉及的文件
+    lt::error_code ec;
+    auto ti = TorrentFileCache::load(result.torrent_path, ec);
+    std::vector<int> failed;
+    std::merge(result.mismatched_pieces.begin(), result.mismatched_pieces.end(),
+               result.unreadable_pieces.begin(), result.unreadable_pieces.end(), std::back_inserter(failed));
+    int shown = 0;
+    for (int p : failed) {
+        if (shown >= max_listed) break;
+        const bool unreadable = std::binary_search(result.unreadable_pieces.begin(), result.unreadable_pieces.end(), p);
+        std::cout << "  分片 " << p << (unreadable ? " 无法读取" : " 哈希不匹配");
+        if (!ec && p < ti->num_pieces()) {
+            const lt::file_storage& files = ti->files();
+            const char* separator = ": ";
+            lt::piece_index_t piece(p);
+            for (const auto& slice : files.map_block(piece, 0, ti->piece_size(piece))) {
+                if (files.pad_file_at(slice.file_index)) continue;
+                std::cout << separator << files.file_path(slice.file_index);
+                separator = ", ";
+            }
+        }
+        std::cout << std::endl;
+        ++shown;
+    }
+    if (result.failed_pieces > shown) {
+        std::cout << "  ... 另有 " << (result.failed_pieces - shown) << " 个分片未通过校验" << std::endl;
+    }
+}
+
+bool TorrentManager::write_piece_bitfield(const VerifyResult& result, const std::string& output_path)
+{
+    std::ofstream out(std::filesystem::u8path(output_path), std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "错误: 无法写入分片位图: " << output_path << std::endl;
+        return false;
+    }
+    std::string bits(result.piece_ok.size(), '0');
+    for (size_t p = 0; p < result.piece_ok.size(); ++p) {
+        if (result.piece_ok[p]) bits[p] = '1';
+    }
+    out << bits << "\n";
+    return static_cast<bool>(out);
+}
+
 // 停止指定的 torrent
 bool TorrentManager::stop_torrent(const std::string& info_hash)
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = torrents_.find(info_hash);
-    if (it == torrents_.end()) {
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr) {
         std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
         return false;
     }
     
+    const TorrentKey key = found->key;
     try {
-        TorrentInfo& info = it->second;
+        TorrentInfo& info = *found;
         if (info.handle.is_valid()) {
+            // 主动停止的 torrent 不再需要恢复数据
+            resume_store_.remove(info.handle.info_hashes());
+            
             // 根据类型决定是否删除文件
             // 下载时只删除部分文件，做种时不删除文件
             if (info.type == TorrentType::Seeding) {
@@ -501,13 +913,15 @@ bool TorrentManager::stop_torrent(const std::string& info_hash)
             }
         }
         
-        torrents_.erase(it);
+        forget_torrent_unsafe(key);
+        publish_snapshot_unsafe();
         
         std::cout << "已停止 torrent (info_hash: " << info_hash.substr(0, 8) << "...)" << std::endl;
         return true;
     } catch (const std::exception& e) {
         std::cerr << "停止 torrent 时出错: " << e.what() << std::endl;
-        torrents_.erase(it);
+        forget_torrent_unsafe(key);
+        publish_snapshot_unsafe();
         return false;
     }
 }
@@ -522,8 +936,7 @@ void TorrentManager::stop_all()
     }
     
     try {
-        for (auto& pair : torrents_) {
-            TorrentInfo& info = pair.second;
+        for (auto& info : torrents_) {
             if (info.handle.is_valid()) {
                 // 根据类型决定是否删除文件
                 if (info.type == TorrentType::Seeding) {
@@ -534,11 +947,13 @@ void TorrentManager::stop_all()
             }
         }
         
-        torrents_.clear();
+        forget_all_unsafe();
+        publish_snapshot_unsafe();
         std::cout << "已停止所有 torrent" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "停止所有 torrent 时出错: " << e.what() << std::endl;
-        torrents_.clear();
+        forget_all_unsafe();
+        publish_snapshot_unsafe();
     }
 }
 
@@ -547,26 +962,22 @@ void TorrentManager::stop_all_downloads()
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    std::vector<std::string> to_remove;
-    
-    for (const auto& pair : torrents_) {
-        if (pair.second.type == TorrentType::Download) {
-            to_remove.push_back(pair.first);
-        }
-    }
+    std::vector<TorrentKey> to_remove;
     
-    for (const auto& info_hash : to_remove) {
-        auto it = torrents_.find(info_hash);
-        if (it != torrents_.end() && it->second.handle.is_valid()) {
-            session_->remove_torrent(it->second.handle, lt::session::delete_partfile);
+    for (std::uint32_t index : torrents_.indices(TorrentType::Download)) {
+        const TorrentInfo& info = torrents_.at(index);
+        if (info.handle.is_valid()) {
+            session_->remove_torrent(info.handle, lt::session::delete_partfile);
         }
+        to_remove.push_back(info.key);
     }
     
-    for (const auto& info_hash : to_remove) {
-        torrents_.erase(info_hash);
+    for (const auto& key : to_remove) {
+        forget_torrent_unsafe(key);
     }
     
     if (!to_remove.empty()) {
+        publish_snapshot_unsafe();
         std::cout << "已停止所有下载任务" << std::endl;
     }
 }
@@ -576,26 +987,22 @@ void TorrentManager::stop_all_seedings()
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    std::vector<std::string> to_remove;
-    
-    for (const auto& pair : torrents_) {
-        if (pair.second.type == TorrentType::Seeding) {
-            to_remove.push_back(pair.first);
-        }
-    }
+    std::vector<TorrentKey> to_remove;
     
-    for (const auto& info_hash : to_remove) {
-        auto it = torrents_.find(info_hash);
-        if (it != torrents_.end() && it->second.handle.is_valid()) {
-            session_->remove_torrent(it->second.handle, lt::session::delete_files);
+    for (std::uint32_t index : torrents_.indices(TorrentType::Seeding)) {
+        const TorrentInfo& info = torrents_.at(index);
+        if (info.handle.is_valid()) {
+            session_->remove_torrent(info.handle, lt::session::delete_files);
         }
+        to_remove.push_back(info.key);
     }
     
-    for (const auto& info_hash : to_remove) {
-        torrents_.erase(info_hash);
+    for (const auto& key : to_remove) {
+        forget_torrent_unsafe(key);
     }
     
     if (!to_remove.empty()) {
+        publish_snapshot_unsafe();
         std::cout << "已停止所有做种任务" << std::endl;
     }
 }
@@ -605,14 +1012,14 @@ bool TorrentManager::pause_torrent(const std::string& info_hash)
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = torrents_.find(info_hash);
-    if (it == torrents_.end() || !it->second.handle.is_valid()) {
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr || !found->handle.is_valid()) {
         std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
         return false;
     }
     
     try {
-        it->second.handle.pause();
+        found->handle.pause();
         std::cout << "已暂停 torrent (info_hash: " << info_hash.substr(0, 8) << "...)" << std::endl;
         return true;
     } catch (const std::exception& e) {
@@ -626,14 +1033,14 @@ bool TorrentManager::resume_torrent(const std::string& info_hash)
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = torrents_.find(info_hash);
-    if (it == torrents_.end() || !it->second.handle.is_valid()) {
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr || !found->handle.is_valid()) {
         std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
         return false;
     }
     
     try {
-        it->second.handle.resume();
+        found->handle.resume();
         std::cout << "已恢复 torrent (info_hash: " << info_hash.substr(0, 8) << "...)" << std::endl;
         return true;
     } catch (const std::exception& e) {
@@ -647,10 +1054,10 @@ void TorrentManager::pause_all()
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    for (auto& pair : torrents_) {
-        if (pair.second.handle.is_valid()) {
+    for (auto& info : torrents_) {
+        if (info.handle.is_valid()) {
             try {
-                pair.second.handle.pause();
+                info.handle.pause();
             } catch (...) {
                 // 忽略单个 torrent 的错误
             }
@@ -665,10 +1072,10 @@ void TorrentManager::resume_all()
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    for (auto& pair : torrents_) {
-        if (pair.second.handle.is_valid()) {
+    for (auto& info : torrents_) {
+        if (info.handle.is_valid()) {
             try {
-                pair.second.handle.resume();
+                info.handle.resume();
             } catch (...) {
                 // 忽略单个 torrent 的错误
             }
@@ -684,6 +1091,7 @@ TorrentStatus TorrentManager::create_torrent_status(const TorrentInfo& info, con
     TorrentStatus ts;
     
     ts.info_hash = info.info_hash;
+    ts.info_hash_v2 = info.info_hash_v2;
     ts.type = info.type;
     ts.torrent_path = info.torrent_path;
     ts.save_path = info.save_path;
@@ -710,127 +1118,170 @@ TorrentStatus TorrentManager::create_torrent_status(const TorrentInfo& info, con
     return ts;
 }
 
-// 获取指定 torrent 的状态
-TorrentStatus TorrentManager::get_torrent_status(const std::string& info_hash) const
+// 按 info_hash 查找快照中的 torrent
+const TorrentStatus* TorrentSnapshot::find(const std::string& info_hash) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    TorrentStatus ts;
-    
-    auto it = torrents_.find(info_hash);
-    if (it == torrents_.end() || !it->second.handle.is_valid()) {
-        return ts;
+    TorrentKey key;
+    if (!TorrentKey::from_hex(info_hash, key)) {
+        return nullptr;
+    }
+    return find(key);
+}
+
+const TorrentStatus* TorrentSnapshot::find(const TorrentKey& key) const
+{
+    auto it = torrents.find(key);
+    if (it != torrents.end()) {
+        return it->second.get();
+    }
+    auto alias = v2_aliases.find(key);
+    if (alias != v2_aliases.end()) {
+        it = torrents.find(alias->second);
+        if (it != torrents.end()) {
+            return it->second.get();
+        }
+    }
+    return nullptr;
+}
+
+// 发布新的快照
+void TorrentManager::publish_snapshot_unsafe()
+{
+    auto snapshot = std::make_shared<TorrentSnapshot>();
+    snapshot->version = snapshot_version_.load(std::memory_order_relaxed) + 1;
+    for (const auto& info : torrents_) {
+        snapshot->torrents.emplace(info.key, std::make_shared<const TorrentStatus>(create_torrent_status(info, info.status)));
+        if (!info.key_v2.empty()) {
+            snapshot->v2_aliases.emplace(info.key_v2, info.key);
+        }
+        if (info.type == TorrentType::Download) {
+            snapshot->download_count++;
+        } else {
+            snapshot->seeding_count++;
+        }
     }
     
-    try {
-        const TorrentInfo& info = it->second;
-        lt::torrent_status status = info.handle.status();
-        ts = create_torrent_status(info, status);
-    } catch (const std::exception&) {
-        // 返回默认状态
+    std::atomic_store(&snapshot_, std::shared_ptr<const TorrentSnapshot>(std::move(snapshot)));
+    snapshot_version_.fetch_add(1, std::memory_order_release);
+    snapshot_dirty_ = false;
+    changed_statuses_.clear();
+}
+
+// 发布状态变化
+void TorrentManager::publish_status_changes_unsafe()
+{
+    // 复制上一个快照只复制条目指针，TorrentStatus 只为有变化的 torrent 重新创建
+    // torrent 的增删和类型变化都通过 publish_snapshot_unsafe 发布，计数和 v2 别名不变
+    auto snapshot = std::make_shared<TorrentSnapshot>(*std::atomic_load(&snapshot_));
+    snapshot->version = snapshot_version_.load(std::memory_order_relaxed) + 1;
+    for (const TorrentKey& key : changed_statuses_) {
+        const TorrentInfo* info = torrents_.find(key);
+        if (info == nullptr) {
+            continue;
+        }
+        auto it = snapshot->torrents.find(key);
+        if (it != snapshot->torrents.end()) {
+            it->second = std::make_shared<const TorrentStatus>(create_torrent_status(*info, info->status));
+        }
     }
+    changed_statuses_.clear();
     
-    return ts;
+    std::atomic_store(&snapshot_, std::shared_ptr<const TorrentSnapshot>(std::move(snapshot)));
+    snapshot_version_.fetch_add(1, std::memory_order_release);
+}
+
+// 读取当前快照
+const TorrentSnapshot& TorrentManager::current_snapshot() const
+{
+    // 读线程只读取共享的版本号；std::atomic_load 和引用计数只在快照变化后的第一次读取时发生，
+    // 避免所有读线程争用同一个 shared_ptr 控制块
+    struct Cache {
+        std::uint64_t version = 0;
+        std::shared_ptr<const TorrentSnapshot> snapshot;
+    };
+    static thread_local Cache cache;
+    
+    std::uint64_t version = snapshot_version_.load(std::memory_order_acquire);
+    if (!cache.snapshot || cache.version != version) {
+        cache.snapshot = std::atomic_load(&snapshot_);
+        cache.version = cache.snapshot->version;
+    }
+    return *cache.snapshot;
+}
+
+std::shared_ptr<const TorrentSnapshot> TorrentManager::snapshot() const
+{
+    return std::atomic_load(&snapshot_);
+}
+
+// 获取指定 torrent 的状态
+TorrentStatus TorrentManager::get_torrent_status(const std::string& info_hash) const
+{
+    const TorrentStatus* status = current_snapshot().find(info_hash);
+    if (status == nullptr || !status->is_valid) {
+        return TorrentStatus();
+    }
+    return *status;
 }
 
 // 获取所有 torrent 的状态
 std::vector<TorrentStatus> TorrentManager::get_all_torrent_status() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     std::vector<TorrentStatus> result;
-    
-    for (const auto& pair : torrents_) {
-        const TorrentInfo& info = pair.second;
-        if (!info.handle.is_valid()) {
-            continue;
-        }
-        
-        try {
-            lt::torrent_status status = info.handle.status();
-            result.push_back(create_torrent_status(info, status));
-        } catch (const std::exception&) {
-            // 跳过无效的 torrent
+    for (const auto& pair : current_snapshot().torrents) {
+        if (pair.second->is_valid) {
+            result.push_back(*pair.second);
         }
     }
-    
     return result;
 }
 
 // 获取所有下载任务的状态
 std::vector<TorrentStatus> TorrentManager::get_download_status() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     std::vector<TorrentStatus> result;
-    
-    for (const auto& pair : torrents_) {
-        const TorrentInfo& info = pair.second;
-        if (info.type != TorrentType::Download || !info.handle.is_valid()) {
-            continue;
-        }
-        
-        try {
-            lt::torrent_status status = info.handle.status();
-            result.push_back(create_torrent_status(info, status));
-        } catch (const std::exception&) {
-            // 跳过无效的 torrent
+    for (const auto& pair : current_snapshot().torrents) {
+        if (pair.second->type == TorrentType::Download && pair.second->is_valid) {
+            result.push_back(*pair.second);
         }
     }
-    
     return result;
 }
 
 // 获取所有做种任务的状态
 std::vector<TorrentStatus> TorrentManager::get_seeding_status() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     std::vector<TorrentStatus> result;
-    
-    for (const auto& pair : torrents_) {
-        const TorrentInfo& info = pair.second;
-        if (info.type != TorrentType::Seeding || !info.handle.is_valid()) {
-            continue;
-        }
-        
-        try {
-            lt::torrent_status status = info.handle.status();
-            result.push_back(create_torrent_status(info, status));
-        } catch (const std::exception&) {
-            // 跳过无效的 torrent
+    for (const auto& pair : current_snapshot().torrents) {
+        if (pair.second->type == TorrentType::Seeding && pair.second->is_valid) {
+            result.push_back(*pair.second);
         }
     }
-    
     return result;
 }
 
 // 检查指定 torrent 是否存在
 bool TorrentManager::has_torrent(const std::string& info_hash) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return torrents_.find(info_hash) != torrents_.end();
+    return current_snapshot().find(info_hash) != nullptr;
 }
 
 // 获取 torrent 数量
 size_t TorrentManager::get_torrent_count() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return get_torrent_count_unsafe();
+    return current_snapshot().torrents.size();
 }
 
 // 获取下载任务数量
 size_t TorrentManager::get_download_count() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return get_download_count_unsafe();
+    return current_snapshot().download_count;
 }
 
 // 获取做种任务数量
 size_t TorrentManager::get_seeding_count() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return get_seeding_count_unsafe();
+    return current_snapshot().seeding_count;
 }
 
 // 无锁版本计数函数（仅在已持有 mutex_ 时调用）
@@ -841,39 +1292,31 @@ size_t TorrentManager::get_torrent_count_unsafe() const
 
 size_t TorrentManager::get_download_count_unsafe() const
 {
-    size_t count = 0;
-    for (const auto& pair : torrents_) {
-        if (pair.second.type == TorrentType::Download) {
-            count++;
-        }
-    }
-    return count;
+    return torrents_.count(TorrentType::Download);
 }
 
 size_t TorrentManager::get_seeding_count_unsafe() const
 {
-    size_t count = 0;
-    for (const auto& pair : torrents_) {
-        if (pair.second.type == TorrentType::Seeding) {
-            count++;
-        }
-    }
-    return count;
+    return torrents_.count(TorrentType::Seeding);
 }
 
 // 更新 torrent 状态（清理无效的 torrent）
 void TorrentManager::update_torrents()
 {
-    std::vector<std::string> to_remove;
+    std::vector<TorrentKey> to_remove;
     
-    for (const auto& pair : torrents_) {
-        if (!pair.second.handle.is_valid()) {
-            to_remove.push_back(pair.first);
+    for (const auto& info : torrents_) {
+        if (!info.handle.is_valid()) {
+            to_remove.push_back(info.key);
         }
     }
     
-    for (const auto& info_hash : to_remove) {
-        torrents_.erase(info_hash);
+    for (const auto& key : to_remove) {
+        forget_torrent_unsafe(key);
+    }
+    
+    if (!to_remove.empty()) {
+        publish_snapshot_unsafe();
     }
 }
 
@@ -885,95 +1328,26 @@ bool TorrentManager::wait_and_process(int timeout_ms)
     }
     
     try {
-        // 处理 alerts
-        std::vector<lt::alert*> alerts;
-        session_->pop_alerts(&alerts);
-        
-        for (lt::alert* alert : alerts) {
-            if (lt::alert_cast<lt::torrent_finished_alert>(alert)) {
-                auto* tfa = lt::alert_cast<lt::torrent_finished_alert>(alert);
-                if (tfa) {
-                    std::cout << std::endl;
-                    std::cout << "=== Torrent 完成！===" << std::endl;
-                    std::cout << std::endl;
-                }
-            } else if (lt::alert_cast<lt::tracker_announce_alert>(alert)) {
-                // Tracker 公告信息（静默处理）
-            } else if (lt::alert_cast<lt::tracker_error_alert>(alert)) {
-                // Tracker 错误（静默处理，不再输出详细信息）
-                // 如果需要调试，可以取消下面的注释
-                // auto* tea = lt::alert_cast<lt::tracker_error_alert>(alert);
-                // if (tea) {
-                //     std::cerr << "Tracker 错误 [" << tea->tracker_url() << "]: " 
-                //               << tea->error.message() << std::endl;
-                // }
-            } else if (lt::alert_cast<lt::tracker_reply_alert>(alert)) {
-                // Tracker 回复（静默处理）
-                // 如果需要调试，可以取消下面的注释
-                // auto* tra = lt::alert_cast<lt::tracker_reply_alert>(alert);
-                // if (tra) {
-                //     std::cout << "Tracker: 发现 " << tra->num_peers << " 个 peers" << std::endl;
-                // }
-            } else if (lt::alert_cast<lt::torrent_error_alert>(alert)) {
-                auto* tea = lt::alert_cast<lt::torrent_error_alert>(alert);
-                if (tea) {
-                    std::cerr << "Torrent 错误: " << tea->error.message() << std::endl;
-                }
-            } else if (lt::alert_cast<lt::file_error_alert>(alert)) {
-                auto* fea = lt::alert_cast<lt::file_error_alert>(alert);
-                if (fea) {
-                    std::cerr << "文件错误: " << fea->error.message() << std::endl;
-                    std::cerr << "  文件路径: " << fea->filename() << std::endl;
-                }
-            } else if (lt::alert_cast<lt::state_changed_alert>(alert)) {
-                auto* sca = lt::alert_cast<lt::state_changed_alert>(alert);
-                if (sca) {
-                    // 状态改变时的处理
-                    const char* state_name = "未知状态";
-                    switch (sca->state) {
-                        case lt::torrent_status::checking_files:
-                            state_name = "检查文件中";
-                            break;
-                        case lt::torrent_status::downloading_metadata:
-                            state_name = "下载元数据";
-                            break;
-                        case lt::torrent_status::downloading:
-                            state_name = "下载中";
-                            break;
-                        case lt::torrent_status::finished:
-                            state_name = "已完成";
-                            break;
-                        case lt::torrent_status::seeding:
-                            state_name = "做种中";
-                            break;
-                        case lt::torrent_status::allocating:
-                            state_name = "分配空间中";
-                            break;
-                        default:
-                            state_name = "其他状态";
-                            break;
-                    }
-                    std::cout << "状态改变: " << state_name << std::endl;
-                }
-            } else if (lt::alert_cast<lt::peer_connect_alert>(alert)) {
-                // Peer 连接（可选：调试用）
-                // auto* pca = lt::alert_cast<lt::peer_connect_alert>(alert);
-                // if (pca) {
-                //     std::cout << "Peer 连接: " << pca->endpoint.address().to_string() << std::endl;
-                // }
-            }
+        // 请求状态更新：libtorrent 只返回自上次请求以来有变化的 torrent（state_update_alert），由分发线程合并到缓存
+        session_->post_torrent_updates(lt::status_flags_t{});
+        
+        // 定期保存有变化的 torrent 的恢复数据
+        if (resume_interval_ > 0 && resume_store_.enabled() &&
+            std::chrono::steady_clock::now() - last_resume_save_ >= std::chrono::seconds(resume_interval_)) {
+            save_all_resume_data();
+            last_resume_save_ = std::chrono::steady_clock::now();
         }
         
         // 对于下载任务，定期检查并确保下载没有被意外暂停
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            for (auto& pair : torrents_) {
-                TorrentInfo& info = pair.second;
-                if (info.type == TorrentType::Download && info.handle.is_valid()) {
+            for (std::uint32_t index : torrents_.indices(TorrentType::Download)) {
+                TorrentInfo& info = torrents_.at(index);
+                if (info.handle.is_valid()) {
                     try {
-                        lt::torrent_status status = info.handle.status();
+                        const lt::torrent_status& status = info.status;
                         
-                        // 如果不在检查文件状态且被暂停了，强制恢复
+                        // 如果不在检查文件状态且被暂停了，强制恢复（状态来自缓存）
                         if (status.state != lt::torrent_status::checking_files &&
                             status.state != lt::torrent_status::checking_resume_data &&
                             (status.flags & lt::torrent_flags::paused)) {
@@ -989,8 +1363,12 @@ bool TorrentManager::wait_and_process(int timeout_ms)
             update_torrents();
         }
         
-        // 等待指定时间
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        // 等待下一个事件（完成、出错、状态变化）或超时；alert 已由分发线程处理
+        {
+            std::unique_lock<std::mutex> lock(event_mutex_);
+            event_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return event_pending_; });
+            event_pending_ = false;
+        }
         
         return true;
     } catch (const std::exception& e) {
@@ -999,6 +1377,212 @@ bool TorrentManager::wait_and_process(int timeout_ms)
     }
 }
 
+void TorrentManager::register_alert_handlers()
+{
+    AlertDispatcher& dispatcher = *alert_dispatcher_;
+    
+    dispatcher.subscribe<lt::torrent_finished_alert>([this](const lt::torrent_finished_alert& a) {
+        std::cout << std::endl;
+        std::cout << "=== Torrent 完成！===" << std::endl;
+        std::cout << std::endl;
+        // 下载完成时立即保存恢复数据，不等待下一次定期保存
+        if (resume_store_.enabled()) {
+            a.handle.save_resume_data(lt::torrent_handle::only_if_modified);
+        }
+        notify_event();
+    });
+    
+    dispatcher.subscribe<lt::torrent_error_alert>([this](const lt::torrent_error_alert& a) {
+        std::cerr << "Torrent 错误: " << a.error.message() << std::endl;
+        notify_event();
+    });
+    
+    dispatcher.subscribe<lt::file_error_alert>([this](const lt::file_error_alert& a) {
+        std::cerr << "文件错误: " << a.error.message() << std::endl;
+        std::cerr << "  文件路径: " << a.filename() << std::endl;
+        notify_event();
+    });
+    
+    dispatcher.subscribe<lt::state_changed_alert>([this](const lt::state_changed_alert& a) {
+        const char* state_name = "未知状态";
+        switch (a.state) {
+            case lt::torrent_status::checking_files:
+                state_name = "检查文件中";
+                break;
+            case lt::torrent_status::downloading_metadata:
+                state_name = "下载元数据";
+                break;
+            case lt::torrent_status::downloading:
+                state_name = "下载中";
+                break;
+            case lt::torrent_status::finished:
+                state_name = "已完成";
+                break;
+            case lt::torrent_status::seeding:
+                state_name = "做种中";
+                break;
+            case lt::torrent_status::allocating:
+                state_name = "分配空间中";
+                break;
+            default:
+                state_name = "其他状态";
+                break;
+        }
+        std::cout << "状态改变: " << state_name << std::endl;
+        
+        // 校验结束时保存恢复数据
+        if (resume_store_.enabled() &&
+            (a.prev_state == lt::torrent_status::checking_files ||
+             a.prev_state == lt::torrent_status::checking_resume_data)) {
+            a.handle.save_resume_data(lt::torrent_handle::only_if_modified);
+        }
+        notify_event();
+    });
+    
+    dispatcher.subscribe<lt::torrent_paused_alert>([this](const lt::torrent_paused_alert& a) {
+        if (resume_store_.enabled()) {
+            a.handle.save_resume_data(lt::torrent_handle::only_if_modified);
+        }
+    });
+    
+    // 恢复数据的编码和写入在后台线程进行，这里只复制参数
+    // 已停止的 torrent 不再保存：stop_torrent 删除恢复数据后才到达的 alert（停止前发起的定期保存或暂停保存）会重新创建文件
+    // 检查和排队都在 mutex_ 内完成，stop_torrent 要么先删除（这里丢弃），要么在之后的 remove 中清除队列里的数据
+    dispatcher.subscribe<lt::save_resume_data_alert>([this](const lt::save_resume_data_alert& a) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const TorrentInfo* info = torrents_.find(TorrentKey::primary(a.params.info_hashes));
+            if (info != nullptr && info->handle == a.handle) {
+                resume_store_.save_async(a.params);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(event_mutex_);
+            ++resume_replies_;
+        }
+        event_cv_.notify_all();
+    });
+    
+    // 没有变化（only_if_modified）或 torrent 已移除，只计数
+    dispatcher.subscribe<lt::save_resume_data_failed_alert>([this](const lt::save_resume_data_failed_alert&) {
+        {
+            std::lock_guard<std::mutex> lock(event_mutex_);
+            ++resume_replies_;
+        }
+        event_cv_.notify_all();
+    });
+    
+    // 合并状态更新：只包含有变化的 torrent（快照在本批 alert 处理完后统一发布）
+    dispatcher.subscribe<lt::state_update_alert>([this](const lt::state_update_alert& a) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const lt::torrent_status& status : a.status) {
+            TorrentInfo* info = torrents_.find(TorrentKey::primary(status.info_hashes));
+            if (info != nullptr && info->handle == status.handle) {
+                info->status = status;
+                changed_statuses_.push_back(info->key);
+            }
+        }
+    });
+    
+    // 流式读取：记录窗口所需的分片是否已下载（没有流式读取的 torrent 时直接返回）
+    // read 正在等待该分片时立即读取
+    dispatcher.subscribe<lt::piece_finished_alert>([this](const lt::piece_finished_alert& a) {
+        piece_reader_.on_piece_finished(a);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (streams_.empty()) {
+            return;
+        }
+        auto it = streams_.find(TorrentKey::primary(a.handle.info_hashes()));
+        if (it == streams_.end() || it->second.handle != a.handle) {
+            return;
+        }
+        const int piece = static_cast<int>(a.piece_index);
+        if (piece >= 0 && piece < static_cast<int>(it->second.have.size())) {
+            it->second.have[piece] = true;
+        }
+    });
+    
+    // read 请求的分片数据
+    dispatcher.subscribe<lt::read_piece_alert>([this](const lt::read_piece_alert& a) {
+        piece_reader_.on_read_piece(a);
+    });
+    
+    // 批量添加的结果
+    dispatcher.subscribe<lt::add_torrent_alert>([this](const lt::add_torrent_alert& a) {
+        on_torrent_added(a);
+    });
+    
+    dispatcher.set_batch_handler([this] {
+        on_alert_batch();
+    });
+    
+    dispatcher.subscribe<lt::listen_succeeded_alert>([this](const lt::listen_succeeded_alert& a) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listen_endpoints_.push_back(a.address.to_string() + ":" + std::to_string(a.port));
+    });
+}
+
+void TorrentManager::notify_event()
+{
+    {
+        std::lock_guard<std::mutex> lock(event_mutex_);
+        event_pending_ = true;
+    }
+    event_cv_.notify_all();
+}
+
+void TorrentManager::unsubscribe_alert(int id)
+{
+    alert_dispatcher_->unsubscribe(id);
+}
+
+void TorrentManager::set_state_dir(const std::string& state_dir)
+{
+    resume_store_.set_state_dir(state_dir);
+}
+
+void TorrentManager::save_all_resume_data()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& info : torrents_) {
+        if (info.handle.is_valid()) {
+            info.handle.save_resume_data(lt::torrent_handle::only_if_modified);
+        }
+    }
+}
+
+void TorrentManager::flush_resume_data(int timeout_ms)
+{
+    if (!alert_dispatcher_ || !resume_store_.enabled()) {
+        return;
+    }
+    
+    int expected = 0;
+    {
+        std::lock_guard<std::mutex> lock(event_mutex_);
+        expected = resume_replies_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& info : torrents_) {
+            if (info.handle.is_valid()) {
+                info.handle.save_resume_data(lt::torrent_handle::flush_disk_cache);
+                ++expected;
+            }
+        }
+    }
+    
+    // 等待分发线程收到每个 torrent 的恢复数据（或保存失败）
+    {
+        std::unique_lock<std::mutex> lock(event_mutex_);
+        if (!event_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                [&] { return resume_replies_ >= expected; })) {
+            std::cerr << "警告: " << (expected - resume_replies_) << " 个 torrent 的恢复数据未能在退出前保存" << std::endl;
+        }
+    }
+    resume_store_.flush();
+}
+
 // 打印所有 torrent 的状态
 void TorrentManager::print_all_status() const
 {
@@ -1015,9 +1599,8 @@ void TorrentManager::print_all_status() const
     std::cout << std::endl;
     
     int index = 0;
-    for (const auto& pair : torrents_) {
+    for (const auto& info : torrents_) {
         ++index;
-        const TorrentInfo& info = pair.second;
         
         if (!info.handle.is_valid()) {
             std::cout << "[Torrent #" << index << "] 句柄无效" << std::endl;
@@ -1025,7 +1608,7 @@ void TorrentManager::print_all_status() const
         }
         
         try {
-            lt::torrent_status status = info.handle.status();
+            const lt::torrent_status& status = info.status;
             
             std::cout << "--- Torrent #" << index << " ---" << std::endl;
             std::cout << "Info Hash: " << info.info_hash.substr(0, 16) << "..." << std::endl;
@@ -1064,16 +1647,11 @@ void TorrentManager::print_all_status() const
             std::cout << "下载速度: " << format_speed(status.download_rate) << std::endl;
             std::cout << "是否暂停: " << (status.flags & lt::torrent_flags::paused ? "是" : "否") << std::endl;
             
-            // 显示 tracker 简要状态
-            std::vector<lt::announce_entry> trackers = info.handle.trackers();
-            if (!trackers.empty()) {
-                int working = 0;
-                for (const auto& t : trackers) {
-                    if (t.is_working()) working++;
-                }
-                std::cout << "Tracker: " << working << "/" << trackers.size() << " 工作正常" << std::endl;
+            // 显示 tracker 简要状态（当前使用的 tracker，来自缓存的状态）
+            if (!status.current_tracker.empty()) {
+                std::cout << "Tracker: " << status.current_tracker << std::endl;
             } else {
-                std::cout << "Tracker: 无 (仅使用 DHT/LSD)" << std::endl;
+                std::cout << "Tracker: 无可用 tracker (仅使用 DHT/LSD)" << std::endl;
             }
             
             std::cout << std::endl;
@@ -1121,6 +1699,13 @@ void TorrentManager::print_torrent_status(const std::string& info_hash) const
     std::cout << "下载速度: " << format_speed(ts.download_rate) << std::endl;
     std::cout << "是否暂停: " << (ts.is_paused ? "是" : "否") << std::endl;
     std::cout << "是否完成: " << (ts.is_finished ? "是" : "否") << std::endl;
+    
+    StreamStatus stream = get_stream_status(info_hash);
+    if (stream.active) {
+        std::cout << "流式读取: 位置 " << format_bytes(stream.position)
+                  << "，连续可读 " << format_bytes(stream.ready_bytes)
+                  << "，窗口缺少 " << stream.missing_pieces << " / " << stream.window_pieces << " 个分片" << std::endl;
+    }
     std::cout << std::endl;
 }
 
@@ -1129,8 +1714,8 @@ bool TorrentManager::add_peer(const std::string& info_hash, const std::string& i
 {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = torrents_.find(info_hash);
-    if (it == torrents_.end() || !it->second.handle.is_valid()) {
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr || !found->handle.is_valid()) {
         std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
         return false;
     }
@@ -1148,7 +1733,7 @@ bool TorrentManager::add_peer(const std::string& info_hash, const std::string& i
         lt::tcp::endpoint endpoint(addr, static_cast<unsigned short>(port));
         
         // 添加 peer
-        it->second.handle.connect_peer(endpoint);
+        found->handle.connect_peer(endpoint);
         
         std::cout << "已添加 peer: " << ip << ":" << port << std::endl;
         return true;
@@ -1158,6 +1743,371 @@ bool TorrentManager::add_peer(const std::string& info_hash, const std::string& i
     }
 }
 
+// 开始流式读取
+bool TorrentManager::start_stream(const std::string& info_hash, std::int64_t window_bytes, int deadline_step_ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr || !found->handle.is_valid()) {
+        std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
+        return false;
+    }
+    
+    try {
+        std::shared_ptr<const lt::torrent_info> ti = found->handle.torrent_file();
+        if (!ti || ti->num_pieces() == 0) {
+            std::cerr << "错误: torrent 元数据尚未就绪，无法开始流式读取" << std::endl;
+            return false;
+        }
+        
+        // 先取得已拥有的分片，之后由 piece_finished_alert 更新（分发线程在 mutex_ 释放后才能处理新的分片）
+        const lt::torrent_status status = found->handle.status(lt::torrent_handle::query_pieces);
+        
+        StreamState stream;
+        stream.handle = found->handle;
+        stream.piece_length = ti->piece_length();
+        stream.num_pieces = ti->num_pieces();
+        stream.total_size = ti->total_size();
+        stream.position = 0;
+        stream.window_bytes = std::max<std::int64_t>(window_bytes, stream.piece_length);
+        stream.deadline_step_ms = std::max(0, deadline_step_ms);
+        stream.first_piece = 0;
+        stream.end_piece = 0;
+        auto previous = streams_.find(found->key);
+        if (previous != streams_.end() && previous->second.handle == found->handle) {
+            // 重新开始：沿用之前的窗口范围，新窗口之外的分片在下面取消截止时间
+            stream.first_piece = previous->second.first_piece;
+            stream.end_piece = previous->second.end_piece;
+        }
+        stream.have.assign(stream.num_pieces, false);
+        const int known = std::min(stream.num_pieces, status.pieces.size());
+        for (int p = 0; p < known; ++p) {
+            stream.have[p] = status.pieces.get_bit(lt::piece_index_t(p));
+        }
+        
+        // 窗口之外的分片按稀有优先下载，不使用顺序下载（预取配置设置的截止时间保留）
+        found->handle.unset_flags(lt::torrent_flags::sequential_download);
+        
+        StreamState& slot = streams_[found->key];
+        slot = std::move(stream);
+        update_stream_window_unsafe(slot, true);
+        
+        std::cout << "已开始流式读取 (info_hash: " << info_hash.substr(0, 8) << "...)，窗口 "
+                  << format_bytes(slot.window_bytes) << "（" << (slot.end_piece - slot.first_piece) << " 个分片）" << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "开始流式读取时出错: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// 更新读取位置
+bool TorrentManager::set_stream_position(const std::string& info_hash, std::int64_t offset)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    StreamState* stream = find_stream_unsafe(info_hash);
+    if (stream == nullptr) {
+        std::cerr << "错误: 该 torrent 未开始流式读取 (info_hash: " << info_hash << ")" << std::endl;
+        return false;
+    }
+    
+    try {
+        stream->position = std::max<std::int64_t>(0, std::min(offset, stream->total_size));
+        update_stream_window_unsafe(*stream, false);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "更新读取位置时出错: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// 结束流式读取
+bool TorrentManager::stop_stream(const std::string& info_hash)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    StreamState* stream = find_stream_unsafe(info_hash);
+    if (stream == nullptr) {
+        std::cerr << "错误: 该 torrent 未开始流式读取 (info_hash: " << info_hash << ")" << std::endl;
+        return false;
+    }
+    
+    try {
+        for (int p = stream->first_piece; p < stream->end_piece; ++p) {
+            if (!stream->have[p]) {
+                stream->handle.reset_piece_deadline(lt::piece_index_t(p));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "取消分片截止时间时出错: " << e.what() << std::endl;
+    }
+    streams_.erase(find_torrent_unsafe(info_hash)->key);
+    
+    std::cout << "已结束流式读取 (info_hash: " << info_hash.substr(0, 8) << "...)" << std::endl;
+    return true;
+}
+
+// 获取流式读取状态
+StreamStatus TorrentManager::get_stream_status(const std::string& info_hash) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    StreamStatus result;
+    const TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr) {
+        return result;
+    }
+    auto it = streams_.find(found->key);
+    if (it == streams_.end() || it->second.handle != found->handle) {
+        return result;
+    }
+    
+    const StreamState& stream = it->second;
+    result.active = true;
+    result.position = stream.position;
+    result.window_bytes = stream.window_bytes;
+    result.window_pieces = stream.end_piece - stream.first_piece;
+    for (int p = stream.first_piece; p < stream.end_piece; ++p) {
+        if (!stream.have[p]) {
+            ++result.missing_pieces;
+        }
+    }
+    
+    // 从读取位置所在分片开始，到第一个缺少的分片为止
+    int piece = static_cast<int>(stream.position / stream.piece_length);
+    while (piece < stream.num_pieces && stream.have[piece]) {
+        ++piece;
+    }
+    const std::int64_t ready_end = std::min(stream.total_size, static_cast<std::int64_t>(piece) * stream.piece_length);
+    result.ready_bytes = std::max<std::int64_t>(0, ready_end - stream.position);
+    return result;
+}
+
+// 开始记录启动访问跟踪
+bool TorrentManager::start_trace(const std::string& info_hash, const std::string& trace_path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr) {
+        std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
+        return false;
+    }
+    
+    const std::string path = trace_path.empty() ? BootTraceRecorder::new_path_for(found->torrent_path) : trace_path;
+    auto recorder = std::make_shared<BootTraceRecorder>();
+    if (!recorder->open(path, found->info_hash)) {
+        return false;
+    }
+    traces_[found->key] = recorder;
+    std::cout << "开始记录启动访问跟踪: " << path << std::endl;
+    return true;
+}
+
+// 结束记录启动访问跟踪
+bool TorrentManager::stop_trace(const std::string& info_hash)
+{
+    std::shared_ptr<BootTraceRecorder> recorder;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TorrentInfo* found = find_torrent_unsafe(info_hash);
+        auto it = found != nullptr ? traces_.find(found->key) : traces_.end();
+        if (it == traces_.end()) {
+            std::cerr << "错误: 该 torrent 未在记录启动访问跟踪 (info_hash: " << info_hash << ")" << std::endl;
+            return false;
+        }
+        recorder = it->second;
+        traces_.erase(it);
+    }
+    
+    recorder->close();
+    std::cout << "启动访问跟踪已保存: " << recorder->path() << "（" << recorder->records() << " 次读取）" << std::endl;
+    return true;
+}
+
+// 报告一次读取
+bool TorrentManager::record_read(const std::string& info_hash, std::int64_t offset, std::int64_t length)
+{
+    std::shared_ptr<BootTraceRecorder> recorder;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TorrentInfo* found = find_torrent_unsafe(info_hash);
+        if (found == nullptr) {
+            return false;
+        }
+        auto trace = traces_.find(found->key);
+        if (trace != traces_.end()) {
+            recorder = trace->second;
+        }
+        StreamState* stream = find_stream_unsafe(info_hash);
+        if (stream != nullptr) {
+            try {
+                stream->position = std::max<std::int64_t>(0, std::min(offset, stream->total_size));
+                update_stream_window_unsafe(*stream, false);
+            } catch (const std::exception& e) {
+                std::cerr << "更新读取位置时出错: " << e.what() << std::endl;
+            }
+        }
+    }
+    
+    // 写入跟踪文件不持有 mutex_
+    if (recorder) {
+        recorder->record(offset, length);
+    }
+    return true;
+}
+
+// 随机读取 torrent 中一个文件的数据
+std::int64_t TorrentManager::read(const std::string& info_hash, int file_index, std::int64_t offset, char* buffer,
+                                  std::int64_t len, int timeout_ms)
+{
+    if (buffer == nullptr || offset < 0 || len < 0) {
+        std::cerr << "错误: 读取参数无效" << std::endl;
+        return -1;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    
+    TorrentKey key;
+    lt::torrent_handle handle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const TorrentInfo* found = find_torrent_unsafe(info_hash);
+        if (found == nullptr) {
+            std::cerr << "错误: 未找到指定的 torrent (info_hash: " << info_hash << ")" << std::endl;
+            return -1;
+        }
+        key = found->key;
+        handle = found->handle;
+    }
+    
+    // 映射到分片（torrent_file 需要访问 session，不持有 mutex_）
+    std::shared_ptr<const lt::torrent_info> ti;
+    try {
+        ti = handle.torrent_file();
+    } catch (const std::exception& e) {
+        std::cerr << "读取失败: " << e.what() << std::endl;
+        return -1;
+    }
+    if (!ti) {
+        std::cerr << "错误: torrent 元数据尚未下载，无法读取" << std::endl;
+        return -1;
+    }
+    const lt::file_storage& files = ti->files();
+    if (file_index < 0 || file_index >= files.num_files()) {
+        std::cerr << "错误: 文件索引无效: " << file_index << std::endl;
+        return -1;
+    }
+    const lt::file_index_t file(file_index);
+    const std::int64_t file_size = files.file_size(file);
+    if (offset >= file_size || len == 0) {
+        return 0;
+    }
+    len = std::min(len, file_size - offset);
+    
+    const std::int64_t start = files.file_offset(file) + offset;
+    const std::int64_t piece_length = ti->piece_length();
+    const int first_piece = static_cast<int>(start / piece_length);
+    const int last_piece = static_cast<int>((start + len - 1) / piece_length);
+    record_read(info_hash, start, len);
+    
+    // 先提交所有分片再依次等待，跨多个分片的读取并行下载
+    for (int p = first_piece; p <= last_piece; ++p) {
+        piece_reader_.request(key, handle, p);
+    }
+    
+    std::int64_t copied = 0;
+    for (int p = first_piece; p <= last_piece; ++p) {
+        PieceReader::Piece piece;
+        std::string error;
+        if (!piece_reader_.wait(key, handle, p, deadline, piece, error)) {
+            std::cerr << "读取分片 " << p << " 失败: " << error << std::endl;
+            return -1;
+        }
+        const std::int64_t piece_start = p * piece_length;
+        const std::int64_t from = std::max(start, piece_start);
+        const std::int64_t to = std::min(start + len, piece_start + piece.size);
+        if (to <= from) {
+            std::cerr << "读取分片 " << p << " 失败: 数据长度不足" << std::endl;
+            return -1;
+        }
+        std::memcpy(buffer + (from - start), piece.buffer.get() + (from - piece_start), static_cast<size_t>(to - from));
+        copied += to - from;
+    }
+    return copied;
+}
+
+// 从注册表中移除 torrent
+void TorrentManager::forget_torrent_unsafe(const TorrentKey& key)
+{
+    torrents_.erase(key);
+    streams_.erase(key);
+    traces_.erase(key);
+    piece_reader_.cancel(key);
+}
+
+void TorrentManager::forget_all_unsafe()
+{
+    torrents_.clear();
+    streams_.clear();
+    traces_.clear();
+    piece_reader_.cancel_all();
+}
+
+// 按读取位置设置窗口中分片的截止时间
+void TorrentManager::update_stream_window_unsafe(StreamState& stream, bool force)
+{
+    if (stream.num_pieces == 0) {
+        return;
+    }
+    
+    const int first = static_cast<int>(std::min<std::int64_t>(stream.position / stream.piece_length,
+                                                               stream.num_pieces - 1));
+    const std::int64_t window_end = std::min(stream.total_size, stream.position + stream.window_bytes);
+    int end = static_cast<int>((window_end + stream.piece_length - 1) / stream.piece_length);
+    end = std::max(first + 1, std::min(end, stream.num_pieces));
+    if (!force && first == stream.first_piece && end == stream.end_piece) {
+        return;
+    }
+    
+    // 离开窗口的分片（读取位置已经越过或向前跳转）取消截止时间，恢复普通的稀有优先
+    for (int p = stream.first_piece; p < stream.end_piece; ++p) {
+        if ((p < first || p >= end) && !stream.have[p]) {
+            stream.handle.reset_piece_deadline(lt::piece_index_t(p));
+        }
+    }
+    
+    // 窗口中尚未下载的分片按与读取位置的距离设置截止时间（已设置的分片更新为新的截止时间）
+    for (int p = first; p < end; ++p) {
+        if (!stream.have[p]) {
+            stream.handle.set_piece_deadline(lt::piece_index_t(p), (p - first) * stream.deadline_step_ms);
+        }
+    }
+    
+    stream.first_piece = first;
+    stream.end_piece = end;
+}
+
+// 查找流式读取状态
+TorrentManager::StreamState* TorrentManager::find_stream_unsafe(const std::string& info_hash)
+{
+    TorrentInfo* found = find_torrent_unsafe(info_hash);
+    if (found == nullptr) {
+        return nullptr;
+    }
+    auto it = streams_.find(found->key);
+    if (it == streams_.end()) {
+        return nullptr;
+    }
+    if (it->second.handle != found->handle) {
+        // torrent 已重新添加，旧的流式读取状态失效
+        streams_.erase(it);
+        return nullptr;
+    }
+    return &it->second;
+}
+
 // 打印网络/会话状态
 void TorrentManager::print_session_status() const
 {
@@ -1175,22 +2125,18 @@ void TorrentManager::print_session_status() const
         std::cout << "DHT 状态: 未运行" << std::endl;
     }
     
-    // 显示实际监听的端口
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // 显示实际监听的端口（由分发线程从 listen_succeeded_alert 记录）
     std::cout << "监听端口: ";
-    std::vector<lt::alert*> temp_alerts;
-    session_->pop_alerts(&temp_alerts);
-    for (lt::alert* a : temp_alerts) {
-        if (auto* la = lt::alert_cast<lt::listen_succeeded_alert>(a)) {
-            std::cout << la->address.to_string() << ":" << la->port << " ";
-        }
+    for (const auto& endpoint : listen_endpoints_) {
+        std::cout << endpoint << " ";
     }
-    // 如果没有监听成功的 alert，显示配置值
-    std::cout << "(配置范围: 6881-6891)" << std::endl;
+    // 同时显示当前会话配置中的监听地址（没有监听成功的 alert 时只有这一项）
+    std::cout << "(配置: " << profile_.listen_interfaces << ")" << std::endl;
     
     // 获取并显示所有 torrent 的详细 peer 信息
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const auto& pair : torrents_) {
-        const TorrentInfo& info = pair.second;
+    for (const auto& info : torrents_) {
         if (!info.handle.is_valid()) continue;
         
         std::cout << std::endl;
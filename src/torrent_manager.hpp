@@ -5,33 +5,32 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <mutex>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <condition_variable>
 #include <libtorrent/session.hpp>
+#include <libtorrent/alert.hpp>
 #include <libtorrent/torrent_handle.hpp>
 #include <libtorrent/add_torrent_params.hpp>
 #include <libtorrent/torrent_status.hpp>
-
-// Torrent 类型枚举
-enum class TorrentType {
-    Download,  // 下载
-    Seeding    // 做种
-};
-
-// Torrent 信息结构体
-struct TorrentInfo {
-    lt::torrent_handle handle;      // torrent 句柄
-    TorrentType type;                // 类型（下载/做种）
-    std::string torrent_path;        // torrent 文件路径
-    std::string save_path;           // 保存路径
-    std::string info_hash;           // info hash（用于唯一标识）
-    bool is_valid;                   // 是否有效
-    
-    TorrentInfo() : is_valid(false) {}
-};
+#include <libtorrent/info_hash.hpp>
+#include "resume_store.hpp"
+#include "alert_dispatcher.hpp"
+#include "torrent_registry.hpp"
+#include "session_profile.hpp"
+#include "torrent_policy.hpp"
+#include "boot_trace.hpp"
+#include "piece_reader.hpp"
 
 // Torrent 状态结构体
 struct TorrentStatus {
     std::string info_hash;           // info hash
+    std::string info_hash_v2;        // v2 info hash（v1 torrent 为空）
     TorrentType type;                // 类型
     std::string torrent_path;        // torrent 文件路径
     std::string save_path;           // 保存路径
@@ -64,6 +63,76 @@ struct TorrentStatus {
     {}
 };
 
+// 不可变的 torrent 状态快照（发布后不再修改，读取无需加锁）
+// 每次 torrent 增删或状态缓存更新时整体替换，version 随之递增
+// 状态条目在快照之间共享：状态更新只为有变化的 torrent 创建新条目，其余条目沿用上一个快照
+struct TorrentSnapshot {
+    std::uint64_t version;                             // 版本号
+    std::unordered_map<TorrentKey, std::shared_ptr<const TorrentStatus>, TorrentKeyHash> torrents;  // 所有 torrent 的状态（以主键为键）
+    std::unordered_map<TorrentKey, TorrentKey, TorrentKeyHash> v2_aliases;  // 混合 torrent 的 v2 键 -> 主键
+    size_t download_count;                             // 下载任务数量
+    size_t seeding_count;                              // 做种任务数量
+    
+    TorrentSnapshot() : version(0), download_count(0), seeding_count(0) {}
+    
+    // 按 info_hash 查找（同时接受混合 torrent 的 v2 哈希），未找到返回 nullptr
+    // 与 stop_torrent 等写操作一样通过 TorrentKey::from_hex 解析，不区分大小写
+    const TorrentStatus* find(const std::string& info_hash) const;
+    const TorrentStatus* find(const TorrentKey& key) const;
+};
+
+// 本地数据校验结果
+struct VerifyResult {
+    std::string torrent_path;              // torrent 文件路径
+    std::string save_path;                 // 校验的数据所在路径
+    lt::info_hash_t info_hashes;           // 校验所用 torrent 的 info hash
+    int num_pieces;                        // 分片总数
+    int failed_pieces;                     // 未通过校验的分片数量
+    std::vector<bool> piece_ok;            // 分片位图：每个分片是否通过校验
+    std::vector<int> unreadable_pieces;    // 无法读取的分片（文件缺失或读取失败）
+    std::vector<int> mismatched_pieces;    // 哈希不匹配的分片
+    double seconds;                        // 校验用时（秒）
+    bool is_valid;                         // 是否完成校验（torrent 无法加载时为 false）
+    
+    VerifyResult() : num_pieces(0), failed_pieces(0), seconds(0.0), is_valid(false) {}
+    
+    // 所有分片都通过校验
+    inline bool all_ok() const { return is_valid && failed_pieces == 0; }
+};
+
+// 批量添加请求
+struct AddRequest {
+    std::string torrent_path;        // torrent 文件路径
+    std::string save_path;           // 保存路径（下载时不存在则创建，做种时必须存在）
+    TorrentType type;                // 类型（下载/做种）
+    
+    AddRequest() : type(TorrentType::Download) {}
+    AddRequest(const std::string& torrent, const std::string& save, TorrentType add_type)
+        : torrent_path(torrent), save_path(save), type(add_type) {}
+};
+
+// 批量添加结果
+struct AddResult {
+    std::string torrent_path;        // torrent 文件路径
+    std::string info_hash;           // info hash（torrent 无法解析时为空）
+    bool ok;                         // 是否已加入 session
+    std::string error;               // 失败原因
+    
+    AddResult() : ok(false) {}
+};
+
+// 流式读取状态
+struct StreamStatus {
+    bool active;                     // 是否处于流式读取模式
+    std::int64_t position;           // 读取位置（torrent 数据中的字节偏移）
+    std::int64_t window_bytes;       // 读取位置之后设置截止时间的窗口大小（字节）
+    std::int64_t ready_bytes;        // 从读取位置开始连续可读的字节数
+    int window_pieces;               // 窗口中的分片数
+    int missing_pieces;              // 窗口中尚未下载的分片数
+    
+    StreamStatus() : active(false), position(0), window_bytes(0), ready_bytes(0), window_pieces(0), missing_pieces(0) {}
+};
+
 // Torrent 管理器类（单例模式）
 class TorrentManager
 {
@@ -84,12 +153,43 @@ public:
     // 返回: info_hash（用于后续操作），失败返回空字符串
     std::string start_download(const std::string& torrent_path, const std::string& save_path);
     
+    // 批量添加 torrent（用于一次导入成千上万个 torrent）
+    // .torrent 文件由 parse_threads 个线程并行解析（0 表示使用 CPU 核心数），解析完成后函数返回，
+    // torrent 通过 async_add_torrent 提交，不等待 session 添加完成，也不在持有 mutex_ 时等待
+    // 返回: 与 requests 一一对应的 future，add_torrent_alert 到达后（或解析失败时立即）得到结果
+    // on_added: 每个请求完成时调用（解析失败在调用线程中，其余在 alert 分发线程中调用，不能在其中等待 future）
+    // 与 start_download / start_seeding 不同，这里不输出每个 torrent 的详情，做种时也不预先调用 verify_torrent：
+    // 没有恢复数据的 torrent 由 libtorrent 校验
+    std::vector<std::future<AddResult>> add_torrents_async(const std::vector<AddRequest>& requests,
+                                                           int parse_threads = 0,
+                                                           std::function<void(const AddResult&)> on_added = nullptr);
+    
     // 开始做种
     // torrent_path: torrent 文件路径
     // save_path: 原始文件/目录的保存路径（必须与创建 torrent 时的路径一致）
     // 返回: info_hash（用于后续操作），失败返回空字符串
+    // 启用 set_verify_before_seeding 且没有快速恢复数据时，先调用 verify_torrent 校验本地数据再以校验结果启动做种：
+    // 校验在调用线程中完成，读完全部数据之前不会返回（大镜像可能需要几分钟）；默认不校验，由 libtorrent 在后台检查
     std::string start_seeding(const std::string& torrent_path, const std::string& save_path);
     
+    // 以校验结果作为恢复数据开始做种：通过校验的分片直接标记为已拥有，libtorrent 不再重新校验
+    // 未通过校验的分片不会提供给其他 peer（可从其他做种者重新获取）
+    // verified 与 torrent 不匹配时退回 libtorrent 的完整校验
+    std::string start_seeding(const std::string& torrent_path, const std::string& save_path,
+                              const VerifyResult& verified);
+    
+    // 校验本地数据：使用多线程哈希引擎（所有 CPU 核心、大块顺序读取）按 torrent 中的分片哈希校验，不经过 session
+    // hash_threads: 哈希线程数，0 表示使用 CPU 核心数
+    // 返回: 是否完成校验（torrent 无法加载时返回 false），校验是否通过见 result.all_ok()
+    static bool verify_torrent(const std::string& torrent_path, const std::string& save_path,
+                               VerifyResult& result, int hash_threads = 0, bool direct_io = false);
+    
+    // 打印校验报告：通过/失败的分片数量，以及未通过校验的分片和所涉及的文件（最多列出 max_listed 个分片）
+    static void print_verify_report(const VerifyResult& result, int max_listed = 20);
+    
+    // 将分片位图写入文本文件（每个分片一个字符，1 表示通过校验）
+    static bool write_piece_bitfield(const VerifyResult& result, const std::string& output_path);
+    
     // 停止指定的 torrent（通过 info_hash）
     bool stop_torrent(const std::string& info_hash);
     
@@ -115,6 +215,7 @@ public:
     void resume_all();
     
     // 获取指定 torrent 的状态
+    // 状态查询均读取缓存，不阻塞在 session 上；缓存在每次 wait_and_process 时通过 post_torrent_updates 刷新
     TorrentStatus get_torrent_status(const std::string& info_hash) const;
     
     // 获取所有 torrent 的状态
@@ -126,6 +227,10 @@ public:
     // 获取所有做种任务的状态
     std::vector<TorrentStatus> get_seeding_status() const;
     
+    // 获取当前发布的状态快照（不加锁；返回的快照不会再改变，可长期持有）
+    // has_torrent、计数和状态查询函数都从快照读取，不与 start_download / stop_torrent 等写操作竞争 mutex_
+    std::shared_ptr<const TorrentSnapshot> snapshot() const;
+    
     // 检查指定 torrent 是否存在
     bool has_torrent(const std::string& info_hash) const;
     
@@ -139,9 +244,23 @@ public:
     size_t get_seeding_count() const;
     
     // 等待并处理事件（用于保持运行状态）
+    // alert 由独立的分发线程处理；这里执行定期维护后等待，最多 timeout_ms，
+    // torrent 完成、出错或状态变化时立即返回
     // 返回 false 表示应该退出
     bool wait_and_process(int timeout_ms = 1000);
     
+    // 订阅指定类型的 alert，处理函数在分发线程中调用（alert 仅在调用期间有效）
+    // 例如 subscribe_alert<lt::torrent_finished_alert>([](const lt::torrent_finished_alert& a) { ... })
+    // 返回: 订阅 ID
+    template <class AlertT>
+    int subscribe_alert(std::function<void(const AlertT&)> handler)
+    {
+        return alert_dispatcher_->subscribe<AlertT>(std::move(handler));
+    }
+    
+    // 取消订阅
+    void unsubscribe_alert(int id);
+    
     // 打印所有 torrent 的状态
     void print_all_status() const;
     
@@ -157,6 +276,68 @@ public:
     
     // 打印网络/会话状态（用于诊断）
     void print_session_status() const;
+    
+    // 开始流式读取（用于边下载边启动镜像）：读取位置之后 window_bytes 内的分片设置截止时间，
+    // 越靠近读取位置截止时间越早（间隔 deadline_step_ms），其余分片仍按稀有优先在后台下载
+    // 会关闭顺序下载；读取位置初始为 0，之后通过 set_stream_position 移动
+    // 返回: 是否成功（torrent 不存在或元数据尚未下载时返回 false）
+    bool start_stream(const std::string& info_hash, std::int64_t window_bytes = 256LL * 1024 * 1024,
+                      int deadline_step_ms = 100);
+    
+    // 更新读取位置：窗口随之滑动，离开窗口的分片取消截止时间（读取位置所在分片变化时才重新设置）
+    bool set_stream_position(const std::string& info_hash, std::int64_t offset);
+    
+    // 结束流式读取，取消所有分片的截止时间
+    bool stop_stream(const std::string& info_hash);
+    
+    // 获取流式读取状态（不访问 session；未开始流式读取时 active 为 false）
+    StreamStatus get_stream_status(const std::string& info_hash) const;
+    
+    // 开始记录启动访问跟踪：之后 record_read 报告的读取写入跟踪文件
+    // trace_path 为空时写入 <torrent>.traces 目录中按开始时间命名的新文件
+    // 多次启动的跟踪文件可用 PrefetchProfile::compile 编译为 <torrent>.prefetch，start_download 自动应用
+    bool start_trace(const std::string& info_hash, const std::string& trace_path = std::string());
+    
+    // 结束记录启动访问跟踪
+    bool stop_trace(const std::string& info_hash);
+    
+    // 报告一次读取：正在记录跟踪时写入跟踪文件，正在流式读取时将读取位置移到 offset
+    // 返回: torrent 是否存在
+    bool record_read(const std::string& info_hash, std::int64_t offset, std::int64_t length);
+    
+    // 随机读取 torrent 中一个文件的数据（阻塞，供启动加载和虚拟磁盘使用）
+    // 只返回已通过校验的数据：缺少的分片设为最高优先级并立即截止，等待下载完成，最多等待 timeout_ms
+    // 多个线程可同时调用，读取同一分片的请求合并为一次；读取同时报告给 record_read（跟踪记录和流式读取位置）
+    // 返回: 读取的字节数（只在文件末尾时少于 len），失败或超时返回 -1
+    std::int64_t read(const std::string& info_hash, int file_index, std::int64_t offset, char* buffer,
+                      std::int64_t len, int timeout_ms = 30000);
+    
+    // 设置 read 读取后保留在内存中的分片数（默认 8，连续的小块读取不会重复读盘）
+    inline void set_read_cache_pieces(size_t pieces) { piece_reader_.set_cache_pieces(pieces); }
+    
+    // 切换会话配置（通过 apply_settings 应用，已添加的 torrent 不受影响；监听地址变化时重新监听）
+    // 返回: 是否成功（配置中的网段格式错误时不做任何修改）
+    bool apply_profile(const SessionProfile& profile);
+    
+    // 当前会话配置名称
+    std::string current_profile() const;
+    
+    // 设置恢复数据的状态目录（默认 torrent_state，为空表示不保存）
+    // 下载进度和做种状态保存在这里，重新启动后 start_download / start_seeding 自动加载，无需重新校验
+    void set_state_dir(const std::string& state_dir);
+    
+    // 设置定期保存恢复数据的间隔（秒，默认 60，0 表示只在状态变化时保存）
+    inline void set_resume_interval(int seconds) { resume_interval_ = seconds; }
+    
+    // 设置 start_seeding 在没有快速恢复数据时是否先阻塞校验本地数据（默认 false）
+    inline void set_verify_before_seeding(bool enabled) { verify_before_seeding_ = enabled; }
+    
+    // 请求保存所有 torrent 的恢复数据（只保存有变化的 torrent；结果由分发线程交给后台线程写入）
+    void save_all_resume_data();
+    
+    // 保存所有 torrent 的恢复数据并等待写入完成（退出前调用）
+    // timeout_ms: 等待 libtorrent 返回恢复数据的最长时间
+    void flush_resume_data(int timeout_ms = 10000);
 
 private:
     // 私有构造函数（单例模式）
@@ -165,15 +346,88 @@ private:
     // 初始化 session 设置
     void configure_session();
     
+    // 开始做种的实现（仅在已持有 mutex_ 时调用），verified 为空时使用快速恢复数据或 libtorrent 校验
+    std::string start_seeding_unsafe(const std::string& torrent_path, const std::string& save_path,
+                                     const VerifyResult* verified);
+    
+    // 批量添加中已提交、等待 add_torrent_alert 的 torrent
+    struct PendingAdd {
+        std::promise<AddResult> promise;
+        AddResult result;
+        TorrentInfo info;
+        bool queue_first = false;  // 添加后移到队列最前（分类策略）
+        std::shared_ptr<std::function<void(const AddResult&)>> on_added;
+    };
+    
+    // 为批量添加解析 torrent 并按分类策略生成 add_torrent_params（不加锁，可在多个线程中同时调用）
+    // 返回: 是否成功，失败时 error 为原因
+    bool prepare_add_params(const AddRequest& request, const TorrentPolicy& policy,
+                            lt::add_torrent_params& params, TorrentInfo& info, bool& queue_first,
+                            std::string& error);
+    
+    // 流式读取窗口（以 torrent 主键索引，仅在持有 mutex_ 时访问）
+    struct StreamState {
+        lt::torrent_handle handle;       // 开始流式读取时的句柄（torrent 重新添加后不再匹配）
+        int piece_length;                // 分片大小
+        int num_pieces;                  // 分片数量
+        std::int64_t total_size;         // 数据总大小
+        std::int64_t position;           // 读取位置
+        std::int64_t window_bytes;       // 窗口大小
+        int deadline_step_ms;            // 相邻分片截止时间的间隔
+        int first_piece;                 // 当前设置了截止时间的分片范围 [first_piece, end_piece)
+        int end_piece;
+        std::vector<bool> have;          // 已下载的分片（由 piece_finished_alert 更新）
+    };
+    
+    // 按读取位置重新设置窗口中分片的截止时间（force 为 false 时窗口范围未变化则不做任何操作）
+    void update_stream_window_unsafe(StreamState& stream, bool force);
+    
+    // 查找流式读取状态（torrent 已移除或重新添加时返回 nullptr，仅在已持有 mutex_ 时调用）
+    StreamState* find_stream_unsafe(const std::string& info_hash);
+    
+    // 从注册表中移除 torrent，同时丢弃它的流式读取状态并结束跟踪记录（仅在已持有 mutex_ 时调用）
+    void forget_torrent_unsafe(const TorrentKey& key);
+    void forget_all_unsafe();
+    
+    // 处理 add_torrent_alert：完成对应的批量添加请求
+    void on_torrent_added(const lt::add_torrent_alert& a);
+    
+    // 每批 alert 处理完后调用：合并发布快照，并在不持有 mutex_ 时通知已完成的批量添加请求
+    void on_alert_batch();
+    
     // 验证路径
     bool validate_paths(const std::string& torrent_path, const std::string& save_path, bool create_save_path = false);
     
-    // 从 torrent_info 获取 info_hash 字符串
+    // 从 torrent_info 获取 info_hash 字符串（优先 v1，仅 v2 的 torrent 使用 v2 哈希）
     std::string get_info_hash_string(const lt::torrent_info& ti) const;
     
+    // 从 torrent_info 获取 v2 info_hash 字符串（v1 torrent 返回空字符串）
+    std::string get_info_hash_v2_string(const lt::torrent_info& ti) const;
+    
+    // 按十六进制 info_hash 查找 torrent（同时接受混合 torrent 的 v2 哈希，仅在已持有 mutex_ 时调用）
+    // 返回: 未找到或格式错误时返回 nullptr
+    TorrentInfo* find_torrent_unsafe(const std::string& info_hash);
+    const TorrentInfo* find_torrent_unsafe(const std::string& info_hash) const;
+    
+    // 注册 TorrentManager 自身的 alert 处理函数（完成/错误/状态变化提示、恢复数据保存、监听端口记录）
+    void register_alert_handlers();
+    
+    // 通知 wait_and_process 有需要立即处理的事件
+    void notify_event();
+    
     // 更新 torrent 状态（清理无效的 torrent）
     void update_torrents();
     
+    // 根据 torrents_ 生成新的快照并发布（仅在已持有 mutex_ 时调用）
+    void publish_snapshot_unsafe();
+    
+    // 以当前快照为基础，只替换 changed_statuses_ 中 torrent 的状态条目后发布（仅在已持有 mutex_ 时调用）
+    void publish_status_changes_unsafe();
+    
+    // 读取当前快照：每个线程缓存最近读取的快照，版本号未变化时不访问共享的 shared_ptr
+    // 返回的引用在本线程下一次调用前有效
+    const TorrentSnapshot& current_snapshot() const;
+    
     // 从 status 创建 TorrentStatus
     TorrentStatus create_torrent_status(const TorrentInfo& info, const lt::torrent_status& status) const;
 
@@ -184,8 +438,28 @@ private:
 
 private:
     std::unique_ptr<lt::session> session_;              // libtorrent 会话（共享）
-    std::map<std::string, TorrentInfo> torrents_;       // 管理的所有 torrent（以 info_hash 为键）
+    TorrentRegistry torrents_;                          // 管理的所有 torrent（以二进制 info hash 为键）
     mutable std::mutex mutex_;                          // 互斥锁（用于线程安全）
+    SessionProfile profile_;                            // 当前会话配置
+    ResumeStore resume_store_;                          // 恢复数据存储（后台写入）
+    int resume_interval_;                               // 定期保存恢复数据的间隔（秒）
+    bool verify_before_seeding_;                        // start_seeding 没有恢复数据时是否先校验
+    std::chrono::steady_clock::time_point last_resume_save_;  // 上次定期保存的时间
+    std::vector<std::string> listen_endpoints_;         // 监听成功的地址（由 listen_succeeded_alert 记录）
+    std::mutex event_mutex_;                            // 保护事件状态
+    std::condition_variable event_cv_;                  // 事件通知（唤醒 wait_and_process / flush_resume_data）
+    bool event_pending_;                                // 是否有未处理的事件
+    int resume_replies_;                                // 已收到的恢复数据回复数量（成功或失败）
+    std::unordered_map<TorrentKey, PendingAdd, TorrentKeyHash> pending_adds_;  // 等待 add_torrent_alert 的批量添加
+    std::vector<PendingAdd> completed_adds_;            // 已完成、等待通知的批量添加（在 on_alert_batch 中通知）
+    bool snapshot_dirty_;                               // 分发线程增加了 torrent，本批 alert 处理完后重新生成快照
+    std::vector<TorrentKey> changed_statuses_;          // 状态有变化、尚未发布到快照的 torrent
+    std::unordered_map<TorrentKey, StreamState, TorrentKeyHash> streams_;  // 流式读取中的 torrent
+    std::unordered_map<TorrentKey, std::shared_ptr<BootTraceRecorder>, TorrentKeyHash> traces_;  // 正在记录的启动跟踪
+    PieceReader piece_reader_;                          // read 的按需分片读取（有自己的锁，持有 mutex_ 时可以调用）
+    std::shared_ptr<const TorrentSnapshot> snapshot_;   // 当前发布的快照（通过 std::atomic_load / atomic_store 访问）
+    std::atomic<std::uint64_t> snapshot_version_;       // 当前快照的版本号
+    std::unique_ptr<AlertDispatcher> alert_dispatcher_; // alert 分发线程（最先销毁）
 };
 
 #endif // TORRENT_MANAGER_HPP
@@ -0,0 +1,454 @@
+#include "torrent_policy.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <mutex>
+
+namespace {
+
+// 去掉首尾空白
+std::string trim(const std::string& text)
+{
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+std::string to_lower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return text;
+}
+
+bool parse_bool(const std::string& value, bool& result)
+{
+    const std::string lower = to_lower(value);
+    if (lower == "true" || lower == "1" || lower == "yes" || lower == "on") {
+        result = true;
+        return true;
+    }
+    if (lower == "false" || lower == "0" || lower == "no" || lower == "off") {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+bool parse_int(const std::string& value, int& result)
+{
+    try {
+        size_t used = 0;
+        long long parsed = std::stoll(value, &used, 0);
+        if (used != value.size() || parsed < INT32_MIN || parsed > INT32_MAX) {
+            return false;
+        }
+        result = static_cast<int>(parsed);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// 解析大小：数字加可选的 KB/MB/GB/TB 后缀（1024 进制，B 可省略）
+bool parse_size(const std::string& value, std::int64_t& result)
+{
+    try {
+        size_t used = 0;
+        long double number = std::stold(value, &used);
+        std::string unit = to_lower(trim(value.substr(used)));
+        if (!unit.empty() && unit.back() == 'b') {
+            unit.pop_back();
+        }
+        std::int64_t multiplier = 1;
+        if (unit == "k") {
+            multiplier = 1024LL;
+        } else if (unit == "m") {
+            multiplier = 1024LL * 1024;
+        } else if (unit == "g") {
+            multiplier = 1024LL * 1024 * 1024;
+        } else if (unit == "t") {
+            multiplier = 1024LL * 1024 * 1024 * 1024;
+        } else if (!unit.empty()) {
+            return false;
+        }
+        if (number < 0) {
+            return false;
+        }
+        result = static_cast<std::int64_t>(number * multiplier);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::string format_bytes(std::int64_t bytes)
+{
+    const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit_index = 0;
+    double size = static_cast<double>(bytes);
+
+    while (size >= 1024.0 && unit_index < 4) {
+        size /= 1024.0;
+        unit_index++;
+    }
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.2f %s", size, units[unit_index]);
+    return std::string(buffer);
+}
+
+// 设置分类字段
+bool set_field(TorrentClass& cls, const std::string& key, const std::string& value)
+{
+    struct SizeField { const char* key; std::int64_t TorrentClass::*member; };
+    struct IntField { const char* key; int TorrentClass::*member; };
+    struct BoolField { const char* key; bool TorrentClass::*member; };
+    static const SizeField size_fields[] = {
+        {"min_total_size", &TorrentClass::min_total_size},
+        {"max_total_size", &TorrentClass::max_total_size},
+    };
+    static const IntField int_fields[] = {
+        {"min_pieces", &TorrentClass::min_pieces},
+        {"max_pieces", &TorrentClass::max_pieces},
+        {"min_files", &TorrentClass::min_files},
+        {"max_files", &TorrentClass::max_files},
+        {"max_connections", &TorrentClass::max_connections},
+        {"max_uploads", &TorrentClass::max_uploads},
+        {"file_priority", &TorrentClass::file_priority},
+    };
+    static const BoolField bool_fields[] = {
+        {"auto_managed", &TorrentClass::auto_managed},
+        {"queue_first", &TorrentClass::queue_first},
+        {"trust_existing_files", &TorrentClass::trust_existing_files},
+        {"sequential_download", &TorrentClass::sequential_download},
+    };
+
+    for (const auto& field : size_fields) {
+        if (key == field.key) {
+            return parse_size(value, cls.*field.member);
+        }
+    }
+    for (const auto& field : int_fields) {
+        if (key == field.key) {
+            return parse_int(value, cls.*field.member);
+        }
+    }
+    for (const auto& field : bool_fields) {
+        if (key == field.key) {
+            return parse_bool(value, cls.*field.member);
+        }
+    }
+    if (key == "min_build_piece_size") {
+        std::int64_t size = 0;
+        // 与 v2 torrent 的要求一致：0 或不小于 16KB 的 2 的幂
+        if (!parse_size(value, size) || size > 256LL * 1024 * 1024 ||
+            (size != 0 && (size < 16 * 1024 || (size & (size - 1)) != 0))) {
+            return false;
+        }
+        cls.min_build_piece_size = static_cast<int>(size);
+        return true;
+    }
+    return false;
+}
+
+// 内置分类（按匹配顺序）
+std::vector<TorrentClass> builtin_classes()
+{
+    std::vector<TorrentClass> classes;
+
+    // 小 torrent（如 2GB 的驱动包）：很快就能完成，排在队列最前，不被大 torrent 的校验挡住
+    TorrentClass small;
+    small.name = "small";
+    small.max_total_size = 4LL * 1024 * 1024 * 1024;  // 4GB
+    small.max_connections = 50;
+    small.queue_first = true;
+    classes.push_back(small);
+
+    // 大 torrent（如 150GB 的游戏镜像）：不参与自动管理，避免校验时被暂停；更多连接，所有文件最高优先级
+    TorrentClass large;
+    large.name = "large";
+    large.min_total_size = 50LL * 1024 * 1024 * 1024;  // 50GB
+    large.max_connections = 200;
+    large.auto_managed = false;
+    large.file_priority = 7;
+    large.min_build_piece_size = 16 * 1024 * 1024;      // 16MB
+    classes.push_back(large);
+
+    // 其他
+    TorrentClass standard;
+    standard.name = "standard";
+    standard.min_build_piece_size = 16 * 1024 * 1024;   // 超过 4GB 的 torrent 使用不小于 16MB 的分片
+    classes.push_back(standard);
+
+    return classes;
+}
+
+// 进程默认策略
+std::mutex default_mutex;
+TorrentPolicy& default_policy()
+{
+    static TorrentPolicy policy;
+    return policy;
+}
+
+} // namespace
+
+TorrentClass::TorrentClass()
+    : name("default")
+    , min_total_size(0)
+    , max_total_size(0)
+    , min_pieces(0)
+    , max_pieces(0)
+    , min_files(0)
+    , max_files(0)
+    , max_connections(100)
+    , max_uploads(-1)
+    , auto_managed(true)
+    , queue_first(false)
+    , trust_existing_files(false)
+    , sequential_download(false)
+    , file_priority(4)
+    , min_build_piece_size(0)
+{
+}
+
+bool TorrentClass::matches(std::int64_t total_size, int num_pieces, int num_files) const
+{
+    if (min_total_size > 0 && total_size < min_total_size) {
+        return false;
+    }
+    if (max_total_size > 0 && total_size > max_total_size) {
+        return false;
+    }
+    if (num_pieces >= 0) {
+        if (min_pieces > 0 && num_pieces < min_pieces) {
+            return false;
+        }
+        if (max_pieces > 0 && num_pieces > max_pieces) {
+            return false;
+        }
+    }
+    if (min_files > 0 && num_files < min_files) {
+        return false;
+    }
+    if (max_files > 0 && num_files > max_files) {
+        return false;
+    }
+    return true;
+}
+
+void TorrentClass::apply(lt::add_torrent_params& params, bool seeding) const
+{
+    params.flags &= ~lt::torrent_flags::paused;
+    if (auto_managed) {
+        params.flags |= lt::torrent_flags::auto_managed;
+    } else {
+        params.flags &= ~lt::torrent_flags::auto_managed;
+    }
+    params.max_connections = max_connections;
+    params.max_uploads = max_uploads;
+
+    if (seeding) {
+        return;
+    }
+    params.flags &= ~lt::torrent_flags::upload_mode;
+    if (sequential_download) {
+        params.flags |= lt::torrent_flags::sequential_download;
+    } else {
+        params.flags &= ~lt::torrent_flags::sequential_download;
+    }
+    if (file_priority != 4 && params.ti) {
+        const int priority = std::max(1, std::min(7, file_priority));
+        params.file_priorities.assign(params.ti->num_files(),
+                                      lt::download_priority_t(static_cast<std::uint8_t>(priority)));
+    }
+}
+
+void TorrentClass::apply_handle(const lt::torrent_handle& handle) const
+{
+    if (queue_first && auto_managed) {
+        handle.queue_position_top();
+    }
+}
+
+void TorrentClass::print() const
+{
+    std::cout << "  [" << name << "]";
+    if (min_total_size > 0) {
+        std::cout << " 大小 >= " << format_bytes(min_total_size);
+    }
+    if (max_total_size > 0) {
+        std::cout << " 大小 <= " << format_bytes(max_total_size);
+    }
+    if (min_pieces > 0) {
+        std::cout << " 分片 >= " << min_pieces;
+    }
+    if (max_pieces > 0) {
+        std::cout << " 分片 <= " << max_pieces;
+    }
+    if (min_files > 0) {
+        std::cout << " 文件 >= " << min_files;
+    }
+    if (max_files > 0) {
+        std::cout << " 文件 <= " << max_files;
+    }
+    if (min_total_size == 0 && max_total_size == 0 && min_pieces == 0 && max_pieces == 0 &&
+        min_files == 0 && max_files == 0) {
+        std::cout << " 不限制";
+    }
+    std::cout << std::endl;
+    std::cout << "    连接数: " << max_connections
+              << "，" << (auto_managed ? "自动管理" : "手动管理")
+              << (queue_first ? "，排在队列最前" : "")
+              << (trust_existing_files ? "，文件完整时跳过做种校验" : "")
+              << (sequential_download ? "，顺序下载" : "")
+              << "，文件优先级: " << file_priority;
+    if (min_build_piece_size > 0) {
+        std::cout << "，生成分片不小于 " << format_bytes(min_build_piece_size);
+    }
+    std::cout << std::endl;
+}
+
+TorrentPolicy::TorrentPolicy()
+    : classes_(builtin_classes())
+{
+}
+
+const TorrentClass& TorrentPolicy::classify(std::int64_t total_size, int num_pieces, int num_files) const
+{
+    for (const auto& cls : classes_) {
+        if (cls.matches(total_size, num_pieces, num_files)) {
+            return cls;
+        }
+    }
+    return fallback_;
+}
+
+const TorrentClass& TorrentPolicy::classify(const lt::torrent_info& ti) const
+{
+    return classify(ti.total_size(), ti.num_pieces(), ti.num_files());
+}
+
+void TorrentPolicy::print() const
+{
+    std::cout << "torrent 分类策略（按顺序匹配）:" << std::endl;
+    for (const auto& cls : classes_) {
+        cls.print();
+    }
+}
+
+bool TorrentPolicy::load_file(const std::string& path, TorrentPolicy& policy)
+{
+    std::ifstream in(std::filesystem::u8path(path));
+    if (!in.is_open()) {
+        std::cerr << "错误: 无法打开分类策略文件: " << path << std::endl;
+        return false;
+    }
+
+    const std::vector<TorrentClass> builtins = builtin_classes();
+    std::vector<TorrentClass> loaded;
+    std::string line;
+    int line_number = 0;
+    bool ok = true;
+    while (std::getline(in, line)) {
+        ++line_number;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+
+        if (line.front() == '[' && line.back() == ']') {
+            TorrentClass cls;
+            cls.name = trim(line.substr(1, line.size() - 2));
+            loaded.push_back(cls);
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || loaded.empty()) {
+            std::cerr << "错误: " << path << ":" << line_number << " 格式错误: " << line << std::endl;
+            ok = false;
+            continue;
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        TorrentClass& cls = loaded.back();
+
+        if (key == "base") {
+            // 继承内置分类（或同一文件中前面的分类）的条件和设置，之后的键覆盖继承的值
+            const TorrentClass* base = nullptr;
+            for (size_t i = 0; !base && i + 1 < loaded.size(); ++i) {
+                if (loaded[i].name == value) {
+                    base = &loaded[i];
+                }
+            }
+            for (size_t i = 0; !base && i < builtins.size(); ++i) {
+                if (builtins[i].name == value) {
+                    base = &builtins[i];
+                }
+            }
+            if (!base) {
+                std::cerr << "错误: " << path << ":" << line_number << " 未知的基础分类: " << value << std::endl;
+                ok = false;
+                continue;
+            }
+            std::string name = cls.name;
+            cls = *base;
+            cls.name = name;
+            continue;
+        }
+
+        if (!set_field(cls, key, value)) {
+            std::cerr << "错误: " << path << ":" << line_number << " 无效的设置: " << key << " = " << value << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        return false;
+    }
+    if (loaded.empty()) {
+        std::cerr << "错误: 分类策略文件中没有分类: " << path << std::endl;
+        return false;
+    }
+    policy.classes_ = loaded;
+    return true;
+}
+
+bool TorrentPolicy::data_present(const lt::torrent_info& ti, const std::string& save_path)
+{
+    namespace fs = std::filesystem;
+    const lt::file_storage& files = ti.files();
+    for (int i = 0; i < files.num_files(); ++i) {
+        const lt::file_index_t index(i);
+        if (files.pad_file_at(index)) {
+            continue;
+        }
+        std::error_code ec;
+        const std::uintmax_t size = fs::file_size(fs::u8path(files.file_path(index, save_path)), ec);
+        if (ec || static_cast<std::int64_t>(size) != files.file_size(index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TorrentPolicy::set_default(const TorrentPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(default_mutex);
+    default_policy() = policy;
+}
+
+TorrentPolicy TorrentPolicy::get_default()
+{
+    std::lock_guard<std::mutex> lock(default_mutex);
+    return default_policy();
+}
@@ -0,0 +1,94 @@
+#ifndef TORRENT_POLICY_HPP
+#define TORRENT_POLICY_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/add_torrent_params.hpp>
+
+// torrent 分类：按总大小、分片数和文件数匹配，匹配后应用该分类的连接、队列、校验和分片选择设置
+struct TorrentClass {
+    std::string name;                    // 分类名称
+
+    // 分类条件（0 表示不限制，全部满足时匹配）
+    std::int64_t min_total_size;         // 最小总大小（字节）
+    std::int64_t max_total_size;         // 最大总大小（字节）
+    int min_pieces;                      // 最少分片数
+    int max_pieces;                      // 最多分片数
+    int min_files;                       // 最少文件数
+    int max_files;                       // 最多文件数
+
+    // 连接
+    int max_connections;                 // 每个 torrent 的最大连接数（-1 表示不限制）
+    int max_uploads;                     // 每个 torrent 的最大上传连接数（-1 表示不限制）
+
+    // 队列
+    bool auto_managed;                   // 由 libtorrent 队列自动管理（关闭后添加即开始，不会因排队被暂停）
+    bool queue_first;                    // 添加后移到队列最前（自动管理时先于其他 torrent 校验和开始）
+
+    // 校验
+    bool trust_existing_files;           // 做种且没有恢复数据时，如果所有文件都存在且大小正确则跳过校验（seed_mode）
+
+    // 分片选择
+    bool sequential_download;            // 按顺序下载分片
+    int file_priority;                   // 所有文件的下载优先级（1-7，4 为 libtorrent 默认）
+
+    // 生成 torrent
+    int min_build_piece_size;            // 生成 torrent 时的最小分片大小（字节，0 表示不限制）
+
+    // 默认值：不限制条件，100 个连接，自动管理，校验所有文件
+    TorrentClass();
+
+    // 是否匹配（num_pieces 为负数时不检查分片数条件，用于生成 torrent 前分片数未知的情况）
+    bool matches(std::int64_t total_size, int num_pieces, int num_files) const;
+
+    // 将设置写入 add_torrent_params（添加前调用，添加后无需再访问句柄）
+    // seeding: 是否为做种（做种时不设置文件优先级和顺序下载）
+    void apply(lt::add_torrent_params& params, bool seeding) const;
+
+    // 添加后需要在句柄上进行的设置（队列位置）
+    void apply_handle(const lt::torrent_handle& handle) const;
+
+    // 打印分类摘要
+    void print() const;
+};
+
+// torrent 分类策略：按顺序匹配分类，使用第一个匹配的分类；都不匹配时使用 TorrentClass 的默认值
+// 内置 small（4GB 以下，如驱动包）、large（50GB 以上，如游戏镜像）和 standard（其他）三个分类，也可从配置文件加载
+// TorrentManager、Downloader、Seeder 添加 torrent 和 TorrentBuilder 选择分片大小时使用当前的默认策略
+class TorrentPolicy
+{
+public:
+    // 使用内置分类
+    TorrentPolicy();
+
+    // 按大小、分片数和文件数分类
+    const TorrentClass& classify(std::int64_t total_size, int num_pieces, int num_files) const;
+    const TorrentClass& classify(const lt::torrent_info& ti) const;
+
+    // 分类列表
+    inline const std::vector<TorrentClass>& classes() const { return classes_; }
+
+    // 打印所有分类
+    void print() const;
+
+    // 从配置文件加载（INI 格式：[名称] 开始一个分类，按出现顺序匹配；base = 内置分类名 表示继承）
+    // 大小可以使用 KB/MB/GB/TB 后缀；文件中的分类替换全部内置分类
+    // 返回: 是否成功（文件不存在或有格式错误时返回 false，policy 不变）
+    static bool load_file(const std::string& path, TorrentPolicy& policy);
+
+    // 所有文件是否都存在且大小与 torrent 一致（pad 文件除外）
+    static bool data_present(const lt::torrent_info& ti, const std::string& save_path);
+
+    // 进程默认策略（添加 torrent 前设置；未设置时为内置分类）
+    static void set_default(const TorrentPolicy& policy);
+    static TorrentPolicy get_default();
+
+private:
+    std::vector<TorrentClass> classes_;  // 按匹配顺序排列
+    TorrentClass fallback_;              // 都不匹配时使用
+};
+
+#endif // TORRENT_POLICY_HPP
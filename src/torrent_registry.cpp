@@ -0,0 +1,245 @@
+#include "torrent_registry.hpp"
+
+TorrentKey TorrentKey::from_v1(const lt::sha1_hash& hash)
+{
+    TorrentKey key;
+    key.size = static_cast<std::uint8_t>(hash.size());
+    std::memcpy(key.bytes.data(), hash.data(), key.size);
+    return key;
+}
+
+TorrentKey TorrentKey::from_v2(const lt::sha256_hash& hash)
+{
+    TorrentKey key;
+    key.size = static_cast<std::uint8_t>(hash.size());
+    std::memcpy(key.bytes.data(), hash.data(), key.size);
+    return key;
+}
+
+TorrentKey TorrentKey::primary(const lt::info_hash_t& hashes)
+{
+    if (!hashes.has_v1() && hashes.has_v2()) {
+        return from_v2(hashes.v2);
+    }
+    return from_v1(hashes.v1);
+}
+
+TorrentKey TorrentKey::secondary(const lt::info_hash_t& hashes)
+{
+    if (hashes.has_v1() && hashes.has_v2()) {
+        return from_v2(hashes.v2);
+    }
+    return TorrentKey();
+}
+
+bool TorrentKey::from_hex(const std::string& hex, TorrentKey& key)
+{
+    if (hex.size() != 40 && hex.size() != 64) {
+        return false;
+    }
+    TorrentKey result;
+    result.size = static_cast<std::uint8_t>(hex.size() / 2);
+    for (size_t i = 0; i < hex.size(); ++i) {
+        char c = hex[i];
+        int value;
+        if (c >= '0' && c <= '9') {
+            value = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        result.bytes[i / 2] = static_cast<std::uint8_t>((result.bytes[i / 2] << 4) | value);
+    }
+    key = result;
+    return true;
+}
+
+std::string TorrentKey::to_hex() const
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        hex[i * 2] = digits[bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[bytes[i] & 0x0F];
+    }
+    return hex;
+}
+
+TorrentRegistry::TorrentRegistry()
+    : slots_(64, kEmpty)
+    , key_count_(0)
+{
+}
+
+const TorrentKey& TorrentRegistry::slot_key(std::uint32_t slot_value) const
+{
+    const TorrentInfo& info = entries_[slot_value & ~kAliasBit];
+    return (slot_value & kAliasBit) ? info.key_v2 : info.key;
+}
+
+size_t TorrentRegistry::find_slot(const TorrentKey& key) const
+{
+    if (key.empty()) {
+        return slots_.size();
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = key.hash() & mask; ; slot = (slot + 1) & mask) {
+        std::uint32_t value = slots_[slot];
+        if (value == kEmpty) {
+            return slots_.size();
+        }
+        if (slot_key(value) == key) {
+            return slot;
+        }
+    }
+}
+
+TorrentInfo* TorrentRegistry::find(const TorrentKey& key)
+{
+    size_t slot = find_slot(key);
+    return slot == slots_.size() ? nullptr : &entries_[slots_[slot] & ~kAliasBit];
+}
+
+const TorrentInfo* TorrentRegistry::find(const TorrentKey& key) const
+{
+    size_t slot = find_slot(key);
+    return slot == slots_.size() ? nullptr : &entries_[slots_[slot] & ~kAliasBit];
+}
+
+void TorrentRegistry::insert_slot(const TorrentKey& key, std::uint32_t slot_value)
+{
+    const size_t mask = slots_.size() - 1;
+    size_t slot = key.hash() & mask;
+    while (slots_[slot] != kEmpty) {
+        slot = (slot + 1) & mask;
+    }
+    slots_[slot] = slot_value;
+    ++key_count_;
+}
+
+void TorrentRegistry::erase_slot(size_t slot)
+{
+    const size_t mask = slots_.size() - 1;
+    slots_[slot] = kEmpty;
+    --key_count_;
+
+    // 后移删除：把探测序列中后面的键移到空出的位置，查找时遇到空槽即可停止
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots_[next] != kEmpty; next = (next + 1) & mask) {
+        size_t ideal = slot_key(slots_[next]).hash() & mask;
+        // ideal 不在 (hole, next] 区间内时，该键可以移到 hole
+        bool in_range = (hole < next) ? (ideal > hole && ideal <= next)
+                                      : (ideal > hole || ideal <= next);
+        if (!in_range) {
+            slots_[hole] = slots_[next];
+            slots_[next] = kEmpty;
+            hole = next;
+        }
+    }
+}
+
+void TorrentRegistry::relocate_slot(const TorrentKey& key, std::uint32_t new_value)
+{
+    size_t slot = find_slot(key);
+    if (slot != slots_.size()) {
+        slots_[slot] = new_value;
+    }
+}
+
+void TorrentRegistry::grow_if_needed(size_t extra_keys)
+{
+    if ((key_count_ + extra_keys) * 2 <= slots_.size()) {
+        return;
+    }
+    size_t capacity = slots_.size();
+    while ((key_count_ + extra_keys) * 2 > capacity) {
+        capacity *= 2;
+    }
+    slots_.assign(capacity, kEmpty);
+    key_count_ = 0;
+    for (std::uint32_t i = 0; i < entries_.size(); ++i) {
+        insert_slot(entries_[i].key, i);
+        if (!entries_[i].key_v2.empty()) {
+            insert_slot(entries_[i].key_v2, i | kAliasBit);
+        }
+    }
+}
+
+TorrentInfo& TorrentRegistry::insert(TorrentInfo info)
+{
+    if (info.key_v2 == info.key) {
+        info.key_v2 = TorrentKey();
+    }
+    erase(info.key);
+    if (!info.key_v2.empty()) {
+        erase(info.key_v2);
+    }
+
+    grow_if_needed(info.key_v2.empty() ? 1 : 2);
+
+    std::uint32_t index = static_cast<std::uint32_t>(entries_.size());
+    auto& type_set = by_type_[type_index(info.type)];
+    type_pos_.push_back(static_cast<std::uint32_t>(type_set.size()));
+    type_set.push_back(index);
+    entries_.push_back(std::move(info));
+
+    const TorrentInfo& stored = entries_.back();
+    insert_slot(stored.key, index);
+    if (!stored.key_v2.empty()) {
+        insert_slot(stored.key_v2, index | kAliasBit);
+    }
+    return entries_.back();
+}
+
+bool TorrentRegistry::erase(const TorrentKey& key)
+{
+    size_t slot = find_slot(key);
+    if (slot == slots_.size()) {
+        return false;
+    }
+    std::uint32_t index = slots_[slot] & ~kAliasBit;
+
+    // 删除该条目的所有键
+    TorrentKey primary = entries_[index].key;
+    TorrentKey alias = entries_[index].key_v2;
+    erase_slot(find_slot(primary));
+    if (!alias.empty()) {
+        erase_slot(find_slot(alias));
+    }
+
+    // 从类型索引中删除（与最后一个交换）
+    auto& type_set = by_type_[type_index(entries_[index].type)];
+    std::uint32_t pos = type_pos_[index];
+    std::uint32_t moved_in_type = type_set.back();
+    type_set[pos] = moved_in_type;
+    type_pos_[moved_in_type] = pos;
+    type_set.pop_back();
+
+    // 用最后一个条目填补空位，并更新指向它的槽和类型索引
+    std::uint32_t last = static_cast<std::uint32_t>(entries_.size() - 1);
+    if (index != last) {
+        entries_[index] = std::move(entries_[last]);
+        type_pos_[index] = type_pos_[last];
+        by_type_[type_index(entries_[index].type)][type_pos_[index]] = index;
+        relocate_slot(entries_[index].key, index);
+        if (!entries_[index].key_v2.empty()) {
+            relocate_slot(entries_[index].key_v2, index | kAliasBit);
+        }
+    }
+    entries_.pop_back();
+    type_pos_.pop_back();
+    return true;
+}
+
+void TorrentRegistry::clear()
+{
+    entries_.clear();
+    type_pos_.clear();
+    by_type_[0].clear();
+    by_type_[1].clear();
+    slots_.assign(64, kEmpty);
+    key_count_ = 0;
+}
@@ -0,0 +1,157 @@
+#ifndef TORRENT_REGISTRY_HPP
+#define TORRENT_REGISTRY_HPP
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_status.hpp>
+#include <libtorrent/info_hash.hpp>
+
+// Torrent 类型枚举
+enum class TorrentType {
+    Download,  // 下载
+    Seeding    // 做种
+};
+
+// 二进制 info hash 键（v1 为 20 字节 SHA1，v2 为 32 字节 SHA256）
+// 注册表内部只使用二进制键，十六进制字符串只在 API 边界转换
+struct TorrentKey {
+    std::array<std::uint8_t, 32> bytes;  // 哈希字节（未使用的部分为 0）
+    std::uint8_t size;                   // 有效字节数（0 表示空键）
+
+    TorrentKey() : bytes{}, size(0) {}
+
+    // 从 v1 / v2 哈希构造
+    static TorrentKey from_v1(const lt::sha1_hash& hash);
+    static TorrentKey from_v2(const lt::sha256_hash& hash);
+
+    // torrent 的主键：优先 v1 哈希，仅 v2 的 torrent 使用 v2 哈希
+    static TorrentKey primary(const lt::info_hash_t& hashes);
+
+    // 混合 torrent 的 v2 键（没有 v2 哈希时为空键）
+    static TorrentKey secondary(const lt::info_hash_t& hashes);
+
+    // 解析 40 或 64 个字符的十六进制字符串（不区分大小写）
+    // 返回: 是否解析成功
+    static bool from_hex(const std::string& hex, TorrentKey& key);
+
+    // 转换为小写十六进制字符串
+    std::string to_hex() const;
+
+    inline bool empty() const { return size == 0; }
+
+    // 哈希值：info hash 本身是均匀分布的，直接取前 8 个字节
+    inline std::uint64_t hash() const
+    {
+        std::uint64_t h;
+        std::memcpy(&h, bytes.data(), sizeof(h));
+        return h;
+    }
+
+    inline bool operator==(const TorrentKey& other) const
+    {
+        return size == other.size && std::memcmp(bytes.data(), other.bytes.data(), size) == 0;
+    }
+    inline bool operator!=(const TorrentKey& other) const { return !(*this == other); }
+};
+
+// TorrentKey 的哈希函数（用于 std::unordered_map）
+struct TorrentKeyHash {
+    inline size_t operator()(const TorrentKey& key) const { return static_cast<size_t>(key.hash()); }
+};
+
+// Torrent 信息结构体
+struct TorrentInfo {
+    lt::torrent_handle handle;      // torrent 句柄
+    TorrentType type;                // 类型（下载/做种）
+    std::string torrent_path;        // torrent 文件路径
+    std::string save_path;           // 保存路径
+    std::string info_hash;           // info hash（用于唯一标识，v1 或仅 v2 torrent 的 v2 哈希）
+    std::string info_hash_v2;        // v2 info hash（v1 torrent 为空）
+    TorrentKey key;                  // 注册表主键（info_hash 的二进制形式）
+    TorrentKey key_v2;               // 混合 torrent 的 v2 键（其他 torrent 为空）
+    bool is_valid;                   // 是否有效
+    lt::torrent_status status;       // 缓存的状态（由 state_update_alert 增量更新，查询时不访问 session）
+
+    TorrentInfo() : type(TorrentType::Download), is_valid(false) {}
+};
+
+// Torrent 注册表：以二进制 info hash 为键的开放寻址哈希表（线性探测，删除时后移，无墓碑）
+// 条目连续存放，遍历不经过空槽；混合 torrent 的 v1 和 v2 键指向同一条目
+// 按类型维护索引集合，查找、插入、删除和按类型计数都是 O(1)
+// 不是线程安全的，由 TorrentManager 的 mutex_ 保护
+class TorrentRegistry
+{
+public:
+    TorrentRegistry();
+
+    // 按键查找（主键或混合 torrent 的 v2 键），未找到返回 nullptr
+    TorrentInfo* find(const TorrentKey& key);
+    const TorrentInfo* find(const TorrentKey& key) const;
+
+    // 插入条目（以 info.key 和 info.key_v2 为键，已存在时替换）
+    // 返回: 注册表中的条目（下一次插入或删除前有效）
+    TorrentInfo& insert(TorrentInfo info);
+
+    // 删除条目（主键或 v2 键均可）
+    // 返回: 是否找到并删除
+    bool erase(const TorrentKey& key);
+
+    // 删除所有条目
+    void clear();
+
+    inline size_t size() const { return entries_.size(); }
+    inline bool empty() const { return entries_.empty(); }
+
+    // 指定类型的条目数量
+    inline size_t count(TorrentType type) const { return by_type_[type_index(type)].size(); }
+
+    // 遍历所有条目（遍历期间不能插入或删除）
+    inline std::vector<TorrentInfo>::iterator begin() { return entries_.begin(); }
+    inline std::vector<TorrentInfo>::iterator end() { return entries_.end(); }
+    inline std::vector<TorrentInfo>::const_iterator begin() const { return entries_.begin(); }
+    inline std::vector<TorrentInfo>::const_iterator end() const { return entries_.end(); }
+
+    // 指定类型的条目在遍历顺序中的下标（用于只处理下载或做种任务）
+    inline const std::vector<std::uint32_t>& indices(TorrentType type) const { return by_type_[type_index(type)]; }
+
+    // 按下标访问条目
+    inline TorrentInfo& at(std::uint32_t index) { return entries_[index]; }
+    inline const TorrentInfo& at(std::uint32_t index) const { return entries_[index]; }
+
+private:
+    static constexpr std::uint32_t kEmpty = 0xFFFFFFFFu;   // 空槽
+    static constexpr std::uint32_t kAliasBit = 0x80000000u; // 槽中保存的是条目的 v2 键
+
+    static inline size_t type_index(TorrentType type) { return type == TorrentType::Download ? 0 : 1; }
+
+    // 槽中保存的键
+    const TorrentKey& slot_key(std::uint32_t slot_value) const;
+
+    // 查找键所在的槽，未找到返回 slots_.size()
+    size_t find_slot(const TorrentKey& key) const;
+
+    // 插入键（键不存在时调用）
+    void insert_slot(const TorrentKey& key, std::uint32_t slot_value);
+
+    // 删除槽并后移后续条目，保持探测序列连续
+    void erase_slot(size_t slot);
+
+    // 条目移动到新下标后更新指向它的槽
+    void relocate_slot(const TorrentKey& key, std::uint32_t new_value);
+
+    // 负载因子超过 1/2 时扩容
+    void grow_if_needed(size_t extra_keys);
+
+private:
+    std::vector<TorrentInfo> entries_;             // 条目（连续存放）
+    std::vector<std::uint32_t> type_pos_;          // 每个条目在 by_type_ 中的位置
+    std::vector<std::uint32_t> by_type_[2];        // 按类型的条目下标集合（下载、做种）
+    std::vector<std::uint32_t> slots_;             // 哈希槽：条目下标（最高位表示 v2 键），kEmpty 为空
+    size_t key_count_;                             // 已使用的槽数量
+};
+
+#endif // TORRENT_REGISTRY_HPP
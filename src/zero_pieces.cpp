@@ -0,0 +1,155 @@
+#include "zero_pieces.hpp"
+#include "raw_file.hpp"
+#include "piece_hasher.hpp"
+#include "torrent_file_cache.hpp"
+#include <iostream>
+#include <filesystem>
+#include <map>
+
+// torrent 顶层字典中记录全零分片的键
+static const char* const zero_pieces_key = "x-zero-pieces";
+
+int ZeroPieceMap::write(lt::entry& torrent_entry, const std::vector<bool>& zero_pieces)
+{
+    lt::entry::list_type ranges;
+    int count = 0;
+    const int num_pieces = static_cast<int>(zero_pieces.size());
+    for (int p = 0; p < num_pieces; ) {
+        if (!zero_pieces[p]) {
+            ++p;
+            continue;
+        }
+        int end = p;
+        while (end < num_pieces && zero_pieces[end]) ++end;
+        lt::entry::list_type range;
+        range.push_back(lt::entry(static_cast<std::int64_t>(p)));
+        range.push_back(lt::entry(static_cast<std::int64_t>(end - p)));
+        ranges.push_back(lt::entry(std::move(range)));
+        count += end - p;
+        p = end;
+    }
+    if (count > 0) {
+        torrent_entry[zero_pieces_key] = std::move(ranges);
+    }
+    return count;
+}
+
+bool ZeroPieceMap::read(const lt::bdecode_node& torrent, int num_pieces, std::vector<bool>& zero_pieces)
+{
+    zero_pieces.assign(num_pieces, false);
+    if (torrent.type() != lt::bdecode_node::dict_t) {
+        return false;
+    }
+    lt::bdecode_node ranges = torrent.dict_find_list(zero_pieces_key);
+    if (!ranges) {
+        return false;
+    }
+    for (int i = 0; i < ranges.list_size(); ++i) {
+        lt::bdecode_node range = ranges.list_at(i);
+        if (range.type() != lt::bdecode_node::list_t || range.list_size() < 2) {
+            zero_pieces.assign(num_pieces, false);
+            return false;
+        }
+        std::int64_t first = range.list_int_value_at(0, -1);
+        std::int64_t count = range.list_int_value_at(1, -1);
+        if (first < 0 || count <= 0 || first + count > num_pieces) {
+            zero_pieces.assign(num_pieces, false);
+            return false;
+        }
+        for (std::int64_t p = first; p < first + count; ++p) {
+            zero_pieces[static_cast<size_t>(p)] = true;
+        }
+    }
+    return true;
+}
+
+int ZeroPieceMap::prepare_download(const std::string& torrent_path, const lt::torrent_info& ti,
+                                   const std::string& save_path, lt::add_torrent_params& params)
+{
+    namespace fs = std::filesystem;
+
+    // 全零分片表在解析 torrent 时已经读取并缓存，这里不重新读取文件
+    std::shared_ptr<const std::vector<bool>> cached = TorrentFileCache::load_zero_pieces(torrent_path);
+    if (!cached || static_cast<int>(cached->size()) != ti.num_pieces()) {
+        return 0;
+    }
+    std::vector<bool> zero_pieces = *cached;
+
+    // 该键不受 info hash 保护：只接受分片哈希确实等于全零数据哈希的条目，过期或被篡改的条目直接丢弃
+    const lt::file_storage& files = ti.files();
+    const bool use_v1 = ti.info_hashes().has_v1();
+    PieceHasher zero_hashes(files, save_path);
+    std::map<int, std::vector<lt::sha256_hash>> layers;
+    int dropped = 0;
+    for (int p = 0; p < ti.num_pieces(); ++p) {
+        if (!zero_pieces[p]) continue;
+        lt::piece_index_t piece(p);
+        bool valid = false;
+        if (use_v1) {
+            valid = ti.hash_for_piece(piece) == zero_hashes.zero_hash(piece);
+        } else {
+            // 仅 v2 的 torrent：与 piece layer 中的默克尔根比较
+            const lt::file_index_t file = files.file_index_at_piece(piece);
+            const int f = static_cast<int>(file);
+            auto layer = layers.find(f);
+            if (layer == layers.end()) {
+                layer = layers.emplace(f, PieceHasher::file_piece_roots(ti, file)).first;
+            }
+            const int k = p - static_cast<int>(files.piece_index_at_file(file));
+            valid = k < static_cast<int>(layer->second.size()) && layer->second[k] == zero_hashes.zero_piece_root(piece);
+        }
+        if (!valid) {
+            zero_pieces[p] = false;
+            ++dropped;
+        }
+    }
+    if (dropped > 0) {
+        std::cerr << "警告: 全零分片表中有 " << dropped << " 个分片的哈希与全零数据不一致，已忽略" << std::endl;
+    }
+
+    // 只为通过验证的全零分片涉及的、尚不存在的文件创建稀疏文件（libtorrent 只写入下载的数据，全零区域保持为空洞）
+    std::vector<char> needed(files.num_files(), 0);
+    for (int p = 0; p < ti.num_pieces(); ++p) {
+        if (!zero_pieces[p]) continue;
+        lt::piece_index_t piece(p);
+        for (const auto& slice : files.map_block(piece, 0, ti.piece_size(piece))) {
+            needed[static_cast<int>(slice.file_index)] = 1;
+        }
+    }
+    std::vector<char> created(files.num_files(), 0);
+    for (int f = 0; f < files.num_files(); ++f) {
+        lt::file_index_t index(f);
+        if (!needed[f] || files.pad_file_at(index)) continue;
+        std::string path = files.file_path(index, save_path);
+        std::error_code ec;
+        fs::path file_path = fs::u8path(path);
+        if (fs::exists(file_path, ec)) continue;
+        fs::create_directories(file_path.parent_path(), ec);
+        created[f] = RawFile::create_sparse(path, files.file_size(index)) ? 1 : 0;
+    }
+
+    // 只标记完全落在新建文件中的全零分片：新建的稀疏文件读取结果就是 0，与分片哈希一致
+    int marked = 0;
+    for (int p = 0; p < ti.num_pieces(); ++p) {
+        if (!zero_pieces[p]) continue;
+        lt::piece_index_t piece(p);
+        bool usable = true;
+        for (const auto& slice : files.map_block(piece, 0, ti.piece_size(piece))) {
+            if (!files.pad_file_at(slice.file_index) && !created[static_cast<int>(slice.file_index)]) {
+                usable = false;
+                break;
+            }
+        }
+        if (!usable) continue;
+        if (params.have_pieces.size() < ti.num_pieces()) {
+            params.have_pieces.resize(ti.num_pieces(), false);
+        }
+        params.have_pieces.set_bit(piece);
+        ++marked;
+    }
+
+    if (marked > 0) {
+        std::cout << "全零分片: " << marked << " 个已直接标记为完成（磁盘上保留为稀疏空洞，无需下载）" << std::endl;
+    }
+    return marked;
+}
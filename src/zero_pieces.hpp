@@ -0,0 +1,34 @@
+#ifndef ZERO_PIECES_HPP
+#define ZERO_PIECES_HPP
+
+#include <string>
+#include <vector>
+#include <libtorrent/entry.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/bdecode.hpp>
+
+// 全零分片表
+// 生成 torrent 时写入顶层字典的 "x-zero-pieces" 键（按连续区间 [起始分片, 数量] 记录）
+// 该键不属于 info 字典，不影响 info hash，其他客户端会忽略它
+// 下载时据此预先创建稀疏文件，并把全零分片直接标记为已拥有：这些分片不需要下载，磁盘上保持为空洞
+class ZeroPieceMap
+{
+public:
+    // 将全零分片写入 torrent 字典，没有全零分片时不写入
+    // 返回: 写入的全零分片数量
+    static int write(lt::entry& torrent_entry, const std::vector<bool>& zero_pieces);
+
+    // 从已解码的 torrent 顶层字典读取全零分片表，没有该键或格式错误时返回 false
+    // TorrentFileCache 在解析 torrent 时调用，结果与 torrent_info 一起缓存
+    static bool read(const lt::bdecode_node& torrent, int num_pieces, std::vector<bool>& zero_pieces);
+
+    // 下载前准备：全零分片表中的每个分片先与 torrent 中的分片哈希（v1 SHA1 或仅 v2 的 piece layer）核对，不一致的丢弃；
+    // 为通过核对的分片涉及的、尚不存在的文件创建稀疏文件，并将只落在这些新文件（或 pad 文件）中的分片标记为已拥有
+    // 已存在的文件不做任何假设，仍由 libtorrent 校验
+    // 返回: 标记为已拥有的分片数量
+    static int prepare_download(const std::string& torrent_path, const lt::torrent_info& ti,
+                                const std::string& save_path, lt::add_torrent_params& params);
+};
+
+#endif // ZERO_PIECES_HPP